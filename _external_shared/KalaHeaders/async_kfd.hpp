@@ -0,0 +1,322 @@
+//------------------------------------------------------------------------------
+// async_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Background I/O worker for streaming kfd glyph blocks without blocking the caller
+//   - Future and callback variants of StreamGlyphs
+//   - Request priorities so visible text is read before prefetched text
+//   - Cancellation of single requests or every pending request of a priority
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/import_kfd.hpp"
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::deque;
+	using std::mutex;
+	using std::condition_variable_any;
+	using std::future;
+	using std::promise;
+	using std::function;
+	using std::shared_ptr;
+	using std::make_shared;
+	using std::thread;
+	
+	using KalaHeaders::KalaThread::jthread;
+	using KalaHeaders::KalaThread::lockwait_m;
+	using KalaHeaders::KalaThread::unlock_m;
+	
+	using u64 = uint64_t;
+	
+	//Lower value is read first
+	enum class StreamPriority : u8
+	{
+		PRIORITY_VISIBLE  = 0, //Glyphs of text that is currently on screen
+		PRIORITY_PREFETCH = 1  //Glyphs that will probably be needed soon
+	};
+	
+	//How many priority queues the glyph streamer has
+	constexpr u8 STREAM_PRIORITY_COUNT = 2;
+	
+	//Returned by the future variant of StreamGlyphsAsync
+	struct StreamGlyphsResult
+	{
+		u64 requestID{};
+		ImportResult result{};
+		vector<GlyphBlock> blocks{};
+	};
+	
+	//Called from the I/O thread once a request has been read or cancelled
+	using StreamGlyphsCallback = function<void(StreamGlyphsResult&)>;
+	
+	//Owns one I/O thread that services StreamGlyphs requests in priority order.
+	//Callbacks run on the I/O thread so they should only hand the blocks over to the caller,
+	//cancelled requests are answered there too so a callback never runs inside Cancel
+	class GlyphStreamer
+	{
+	public:
+		GlyphStreamer()
+		{
+			worker = jthread([this]() { Run(); });
+		}
+		~GlyphStreamer()
+		{
+			lockwait_m(queueMutex);
+			isRunning = false;
+			unlock_m(queueMutex);
+			
+			//the I/O thread answers anything still queued as cancelled
+			//before it exits so no future is left hanging
+			
+			queueCondition.notify_all();
+			if (worker.joinable()) worker.join();
+		}
+		
+		GlyphStreamer(const GlyphStreamer&) = delete;
+		GlyphStreamer& operator=(const GlyphStreamer&) = delete;
+		
+		//Queues a StreamGlyphs request and calls the callback on the I/O thread when it is done,
+		//returns the id that can be passed to Cancel
+		u64 StreamGlyphsAsync(
+			const path& inFile,
+			const vector<GlyphTable>& inTables,
+			StreamPriority priority,
+			StreamGlyphsCallback callback,
+			bool skipChecks = false)
+		{
+			Request r
+			{
+				.file = inFile,
+				.tables = inTables,
+				.skipChecks = skipChecks,
+				.callback = move(callback)
+			};
+			
+			return Push(move(r), priority);
+		}
+		
+		//Queues a StreamGlyphs request and returns a future that is ready when it is done,
+		//the request id is stored in outRequestID if it needs to be cancelled later
+		future<StreamGlyphsResult> StreamGlyphsAsync(
+			const path& inFile,
+			const vector<GlyphTable>& inTables,
+			StreamPriority priority,
+			u64* outRequestID = nullptr,
+			bool skipChecks = false)
+		{
+			Request r
+			{
+				.file = inFile,
+				.tables = inTables,
+				.skipChecks = skipChecks,
+				.resultPromise = make_shared<promise<StreamGlyphsResult>>()
+			};
+			
+			future<StreamGlyphsResult> f = r.resultPromise->get_future();
+			
+			u64 id = Push(move(r), priority);
+			if (outRequestID) *outRequestID = id;
+			
+			return f;
+		}
+		
+		//Cancels a request that has not been read yet, its callback or future gets
+		//RESULT_CANCELLED from the I/O thread ahead of any queued read.
+		//Returns false if it was already read, is currently being read or never existed
+		bool Cancel(u64 requestID)
+		{
+			lockwait_m(queueMutex);
+			
+			for (auto& queue : queues)
+			{
+				for (auto it = queue.begin(); it != queue.end(); ++it)
+				{
+					if (it->id != requestID) continue;
+					
+					cancelled.push_back(move(*it));
+					queue.erase(it);
+					unlock_m(queueMutex);
+					
+					queueCondition.notify_one();
+					return true;
+				}
+			}
+			
+			unlock_m(queueMutex);
+			return false;
+		}
+		
+		//Cancels every request of this priority that has not been read yet like Cancel,
+		//returns how many requests were cancelled
+		size_t CancelAll(StreamPriority priority)
+		{
+			lockwait_m(queueMutex);
+			
+			deque<Request>& queue = queues[scast<u8>(priority)];
+			size_t count = queue.size();
+			
+			for (auto& r : queue) cancelled.push_back(move(r));
+			queue.clear();
+			
+			unlock_m(queueMutex);
+			
+			if (count > 0) queueCondition.notify_one();
+			
+			return count;
+		}
+		
+		//Returns how many requests are waiting to be read
+		size_t GetPendingCount()
+		{
+			lockwait_m(queueMutex);
+			
+			size_t count{};
+			for (const auto& queue : queues) count += queue.size();
+			
+			unlock_m(queueMutex);
+			
+			return count;
+		}
+	private:
+		struct Request
+		{
+			u64 id{};
+			path file{};
+			vector<GlyphTable> tables{};
+			bool skipChecks{};
+			StreamGlyphsCallback callback{};
+			shared_ptr<promise<StreamGlyphsResult>> resultPromise{};
+		};
+		
+		u64 Push(
+			Request&& r,
+			StreamPriority priority)
+		{
+			lockwait_m(queueMutex);
+			
+			r.id = ++lastRequestID;
+			u64 id = r.id;
+			
+			queues[scast<u8>(priority)].push_back(move(r));
+			
+			unlock_m(queueMutex);
+			
+			queueCondition.notify_one();
+			
+			return id;
+		}
+		
+		static void Finish(
+			Request& r,
+			ImportResult result,
+			vector<GlyphBlock>&& blocks)
+		{
+			StreamGlyphsResult out
+			{
+				.requestID = r.id,
+				.result = result,
+				.blocks = move(blocks)
+			};
+			
+			if (r.callback) r.callback(out);
+			if (r.resultPromise) r.resultPromise->set_value(move(out));
+		}
+		
+		void Run()
+		{
+			while (true)
+			{
+				lockwait_m(queueMutex);
+				
+				queueCondition.wait(
+					queueMutex,
+					[this]()
+					{
+						if (!isRunning || !cancelled.empty()) return true;
+						for (const auto& queue : queues) if (!queue.empty()) return true;
+						return false;
+					});
+				
+				//cancelled requests are answered first, on shutdown every queued request joins them
+				
+				if (!isRunning)
+				{
+					for (auto& queue : queues)
+					{
+						for (auto& r : queue) cancelled.push_back(move(r));
+						queue.clear();
+					}
+				}
+				
+				if (!cancelled.empty())
+				{
+					deque<Request> stale = move(cancelled);
+					cancelled.clear();
+					
+					bool isStopping = !isRunning;
+					unlock_m(queueMutex);
+					
+					for (auto& r : stale) Finish(r, ImportResult::RESULT_CANCELLED, {});
+					
+					if (isStopping) return;
+					continue;
+				}
+				
+				if (!isRunning)
+				{
+					unlock_m(queueMutex);
+					return;
+				}
+				
+				//always take the highest priority request first
+				
+				Request r{};
+				for (auto& queue : queues)
+				{
+					if (queue.empty()) continue;
+					
+					r = move(queue.front());
+					queue.pop_front();
+					break;
+				}
+				
+				unlock_m(queueMutex);
+				
+				vector<GlyphBlock> blocks{};
+				ImportResult result = StreamGlyphs(
+					r.file,
+					r.tables,
+					blocks,
+					r.skipChecks);
+				
+				Finish(r, result, move(blocks));
+			}
+		}
+		
+		mutex queueMutex{};
+		condition_variable_any queueCondition{};
+		deque<Request> queues[STREAM_PRIORITY_COUNT]{};
+		deque<Request> cancelled{}; //removed from queues, waiting for the I/O thread to answer them
+		u64 lastRequestID{};
+		bool isRunning = true;
+		
+		thread worker{};
+	};
+}
\ No newline at end of file
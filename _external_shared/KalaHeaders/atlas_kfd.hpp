@@ -0,0 +1,859 @@
+//------------------------------------------------------------------------------
+// atlas_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Dynamic glyph atlas for fonts with more glyphs than fit in one texture
+//   - On demand glyph streaming from glyph and instance kfd files through import_kfd.hpp
+//   - Shelf allocation with per-shelf free spans and least recently used eviction
+//   - Batched dirty rectangles so the texture is updated once per frame
+//   - Occupancy, hit rate and churn counters
+//------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+
+# Atlas layout
+
+The atlas is one 8-bit texture kept in a CPU buffer, the caller uploads the dirty
+rectangles into its own GPU texture, so the atlas works the same without a GPU.
+
+Glyphs are placed on horizontal shelves. Each glyph takes its size plus the padding
+on its right and bottom side, and the first shelf and first column start after the
+padding, so every glyph has empty texels around it for bilinear sampling.
+A glyph goes to the lowest shelf that is tall enough without wasting more than half
+of the glyph height, then to a new shelf at the top of the used area, then to a
+split of an empty shelf. When nothing fits the least recently used glyphs are
+evicted until it does, glyphs that were used in the current frame are never evicted.
+
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+
+#include "KalaHeaders/import_kfd.hpp"
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::unordered_map;
+	using std::sort;
+	using std::unique;
+	using std::lower_bound;
+	using std::min;
+	using std::max;
+	using std::memcpy;
+	using std::memset;
+	using std::filesystem::path;
+	
+	using f64 = double;
+	
+	//Default width and height of a GlyphAtlas in texels
+	constexpr u16 ATLAS_DEFAULT_SIZE = 1024u;
+	
+	//New shelf heights are rounded up to this many texels so glyphs
+	//of close sizes can share shelves
+	constexpr u16 ATLAS_SHELF_ROUNDING = 4u;
+	
+	//One rectangle of the atlas texture in texels
+	struct AtlasRect
+	{
+		u16 x{};
+		u16 y{};
+		u16 width{};
+		u16 height{};
+	};
+	
+	//Occupancy and churn counters of a GlyphAtlas
+	struct AtlasStats
+	{
+		u64 hits{};               //requested glyphs that were already resident
+		u64 misses{};             //requested glyphs that had to be streamed and placed
+		u64 evictions{};          //glyphs dropped to make room for other glyphs
+		u64 failedPlacements{};   //glyphs that did not fit even after evicting every unused glyph
+		u64 unknownCodes{};       //requested char codes the opened kfd does not have
+		u64 uploadedBytes{};      //texels in the dirty rectangles taken with ClearDirty
+		
+		u32 residentGlyphs{};     //glyphs currently in the atlas
+		u32 shelfCount{};         //shelves currently in the atlas
+		u64 usedTexels{};         //texels taken by resident glyphs and their padding
+		u64 totalTexels{};        //texels of the whole atlas
+		
+		u32 frameInserts{};       //glyphs placed since the last BeginFrame
+		u32 frameEvictions{};     //glyphs evicted since the last BeginFrame
+		u32 lastFrameInserts{};   //glyphs placed in the previous frame
+		u32 lastFrameEvictions{}; //glyphs evicted in the previous frame
+		
+		f64 GetOccupancy() const
+		{
+			return totalTexels == 0
+				? 0.0
+				: scast<f64>(usedTexels) / scast<f64>(totalTexels);
+		}
+		f64 GetHitRate() const
+		{
+			u64 total = hits + misses;
+			return total == 0
+				? 0.0
+				: scast<f64>(hits) / scast<f64>(total);
+		}
+	};
+	
+	//Keeps the recently used glyphs of one kfd in a single texture and streams the rest
+	//on demand. Returned instances use atlasPage 0 and stay valid until a glyph that was
+	//not used in the current frame is evicted, so request every glyph of a frame after BeginFrame.
+	//Not thread safe, use one atlas per thread
+	class GlyphAtlas
+	{
+	public:
+		explicit GlyphAtlas(
+			u16 width = ATLAS_DEFAULT_SIZE,
+			u16 height = ATLAS_DEFAULT_SIZE,
+			u16 padding = KFD_ATLAS_PADDING)
+			: atlasWidth(width),
+			atlasHeight(height),
+			padding(padding)
+		{
+			pixels.assign(scast<size_t>(width) * height, 0);
+			Clear();
+		}
+		
+		//Opens a glyph or instance kfd to stream glyphs from and clears the atlas.
+		//Bitmap kfd files are rejected because all their glyphs share one block
+		ImportResult Open(const path& inFile)
+		{
+			GlyphHeader header{};
+			ImportResult headerResult = GetHeaderData(inFile, header);
+			if (headerResult != ImportResult::RESULT_SUCCESS) return headerResult;
+			
+			if (header.type == 1) return ImportResult::RESULT_INVALID_TYPE;
+			
+			vector<GlyphTable> newTables{};
+			ImportResult tableResult = GetTableData(inFile, newTables, true);
+			if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
+			
+			kfdFile = inFile;
+			tables.swap(newTables);
+			
+			tableIndex.clear();
+			tableIndex.reserve(tables.size());
+			for (u32 i = 0; i < tables.size(); ++i)
+			{
+				tableIndex[tables[i].charCode] = i;
+			}
+			
+			Clear();
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Starts a new frame, glyphs used in the previous frame can be evicted again
+		void BeginFrame()
+		{
+			++frame;
+			
+			stats.lastFrameInserts = stats.frameInserts;
+			stats.lastFrameEvictions = stats.frameEvictions;
+			stats.frameInserts = 0;
+			stats.frameEvictions = 0;
+		}
+		
+		//Writes one instance per char code into outInstances. Resident glyphs are answered
+		//from the atlas, missing glyphs are streamed from the opened kfd in one batched read
+		//and placed. Unknown char codes get an empty instance, glyphs that do not fit keep
+		//their offsets and advance but get a zero size so the pen still moves past them
+		ImportResult Request(
+			const u32* charCodes,
+			size_t count,
+			GlyphInstance* outInstances)
+		{
+			missingCodes.clear();
+			
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (Touch(charCodes[i]) == ATLAS_NO_ENTRY)
+				{
+					missingCodes.push_back(charCodes[i]);
+				}
+				else ++stats.hits;
+			}
+			
+			unplaced.clear();
+			
+			if (!missingCodes.empty())
+			{
+				sort(missingCodes.begin(), missingCodes.end());
+				missingCodes.erase(
+					unique(missingCodes.begin(), missingCodes.end()),
+					missingCodes.end());
+				
+				missingTables.clear();
+				for (u32 code : missingCodes)
+				{
+					auto found = tableIndex.find(code);
+					if (found == tableIndex.end())
+					{
+						++stats.unknownCodes;
+						continue;
+					}
+					
+					missingTables.push_back(tables[found->second]);
+				}
+				
+				if (!missingTables.empty())
+				{
+					ImportResult streamResult = StreamGlyphs(
+						kfdFile,
+						missingTables,
+						missingBlocks,
+						true);
+					
+					if (streamResult != ImportResult::RESULT_SUCCESS) return streamResult;
+					
+					for (const auto& block : missingBlocks)
+					{
+						++stats.misses;
+						
+						GlyphInstance instance{};
+						if (!Insert(block, instance)) unplaced[block.charCode] = instance;
+					}
+				}
+			}
+			
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto found = resident.find(charCodes[i]);
+				if (found != resident.end())
+				{
+					outInstances[i] = entries[found->second].instance;
+					continue;
+				}
+				
+				auto failed = unplaced.find(charCodes[i]);
+				outInstances[i] = failed != unplaced.end()
+					? failed->second
+					: GlyphInstance{};
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Places one glyph that was already read and marks it as used in the current frame,
+		//a glyph that is already resident is only touched. Returns false if the glyph does not
+		//fit even after evicting every glyph that was not used in the current frame
+		bool Insert(
+			const GlyphBlock& block,
+			GlyphInstance& outInstance)
+		{
+			u32 existing = Touch(block.charCode);
+			if (existing != ATLAS_NO_ENTRY)
+			{
+				outInstance = entries[existing].instance;
+				return true;
+			}
+			
+			outInstance = GlyphInstance
+			{
+				.offsetX = block.bearingX,
+				.offsetY = block.bearingY,
+				.width = 0,
+				.height = 0,
+				.atlasX = 0,
+				.atlasY = 0,
+				.atlasPage = 0,
+				.advance = block.advance
+			};
+			
+			//empty glyphs such as spaces take no texels and are never evicted
+			
+			u32 stride = GetRowStride(block);
+			
+			bool isEmpty =
+				block.width == 0
+				|| stride == 0
+				|| block.rawPixels.size() < scast<size_t>(stride) * block.height;
+			
+			if (isEmpty)
+			{
+				AddEntry(block.charCode, outInstance, 0, false);
+				return true;
+			}
+			
+			u32 slotWidth = scast<u32>(block.width) + padding;
+			u32 slotHeight = scast<u32>(block.height) + padding;
+			
+			AtlasRect slot{};
+			while (!Allocate(slotWidth, slotHeight, slot))
+			{
+				if (!EvictOldest())
+				{
+					++stats.failedPlacements;
+					outInstance.width = 0;
+					outInstance.height = 0;
+					return false;
+				}
+			}
+			
+			//clear the whole slot so the padding of the old glyph does not bleed in
+			
+			for (u32 y = 0; y < slotHeight; ++y)
+			{
+				u8* row = pixels.data() + (scast<size_t>(slot.y) + y) * atlasWidth + slot.x;
+				
+				if (y < block.height)
+				{
+					memcpy(row, block.rawPixels.data() + scast<size_t>(y) * stride, block.width);
+					memset(row + block.width, 0, padding);
+				}
+				else memset(row, 0, slotWidth);
+			}
+			
+			MarkDirty(AtlasRect
+			{
+				.x = slot.x,
+				.y = slot.y,
+				.width = scast<u16>(slotWidth),
+				.height = scast<u16>(slotHeight)
+			});
+			
+			outInstance.width = block.width;
+			outInstance.height = block.height;
+			outInstance.atlasX = slot.x;
+			outInstance.atlasY = slot.y;
+			
+			AddEntry(block.charCode, outInstance, scast<u16>(slotWidth), true);
+			
+			stats.usedTexels += scast<u64>(slotWidth) * slotHeight;
+			++stats.frameInserts;
+			
+			return true;
+		}
+		
+		//Returns true and the instance of a resident glyph without touching it
+		bool Find(
+			u32 charCode,
+			GlyphInstance& outInstance) const
+		{
+			auto found = resident.find(charCode);
+			if (found == resident.end()) return false;
+			
+			outInstance = entries[found->second].instance;
+			return true;
+		}
+		
+		//Drops every glyph and marks the whole atlas dirty, the counters are kept
+		void Clear()
+		{
+			entries.clear();
+			freeEntries.clear();
+			resident.clear();
+			shelves.clear();
+			
+			newest = ATLAS_NO_ENTRY;
+			oldest = ATLAS_NO_ENTRY;
+			shelfTop = padding;
+			
+			std::fill(pixels.begin(), pixels.end(), 0);
+			
+			dirtyRects.clear();
+			dirtyRects.push_back(AtlasRect
+			{
+				.x = 0,
+				.y = 0,
+				.width = atlasWidth,
+				.height = atlasHeight
+			});
+			
+			stats.residentGlyphs = 0;
+			stats.shelfCount = 0;
+			stats.usedTexels = 0;
+			stats.totalTexels = scast<u64>(atlasWidth) * atlasHeight;
+		}
+		
+		//Rectangles changed since the last ClearDirty, at most one per shelf
+		//so the texture can be updated with a few uploads per frame
+		const vector<AtlasRect>& GetDirtyRects() const { return dirtyRects; }
+		
+		//One rectangle around every dirty rectangle for a single upload
+		AtlasRect GetDirtyBounds() const
+		{
+			if (dirtyRects.empty()) return AtlasRect{};
+			
+			u32 x0 = atlasWidth;
+			u32 y0 = atlasHeight;
+			u32 x1{};
+			u32 y1{};
+			
+			for (const auto& r : dirtyRects)
+			{
+				x0 = min<u32>(x0, r.x);
+				y0 = min<u32>(y0, r.y);
+				x1 = max<u32>(x1, scast<u32>(r.x) + r.width);
+				y1 = max<u32>(y1, scast<u32>(r.y) + r.height);
+			}
+			
+			return AtlasRect
+			{
+				.x = scast<u16>(x0),
+				.y = scast<u16>(y0),
+				.width = scast<u16>(x1 - x0),
+				.height = scast<u16>(y1 - y0)
+			};
+		}
+		
+		bool HasDirty() const { return !dirtyRects.empty(); }
+		
+		//Call after the dirty rectangles were uploaded
+		void ClearDirty()
+		{
+			for (const auto& r : dirtyRects)
+			{
+				stats.uploadedBytes += scast<u64>(r.width) * r.height;
+			}
+			dirtyRects.clear();
+		}
+		
+		//8-bit atlas texels, row by row with a stride of GetWidth
+		const vector<u8>& GetPixels() const { return pixels; }
+		u16 GetWidth() const { return atlasWidth; }
+		u16 GetHeight() const { return atlasHeight; }
+		
+		const AtlasStats& GetStats() const { return stats; }
+		void ResetStats()
+		{
+			stats.hits = 0;
+			stats.misses = 0;
+			stats.evictions = 0;
+			stats.failedPlacements = 0;
+			stats.unknownCodes = 0;
+			stats.uploadedBytes = 0;
+		}
+	private:
+		static constexpr u32 ATLAS_NO_ENTRY = UINT32_MAX;
+		
+		struct Entry
+		{
+			u32 charCode{};
+			GlyphInstance instance{};
+			u16 slotWidth{};   //glyph width with padding, 0 for empty glyphs
+			bool isEvictable{};
+			u64 lastFrame{};
+			u32 newer = ATLAS_NO_ENTRY;
+			u32 older = ATLAS_NO_ENTRY;
+		};
+		
+		//Free x ranges of one shelf, sorted by x
+		struct FreeSpan
+		{
+			u16 x{};
+			u16 width{};
+		};
+		
+		struct Shelf
+		{
+			u16 y{};
+			u16 height{};
+			u32 glyphCount{};
+			vector<FreeSpan> freeSpans{};
+		};
+		
+		//Marks a resident glyph as used in the current frame,
+		//returns its entry or ATLAS_NO_ENTRY if it is not resident
+		u32 Touch(u32 charCode)
+		{
+			auto found = resident.find(charCode);
+			if (found == resident.end()) return ATLAS_NO_ENTRY;
+			
+			u32 e = found->second;
+			entries[e].lastFrame = frame;
+			
+			if (entries[e].isEvictable
+				&& newest != e)
+			{
+				Unlink(e);
+				LinkNewest(e);
+			}
+			
+			return e;
+		}
+		
+		void AddEntry(
+			u32 charCode,
+			const GlyphInstance& instance,
+			u16 slotWidth,
+			bool isEvictable)
+		{
+			u32 e{};
+			if (!freeEntries.empty())
+			{
+				e = freeEntries.back();
+				freeEntries.pop_back();
+			}
+			else
+			{
+				e = scast<u32>(entries.size());
+				entries.emplace_back();
+			}
+			
+			entries[e] = Entry
+			{
+				.charCode = charCode,
+				.instance = instance,
+				.slotWidth = slotWidth,
+				.isEvictable = isEvictable,
+				.lastFrame = frame
+			};
+			
+			if (isEvictable) LinkNewest(e);
+			
+			resident[charCode] = e;
+			stats.residentGlyphs = scast<u32>(resident.size());
+		}
+		
+		void LinkNewest(u32 e)
+		{
+			entries[e].older = newest;
+			entries[e].newer = ATLAS_NO_ENTRY;
+			
+			if (newest != ATLAS_NO_ENTRY) entries[newest].newer = e;
+			newest = e;
+			
+			if (oldest == ATLAS_NO_ENTRY) oldest = e;
+		}
+		
+		void Unlink(u32 e)
+		{
+			Entry& entry = entries[e];
+			
+			if (entry.newer != ATLAS_NO_ENTRY) entries[entry.newer].older = entry.older;
+			else newest = entry.older;
+			
+			if (entry.older != ATLAS_NO_ENTRY) entries[entry.older].newer = entry.newer;
+			else oldest = entry.newer;
+			
+			entry.newer = ATLAS_NO_ENTRY;
+			entry.older = ATLAS_NO_ENTRY;
+		}
+		
+		//Evicts the least recently used glyph unless it was used in the current frame
+		bool EvictOldest()
+		{
+			if (oldest == ATLAS_NO_ENTRY
+				|| entries[oldest].lastFrame == frame)
+			{
+				return false;
+			}
+			
+			u32 e = oldest;
+			Entry& entry = entries[e];
+			
+			Unlink(e);
+			
+			//freed texels are cleared so glyphs placed next to them keep empty edges
+			
+			u32 slotHeight = scast<u32>(entry.instance.height) + padding;
+			for (u32 y = 0; y < slotHeight; ++y)
+			{
+				memset(
+					pixels.data() + (scast<size_t>(entry.instance.atlasY) + y) * atlasWidth + entry.instance.atlasX,
+					0,
+					entry.slotWidth);
+			}
+			
+			MarkDirty(AtlasRect
+			{
+				.x = entry.instance.atlasX,
+				.y = entry.instance.atlasY,
+				.width = entry.slotWidth,
+				.height = scast<u16>(slotHeight)
+			});
+			
+			Release(entry.instance.atlasX, entry.instance.atlasY, entry.slotWidth);
+			stats.usedTexels -= scast<u64>(entry.slotWidth) * slotHeight;
+			
+			resident.erase(entry.charCode);
+			freeEntries.push_back(e);
+			
+			stats.residentGlyphs = scast<u32>(resident.size());
+			++stats.evictions;
+			++stats.frameEvictions;
+			
+			return true;
+		}
+		
+		//Finds room for a slot, see the atlas layout notes at the top of this file
+		bool Allocate(
+			u32 slotWidth,
+			u32 slotHeight,
+			AtlasRect& outSlot)
+		{
+			if (slotWidth + padding > atlasWidth
+				|| slotHeight + padding > atlasHeight)
+			{
+				return false;
+			}
+			
+			//lowest existing shelf that does not waste more than half of the glyph height
+			
+			u32 maxHeight = slotHeight + slotHeight / 2;
+			
+			size_t bestShelf = shelves.size();
+			size_t bestSpan{};
+			for (size_t s = 0; s < shelves.size(); ++s)
+			{
+				const Shelf& shelf = shelves[s];
+				if (shelf.height < slotHeight
+					|| shelf.height > maxHeight
+					|| (bestShelf != shelves.size() && shelf.height >= shelves[bestShelf].height))
+				{
+					continue;
+				}
+				
+				for (size_t f = 0; f < shelf.freeSpans.size(); ++f)
+				{
+					if (shelf.freeSpans[f].width >= slotWidth)
+					{
+						bestShelf = s;
+						bestSpan = f;
+						break;
+					}
+				}
+			}
+			
+			if (bestShelf == shelves.size())
+			{
+				//new shelf on top of the used area
+				
+				u32 shelfHeight = RoundShelfHeight(slotHeight);
+				
+				if (shelfTop + shelfHeight <= atlasHeight)
+				{
+					shelves.push_back(NewShelf(scast<u16>(shelfTop), scast<u16>(shelfHeight)));
+					shelfTop += shelfHeight;
+					bestShelf = shelves.size() - 1;
+				}
+				else bestShelf = SplitEmptyShelf(slotHeight);
+				
+				if (bestShelf == shelves.size()) return false;
+				bestSpan = 0;
+			}
+			
+			Shelf& shelf = shelves[bestShelf];
+			FreeSpan& span = shelf.freeSpans[bestSpan];
+			
+			outSlot = AtlasRect
+			{
+				.x = span.x,
+				.y = shelf.y,
+				.width = scast<u16>(slotWidth),
+				.height = scast<u16>(slotHeight)
+			};
+			
+			span.x = scast<u16>(span.x + slotWidth);
+			span.width = scast<u16>(span.width - slotWidth);
+			if (span.width == 0) shelf.freeSpans.erase(shelf.freeSpans.begin() + bestSpan);
+			
+			++shelf.glyphCount;
+			stats.shelfCount = scast<u32>(shelves.size());
+			
+			return true;
+		}
+		
+		//Takes the smallest empty shelf that is tall enough and splits off the height it does not need,
+		//returns shelves.size() if there is none
+		size_t SplitEmptyShelf(u32 slotHeight)
+		{
+			size_t best = shelves.size();
+			for (size_t s = 0; s < shelves.size(); ++s)
+			{
+				if (shelves[s].glyphCount == 0
+					&& shelves[s].height >= slotHeight
+					&& (best == shelves.size() || shelves[s].height < shelves[best].height))
+				{
+					best = s;
+				}
+			}
+			
+			if (best == shelves.size()) return best;
+			
+			u32 shelfHeight = min<u32>(RoundShelfHeight(slotHeight), shelves[best].height);
+			u32 restHeight = shelves[best].height - shelfHeight;
+			
+			shelves[best].height = scast<u16>(shelfHeight);
+			
+			if (restHeight > 0)
+			{
+				shelves.insert(
+					shelves.begin() + best + 1,
+					NewShelf(scast<u16>(shelves[best].y + shelfHeight), scast<u16>(restHeight)));
+			}
+			
+			return best;
+		}
+		
+		//Returns a slot to its shelf, empty shelves are merged with their empty
+		//neighbours and the empty shelves on top of the used area are dropped
+		void Release(
+			u16 x,
+			u16 y,
+			u16 slotWidth)
+		{
+			auto it = lower_bound(
+				shelves.begin(),
+				shelves.end(),
+				y,
+				[](const Shelf& shelf, u16 value) { return shelf.y < value; });
+			
+			size_t s = scast<size_t>(it - shelves.begin());
+			Shelf& shelf = shelves[s];
+			
+			//insert the span in x order and merge it with the spans it touches
+			
+			auto spanIt = lower_bound(
+				shelf.freeSpans.begin(),
+				shelf.freeSpans.end(),
+				x,
+				[](const FreeSpan& span, u16 value) { return span.x < value; });
+			
+			size_t f = scast<size_t>(spanIt - shelf.freeSpans.begin());
+			shelf.freeSpans.insert(spanIt, FreeSpan{ .x = x, .width = slotWidth });
+			
+			if (f + 1 < shelf.freeSpans.size()
+				&& shelf.freeSpans[f].x + shelf.freeSpans[f].width == shelf.freeSpans[f + 1].x)
+			{
+				shelf.freeSpans[f].width = scast<u16>(shelf.freeSpans[f].width + shelf.freeSpans[f + 1].width);
+				shelf.freeSpans.erase(shelf.freeSpans.begin() + f + 1);
+			}
+			if (f > 0
+				&& shelf.freeSpans[f - 1].x + shelf.freeSpans[f - 1].width == shelf.freeSpans[f].x)
+			{
+				shelf.freeSpans[f - 1].width = scast<u16>(shelf.freeSpans[f - 1].width + shelf.freeSpans[f].width);
+				shelf.freeSpans.erase(shelf.freeSpans.begin() + f);
+			}
+			
+			if (--shelf.glyphCount > 0) return;
+			
+			if (s + 1 < shelves.size()
+				&& shelves[s + 1].glyphCount == 0)
+			{
+				shelf.height = scast<u16>(shelf.height + shelves[s + 1].height);
+				shelves.erase(shelves.begin() + s + 1);
+			}
+			if (s > 0
+				&& shelves[s - 1].glyphCount == 0)
+			{
+				shelves[s - 1].height = scast<u16>(shelves[s - 1].height + shelves[s].height);
+				shelves.erase(shelves.begin() + s);
+			}
+			
+			while (!shelves.empty()
+				&& shelves.back().glyphCount == 0)
+			{
+				shelfTop = shelves.back().y;
+				shelves.pop_back();
+			}
+			
+			stats.shelfCount = scast<u32>(shelves.size());
+		}
+		
+		Shelf NewShelf(
+			u16 y,
+			u16 height) const
+		{
+			Shelf shelf
+			{
+				.y = y,
+				.height = height
+			};
+			shelf.freeSpans.push_back(FreeSpan
+			{
+				.x = padding,
+				.width = scast<u16>(atlasWidth - padding)
+			});
+			
+			return shelf;
+		}
+		
+		u32 RoundShelfHeight(u32 slotHeight) const
+		{
+			u32 rounded = (slotHeight + ATLAS_SHELF_ROUNDING - 1) / ATLAS_SHELF_ROUNDING * ATLAS_SHELF_ROUNDING;
+			return min<u32>(rounded, atlasHeight - padding);
+		}
+		
+		//Grows the dirty rectangle of the same shelf row or adds a new one
+		void MarkDirty(const AtlasRect& rect)
+		{
+			for (auto& r : dirtyRects)
+			{
+				if (r.y != rect.y
+					|| r.height != rect.height)
+				{
+					continue;
+				}
+				
+				u32 x0 = min<u32>(r.x, rect.x);
+				u32 x1 = max<u32>(scast<u32>(r.x) + r.width, scast<u32>(rect.x) + rect.width);
+				
+				r.x = scast<u16>(x0);
+				r.width = scast<u16>(x1 - x0);
+				return;
+			}
+			
+			//glyphs of different heights on one shelf share the shelf row
+			
+			for (auto& r : dirtyRects)
+			{
+				if (rect.y >= r.y
+					&& scast<u32>(rect.y) + rect.height <= scast<u32>(r.y) + r.height)
+				{
+					u32 x0 = min<u32>(r.x, rect.x);
+					u32 x1 = max<u32>(scast<u32>(r.x) + r.width, scast<u32>(rect.x) + rect.width);
+					
+					r.x = scast<u16>(x0);
+					r.width = scast<u16>(x1 - x0);
+					return;
+				}
+			}
+			
+			dirtyRects.push_back(rect);
+		}
+		
+		u16 atlasWidth{};
+		u16 atlasHeight{};
+		u16 padding{};
+		
+		vector<u8> pixels{};
+		
+		path kfdFile{};
+		vector<GlyphTable> tables{};
+		unordered_map<u32, u32> tableIndex{}; //char code to tables index
+		
+		vector<Entry> entries{};
+		vector<u32> freeEntries{};
+		unordered_map<u32, u32> resident{};   //char code to entries index
+		u32 newest = ATLAS_NO_ENTRY;
+		u32 oldest = ATLAS_NO_ENTRY;
+		u64 frame{};
+		
+		vector<Shelf> shelves{};              //sorted by y
+		u32 shelfTop{};                       //first row above every shelf
+		
+		vector<AtlasRect> dirtyRects{};
+		
+		//Request scratch
+		vector<u32> missingCodes{};
+		vector<GlyphTable> missingTables{};
+		vector<GlyphBlock> missingBlocks{};
+		unordered_map<u32, GlyphInstance> unplaced{};
+		
+		AtlasStats stats{};
+	};
+}
\ No newline at end of file
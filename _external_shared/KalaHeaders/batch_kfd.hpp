@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+// batch_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Multi-threaded layout of many independent strings with layout_kfd.hpp
+//   - Work stealing over chunks of jobs through WorkPool from thread_utils.hpp
+//   - Per-thread vertex arenas gathered into one contiguous output with per-job offsets
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <memory>
+#include <cstring>
+
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/layout_kfd.hpp"
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::string_view;
+	using std::unique_ptr;
+	using std::make_unique;
+	using std::max;
+	using std::memcpy;
+	
+	using KalaHeaders::KalaThread::WorkPool;
+	
+	//How many jobs each work stealing chunk has by default, small enough to balance
+	//uneven strings and big enough to keep stealing rare
+	constexpr size_t BATCH_DEFAULT_CHUNK_SIZE = 64;
+	
+	//One independent string to lay out, the font and text must stay alive until LayoutJobs returns
+	struct LayoutJob
+	{
+		const LayoutFont* font{};
+		string_view text{};
+		f32 originX{};
+		f32 originY{};
+	};
+	
+	//Where the quads of one job are in the batch output
+	struct LayoutJobRange
+	{
+		u32 firstGlyph{}; //first quad of the job, its vertices start at firstGlyph * 4
+		u32 glyphCount{}; //how many quads the job has
+		f32 penX{};       //pen x position after the job
+		f32 penY{};       //pen y position after the job
+	};
+	
+	//Every job of one batch, jobs are stored back to back in job order
+	struct LayoutBatchOutput
+	{
+		vector<LayoutVertex> vertices{}; //four per quad, same order as LayoutText
+		vector<u16> glyphIndices{};      //glyph index of each quad
+		vector<LayoutJobRange> jobs{};   //one per job
+		u32 glyphCount{};                //quads of every job together
+	};
+	
+	//Lays out many independent strings on a WorkPool. Each thread writes into its own
+	//arena first and the arenas are then copied into one contiguous output, so threads
+	//never share output memory. Arenas and output keep their memory between calls.
+	//One LayoutJobs call runs at a time per BatchLayout
+	class BatchLayout
+	{
+	public:
+		explicit BatchLayout(WorkPool& workPool)
+			: pool(workPool),
+			arenas(make_unique<Arena[]>(workPool.GetThreadCount())) {}
+		
+		//Lays out every job and returns the output, which stays valid until the next call
+		const LayoutBatchOutput& LayoutJobs(
+			const LayoutJob* jobs,
+			size_t jobCount,
+			size_t chunkSize = BATCH_DEFAULT_CHUNK_SIZE)
+		{
+			for (u32 i = 0; i < pool.GetThreadCount(); ++i) arenas[i].glyphCount = 0;
+			
+			output.jobs.resize(jobCount);
+			sources.resize(jobCount);
+			
+			//each thread lays out its chunks into its own arena
+			
+			pool.ParallelFor(
+				jobCount,
+				chunkSize,
+				[this, jobs](size_t begin, size_t end, u32 participant)
+				{
+					Arena& arena = arenas[participant];
+					
+					for (size_t j = begin; j < end; ++j)
+					{
+						const LayoutJob& job = jobs[j];
+						
+						//one codepoint per byte at most, so the text always fits in one call
+						
+						size_t maxGlyphs = job.text.size();
+						arena.Reserve(arena.glyphCount + maxGlyphs);
+						
+						LayoutResult result = LayoutText(
+							*job.font,
+							job.text,
+							job.originX,
+							job.originY,
+							arena.vertices.data() + scast<size_t>(arena.glyphCount) * 4,
+							arena.glyphIndices.data() + arena.glyphCount,
+							scast<u32>(maxGlyphs));
+						
+						sources[j] = Source
+						{
+							.participant = participant,
+							.arenaGlyph = arena.glyphCount
+						};
+						output.jobs[j] = LayoutJobRange
+						{
+							.firstGlyph = 0,
+							.glyphCount = result.glyphCount,
+							.penX = result.penX,
+							.penY = result.penY
+						};
+						
+						arena.glyphCount += result.glyphCount;
+					}
+				});
+			
+			//job offsets in the contiguous output
+			
+			u32 glyphCount{};
+			for (auto& range : output.jobs)
+			{
+				range.firstGlyph = glyphCount;
+				glyphCount += range.glyphCount;
+			}
+			
+			output.glyphCount = glyphCount;
+			if (output.vertices.size() < scast<size_t>(glyphCount) * 4)
+			{
+				output.vertices.resize(scast<size_t>(glyphCount) * 4);
+				output.glyphIndices.resize(glyphCount);
+			}
+			
+			//gather every job from its arena
+			
+			pool.ParallelFor(
+				jobCount,
+				chunkSize,
+				[this](size_t begin, size_t end, u32)
+				{
+					for (size_t j = begin; j < end; ++j)
+					{
+						const LayoutJobRange& range = output.jobs[j];
+						if (range.glyphCount == 0) continue;
+						
+						const Arena& arena = arenas[sources[j].participant];
+						const size_t from = sources[j].arenaGlyph;
+						
+						memcpy(
+							output.vertices.data() + scast<size_t>(range.firstGlyph) * 4,
+							arena.vertices.data() + from * 4,
+							scast<size_t>(range.glyphCount) * 4 * sizeof(LayoutVertex));
+						memcpy(
+							output.glyphIndices.data() + range.firstGlyph,
+							arena.glyphIndices.data() + from,
+							scast<size_t>(range.glyphCount) * sizeof(u16));
+					}
+				});
+			
+			return output;
+		}
+		
+		const LayoutBatchOutput& GetOutput() const { return output; }
+	private:
+		//Quads of every job one thread laid out in one call
+		struct alignas(64) Arena
+		{
+			vector<LayoutVertex> vertices{};
+			vector<u16> glyphIndices{};
+			u32 glyphCount{};
+			
+			//Grows by doubling so arenas settle at their largest batch size
+			void Reserve(size_t glyphs)
+			{
+				if (glyphIndices.size() >= glyphs) return;
+				
+				size_t size = max(glyphs, glyphIndices.size() * 2);
+				vertices.resize(size * 4);
+				glyphIndices.resize(size);
+			}
+		};
+		
+		//Which arena a job was laid out into
+		struct Source
+		{
+			u32 participant{};
+			u32 arenaGlyph{};
+		};
+		
+		WorkPool& pool;
+		unique_ptr<Arena[]> arenas{};
+		vector<Source> sources{};
+		LayoutBatchOutput output{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,684 @@
+//------------------------------------------------------------------------------
+// composite_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - CPU compositor that blends kfd coverage masks into RGBA8 or gray8 framebuffers
+//   - Placement of glyphs laid out with layout_kfd.hpp, clipped to a rectangle
+//   - Linear or gamma-correct blending with SSE2 and AVX2 inner loops and a scalar fallback
+//------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+
+# Blending
+
+Every mask pixel is treated as coverage, multiplied with the color alpha and
+blended source-over into the framebuffer. The destination alpha channel of RGBA8
+framebuffers is blended the same way with a source alpha of 255.
+
+Linear blending works directly on the 8-bit values with exact rounding.
+Gamma-correct blending converts the color channels to linear light with a
+gamma of 2.0 (square and square root) before blending, which is close to sRGB
+and keeps the inner loop free of table lookups. Gray8 framebuffers use the
+luminance of the color.
+
+# Placement
+
+Framebuffer rows go down while layout positions go up, so CompositeText puts
+a layout position (x, y) at framebuffer column originX + x and row originY - y.
+Laying out at pen (0, 0) and passing the baseline row as originY places the text
+on that baseline.
+
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/layout_kfd.hpp"
+
+#if defined(__AVX2__)
+	#define KALA_COMPOSITE_AVX2 1
+#endif
+#if defined(__SSE2__) \
+	|| defined(_M_X64) \
+	|| (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define KALA_COMPOSITE_SSE2 1
+#endif
+
+#if defined(KALA_COMPOSITE_AVX2) || defined(KALA_COMPOSITE_SSE2)
+	#include <immintrin.h>
+#endif
+
+//reinterpret_cast
+#ifndef rcast
+	#define rcast reinterpret_cast
+#endif
+
+//static_cast
+#ifndef scast
+	#define scast static_cast
+#endif
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::memcpy;
+	using std::sqrt;
+	using std::floor;
+	using std::max;
+	using std::min;
+	
+	using i32 = int32_t;
+	
+	enum class PixelFormat : u8
+	{
+		FORMAT_GRAY8 = 1, //one byte per pixel
+		FORMAT_RGBA8 = 4  //four bytes per pixel in r, g, b, a order
+	};
+	
+	enum class BlendMode : u8
+	{
+		BLEND_LINEAR = 0, //blend the stored 8-bit values directly
+		BLEND_GAMMA  = 1  //blend color channels in linear light with a gamma of 2.0
+	};
+	
+	//Caller-owned pixels the compositor draws into
+	struct Framebuffer
+	{
+		u8* pixels{};
+		u32 width{};
+		u32 height{};
+		u32 stride{}; //bytes from one row to the next
+		PixelFormat format = PixelFormat::FORMAT_RGBA8;
+	};
+	
+	//Pixels outside of this rectangle are never written, x1 and y1 are exclusive.
+	//The default rectangle covers the whole framebuffer
+	struct ClipRect
+	{
+		i32 x0{};
+		i32 y0{};
+		i32 x1 = INT32_MAX;
+		i32 y1 = INT32_MAX;
+	};
+	
+	struct CompositeColor
+	{
+		u8 r = 255;
+		u8 g = 255;
+		u8 b = 255;
+		u8 a = 255;
+	};
+	
+	//One 8-bit coverage mask with top-down rows
+	struct CoverageMask
+	{
+		const u8* pixels{};
+		u32 width{};
+		u32 height{};
+		u32 stride{}; //bytes from one row to the next
+	};
+	
+	//Returns the masks of imported glyphs in import order plus one empty mask,
+	//so the glyph indices written by LayoutText index it directly.
+	//The masks point into the blocks, which must outlive them
+	inline vector<CoverageMask> BuildCoverageMasks(const vector<GlyphBlock>& blocks)
+	{
+		vector<CoverageMask> masks(blocks.size() + 1);
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const GlyphBlock& b = blocks[i];
+			
+			u32 stride = GetRowStride(b);
+			if (stride == 0
+				|| b.rawPixels.size() < scast<size_t>(stride) * b.height)
+			{
+				continue;
+			}
+			
+			masks[i] = CoverageMask
+			{
+				.pixels = b.rawPixels.data(),
+				.width = b.width,
+				.height = b.height,
+				.stride = stride
+			};
+		}
+		
+		return masks;
+	}
+	
+	//Same as above for glyphs imported with ImportKFDPacked, the masks point into the pixel arena
+	inline vector<CoverageMask> BuildCoverageMasks(
+		const vector<PackedGlyphBlock>& blocks,
+		const vector<u8>& pixelArena)
+	{
+		vector<CoverageMask> masks(blocks.size() + 1);
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const PackedGlyphBlock& b = blocks[i];
+			
+			u32 stride = GetRowStride(b);
+			if (stride == 0
+				|| b.rawPixelSize == 0)
+			{
+				continue;
+			}
+			
+			masks[i] = CoverageMask
+			{
+				.pixels = GetPackedPixels(pixelArena, b).data(),
+				.width = b.width,
+				.height = b.height,
+				.stride = stride
+			};
+		}
+		
+		return masks;
+	}
+	
+	namespace Composite
+	{
+		//Exact rounded x / 255 for x up to 255 * 255
+		inline u32 Div255(u32 x)
+		{
+			x += 128;
+			return (x + (x >> 8)) >> 8;
+		}
+		
+		inline u8 BlendLinear(
+			u32 dst,
+			u32 src,
+			u32 alpha)
+		{
+			return scast<u8>(Div255(dst * (255 - alpha) + src * alpha));
+		}
+		
+		inline u8 BlendGamma(
+			u32 dst,
+			f32 srcLinear,
+			f32 alpha)
+		{
+			f32 d = scast<f32>(dst) * (1.0f / 255.0f);
+			f32 blended = d * d + (srcLinear - d * d) * alpha;
+			
+			return scast<u8>(sqrt(blended) * 255.0f + 0.5f);
+		}
+
+#ifdef KALA_COMPOSITE_SSE2
+		//Exact rounded x / 255 of eight u16 lanes that are at most 255 * 255
+		inline __m128i Div255(__m128i x)
+		{
+			x = _mm_add_epi16(x, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		}
+		
+		//dst * (255 - alpha) + src * alpha, then / 255, on u16 lanes
+		inline __m128i Blend(
+			__m128i dst,
+			__m128i src,
+			__m128i alpha)
+		{
+			__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+			return Div255(_mm_add_epi16(
+				_mm_mullo_epi16(dst, inverse),
+				_mm_mullo_epi16(src, alpha)));
+		}
+#endif
+#ifdef KALA_COMPOSITE_AVX2
+		inline __m256i Div255(__m256i x)
+		{
+			x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+		}
+		
+		inline __m256i Blend(
+			__m256i dst,
+			__m256i src,
+			__m256i alpha)
+		{
+			__m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+			return Div255(_mm256_add_epi16(
+				_mm256_mullo_epi16(dst, inverse),
+				_mm256_mullo_epi16(src, alpha)));
+		}
+#endif
+		
+		//Blends one row of coverage into count RGBA8 pixels
+		inline void BlendRowRGBA8Linear(
+			u8* dst,
+			const u8* coverage,
+			u32 count,
+			CompositeColor color)
+		{
+			u32 x{};
+
+#ifdef KALA_COMPOSITE_AVX2
+			{
+				//8 pixels at a time, the alpha of each pixel is spread over its four channels
+				//in the same lane order that unpacking the destination bytes produces
+				
+				const __m128i zero = _mm_setzero_si128();
+				const __m256i zero256 = _mm256_setzero_si256();
+				const __m128i colorAlpha = _mm_set1_epi16(color.a);
+				const __m256i src = _mm256_setr_epi16(
+					color.r, color.g, color.b, 255, color.r, color.g, color.b, 255,
+					color.r, color.g, color.b, 255, color.r, color.g, color.b, 255);
+				
+				for (; x + 8 <= count; x += 8)
+				{
+					__m128i c = _mm_loadl_epi64(rcast<const __m128i*>(coverage + x));
+					if (_mm_testz_si128(c, c)) continue;
+					
+					__m128i a = Div255(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), colorAlpha));
+					
+					__m256i pairs = _mm256_set_m128i(
+						_mm_unpackhi_epi16(a, a),
+						_mm_unpacklo_epi16(a, a));
+					__m256i alphaLow = _mm256_unpacklo_epi32(pairs, pairs);
+					__m256i alphaHigh = _mm256_unpackhi_epi32(pairs, pairs);
+					
+					__m256i d = _mm256_loadu_si256(rcast<const __m256i*>(dst + x * 4));
+					
+					__m256i low = Blend(_mm256_unpacklo_epi8(d, zero256), src, alphaLow);
+					__m256i high = Blend(_mm256_unpackhi_epi8(d, zero256), src, alphaHigh);
+					
+					_mm256_storeu_si256(rcast<__m256i*>(dst + x * 4), _mm256_packus_epi16(low, high));
+				}
+			}
+#endif
+#ifdef KALA_COMPOSITE_SSE2
+			{
+				//4 pixels at a time
+				
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i colorAlpha = _mm_set1_epi16(color.a);
+				const __m128i src = _mm_setr_epi16(
+					color.r, color.g, color.b, 255, color.r, color.g, color.b, 255);
+				
+				for (; x + 4 <= count; x += 4)
+				{
+					u32 c4{};
+					memcpy(&c4, coverage + x, sizeof(u32));
+					if (c4 == 0) continue;
+					
+					__m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(scast<int>(c4)), zero);
+					__m128i a = Div255(_mm_mullo_epi16(c, colorAlpha));
+					
+					__m128i pairs = _mm_unpacklo_epi16(a, a);
+					__m128i alphaLow = _mm_unpacklo_epi32(pairs, pairs);
+					__m128i alphaHigh = _mm_unpackhi_epi32(pairs, pairs);
+					
+					__m128i d = _mm_loadu_si128(rcast<const __m128i*>(dst + x * 4));
+					
+					__m128i low = Blend(_mm_unpacklo_epi8(d, zero), src, alphaLow);
+					__m128i high = Blend(_mm_unpackhi_epi8(d, zero), src, alphaHigh);
+					
+					_mm_storeu_si128(rcast<__m128i*>(dst + x * 4), _mm_packus_epi16(low, high));
+				}
+			}
+#endif
+			for (; x < count; ++x)
+			{
+				if (coverage[x] == 0) continue;
+				
+				u32 a = Div255(coverage[x] * scast<u32>(color.a));
+				u8* p = dst + x * 4;
+				
+				p[0] = BlendLinear(p[0], color.r, a);
+				p[1] = BlendLinear(p[1], color.g, a);
+				p[2] = BlendLinear(p[2], color.b, a);
+				p[3] = BlendLinear(p[3], 255, a);
+			}
+		}
+		
+		//Blends one row of coverage into count gray8 pixels
+		inline void BlendRowGray8Linear(
+			u8* dst,
+			const u8* coverage,
+			u32 count,
+			u8 gray,
+			u8 alpha)
+		{
+			u32 x{};
+
+#ifdef KALA_COMPOSITE_AVX2
+			{
+				//32 pixels at a time, coverage and destination are unpacked in the same lane order
+				
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i colorAlpha = _mm256_set1_epi16(alpha);
+				const __m256i src = _mm256_set1_epi16(gray);
+				
+				for (; x + 32 <= count; x += 32)
+				{
+					__m256i c = _mm256_loadu_si256(rcast<const __m256i*>(coverage + x));
+					if (_mm256_testz_si256(c, c)) continue;
+					
+					__m256i alphaLow = Div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c, zero), colorAlpha));
+					__m256i alphaHigh = Div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c, zero), colorAlpha));
+					
+					__m256i d = _mm256_loadu_si256(rcast<const __m256i*>(dst + x));
+					
+					__m256i low = Blend(_mm256_unpacklo_epi8(d, zero), src, alphaLow);
+					__m256i high = Blend(_mm256_unpackhi_epi8(d, zero), src, alphaHigh);
+					
+					_mm256_storeu_si256(rcast<__m256i*>(dst + x), _mm256_packus_epi16(low, high));
+				}
+			}
+#endif
+#ifdef KALA_COMPOSITE_SSE2
+			{
+				//16 pixels at a time
+				
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i colorAlpha = _mm_set1_epi16(alpha);
+				const __m128i src = _mm_set1_epi16(gray);
+				
+				for (; x + 16 <= count; x += 16)
+				{
+					__m128i c = _mm_loadu_si128(rcast<const __m128i*>(coverage + x));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi8(c, zero)) == 0xFFFF) continue;
+					
+					__m128i alphaLow = Div255(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), colorAlpha));
+					__m128i alphaHigh = Div255(_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), colorAlpha));
+					
+					__m128i d = _mm_loadu_si128(rcast<const __m128i*>(dst + x));
+					
+					__m128i low = Blend(_mm_unpacklo_epi8(d, zero), src, alphaLow);
+					__m128i high = Blend(_mm_unpackhi_epi8(d, zero), src, alphaHigh);
+					
+					_mm_storeu_si128(rcast<__m128i*>(dst + x), _mm_packus_epi16(low, high));
+				}
+			}
+#endif
+			for (; x < count; ++x)
+			{
+				if (coverage[x] == 0) continue;
+				
+				u32 a = Div255(coverage[x] * scast<u32>(alpha));
+				dst[x] = BlendLinear(dst[x], gray, a);
+			}
+		}
+		
+		//Gamma-correct variant of BlendRowRGBA8Linear, the alpha channel stays linear
+		inline void BlendRowRGBA8Gamma(
+			u8* dst,
+			const u8* coverage,
+			u32 count,
+			CompositeColor color)
+		{
+			const f32 inv255 = 1.0f / 255.0f;
+			const f32 alphaScale = scast<f32>(color.a) * inv255 * inv255;
+			
+			const f32 srcR = scast<f32>(color.r) * inv255;
+			const f32 srcG = scast<f32>(color.g) * inv255;
+			const f32 srcB = scast<f32>(color.b) * inv255;
+			
+			u32 x{};
+
+#ifdef KALA_COMPOSITE_SSE2
+			{
+				//one pixel per vector with its four channels in the lanes,
+				//the alpha lane is squared with 1 and never square rooted
+				
+				const __m128i zero = _mm_setzero_si128();
+				const __m128 scale = _mm_set1_ps(inv255);
+				const __m128 alphaLane = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 src = _mm_setr_ps(srcR * srcR, srcG * srcG, srcB * srcB, 1.0f);
+				const __m128 half = _mm_set1_ps(0.5f);
+				const __m128 full = _mm_set1_ps(255.0f);
+				
+				for (; x < count; ++x)
+				{
+					if (coverage[x] == 0) continue;
+					
+					__m128 a = _mm_set1_ps(scast<f32>(coverage[x]) * alphaScale);
+					
+					u32 pixel{};
+					memcpy(&pixel, dst + x * 4, sizeof(u32));
+					
+					__m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(scast<int>(pixel)), zero);
+					__m128 d = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(p, zero)), scale);
+					
+					//x * x for color lanes, x * 1 for the alpha lane
+					__m128 square = _mm_or_ps(_mm_andnot_ps(alphaLane, d), _mm_and_ps(alphaLane, one));
+					__m128 linear = _mm_mul_ps(d, square);
+					
+					__m128 blended = _mm_add_ps(linear, _mm_mul_ps(_mm_sub_ps(src, linear), a));
+					
+					__m128 root = _mm_sqrt_ps(blended);
+					__m128 result = _mm_or_ps(_mm_andnot_ps(alphaLane, root), _mm_and_ps(alphaLane, blended));
+					
+					__m128i out = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(result, full), half));
+					out = _mm_packs_epi32(out, out);
+					out = _mm_packus_epi16(out, out);
+					
+					pixel = scast<u32>(_mm_cvtsi128_si32(out));
+					memcpy(dst + x * 4, &pixel, sizeof(u32));
+				}
+			}
+#endif
+			for (; x < count; ++x)
+			{
+				if (coverage[x] == 0) continue;
+				
+				f32 a = scast<f32>(coverage[x]) * alphaScale;
+				u8* p = dst + x * 4;
+				
+				p[0] = BlendGamma(p[0], srcR * srcR, a);
+				p[1] = BlendGamma(p[1], srcG * srcG, a);
+				p[2] = BlendGamma(p[2], srcB * srcB, a);
+				p[3] = scast<u8>(scast<f32>(p[3]) + (255.0f - scast<f32>(p[3])) * a + 0.5f);
+			}
+		}
+		
+		//Gamma-correct variant of BlendRowGray8Linear
+		inline void BlendRowGray8Gamma(
+			u8* dst,
+			const u8* coverage,
+			u32 count,
+			u8 gray,
+			u8 alpha)
+		{
+			const f32 inv255 = 1.0f / 255.0f;
+			const f32 alphaScale = scast<f32>(alpha) * inv255 * inv255;
+			const f32 srcValue = scast<f32>(gray) * inv255;
+			const f32 srcLinear = srcValue * srcValue;
+			
+			u32 x{};
+
+#ifdef KALA_COMPOSITE_AVX2
+			{
+				//8 pixels at a time in float lanes
+				
+				const __m256 scale = _mm256_set1_ps(inv255);
+				const __m256 coverageScale = _mm256_set1_ps(alphaScale);
+				const __m256 src = _mm256_set1_ps(srcLinear);
+				const __m256 half = _mm256_set1_ps(0.5f);
+				const __m256 full = _mm256_set1_ps(255.0f);
+				
+				for (; x + 8 <= count; x += 8)
+				{
+					__m128i c8 = _mm_loadl_epi64(rcast<const __m128i*>(coverage + x));
+					if (_mm_testz_si128(c8, c8)) continue;
+					
+					__m128i d8 = _mm_loadl_epi64(rcast<const __m128i*>(dst + x));
+					
+					__m256 a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c8)), coverageScale);
+					__m256 d = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(d8)), scale);
+					
+					__m256 linear = _mm256_mul_ps(d, d);
+					__m256 blended = _mm256_add_ps(linear, _mm256_mul_ps(_mm256_sub_ps(src, linear), a));
+					
+					__m256i out = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_sqrt_ps(blended), full), half));
+					
+					//8 i32 lanes back to 8 bytes
+					__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(out), _mm256_extracti128_si256(out, 1));
+					packed = _mm_packus_epi16(packed, packed);
+					
+					_mm_storel_epi64(rcast<__m128i*>(dst + x), packed);
+				}
+			}
+#endif
+#ifdef KALA_COMPOSITE_SSE2
+			{
+				//4 pixels at a time in float lanes
+				
+				const __m128i zero = _mm_setzero_si128();
+				const __m128 scale = _mm_set1_ps(inv255);
+				const __m128 coverageScale = _mm_set1_ps(alphaScale);
+				const __m128 src = _mm_set1_ps(srcLinear);
+				const __m128 half = _mm_set1_ps(0.5f);
+				const __m128 full = _mm_set1_ps(255.0f);
+				
+				for (; x + 4 <= count; x += 4)
+				{
+					u32 c4{};
+					memcpy(&c4, coverage + x, sizeof(u32));
+					if (c4 == 0) continue;
+					
+					u32 d4{};
+					memcpy(&d4, dst + x, sizeof(u32));
+					
+					__m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(scast<int>(c4)), zero), zero);
+					__m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(scast<int>(d4)), zero), zero);
+					
+					__m128 a = _mm_mul_ps(_mm_cvtepi32_ps(c), coverageScale);
+					__m128 d = _mm_mul_ps(_mm_cvtepi32_ps(p), scale);
+					
+					__m128 linear = _mm_mul_ps(d, d);
+					__m128 blended = _mm_add_ps(linear, _mm_mul_ps(_mm_sub_ps(src, linear), a));
+					
+					__m128i out = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sqrt_ps(blended), full), half));
+					out = _mm_packs_epi32(out, out);
+					out = _mm_packus_epi16(out, out);
+					
+					d4 = scast<u32>(_mm_cvtsi128_si32(out));
+					memcpy(dst + x, &d4, sizeof(u32));
+				}
+			}
+#endif
+			for (; x < count; ++x)
+			{
+				if (coverage[x] == 0) continue;
+				
+				dst[x] = BlendGamma(dst[x], srcLinear, scast<f32>(coverage[x]) * alphaScale);
+			}
+		}
+	}
+	
+	//Blends one coverage mask into the framebuffer with its top-left pixel at column x and row y.
+	//Returns how many mask pixels were inside the clip rectangle
+	inline u64 BlendMask(
+		Framebuffer& framebuffer,
+		const CoverageMask& mask,
+		i32 x,
+		i32 y,
+		CompositeColor color,
+		const ClipRect& clip = {},
+		BlendMode mode = BlendMode::BLEND_LINEAR)
+	{
+		if (!mask.pixels
+			|| !framebuffer.pixels)
+		{
+			return 0;
+		}
+		
+		//intersect the mask rectangle with the clip rectangle and the framebuffer,
+		//in 64 bits so positions near the i32 limits can not overflow
+		
+		int64_t left = max<int64_t>({ x, clip.x0, 0 });
+		int64_t top = max<int64_t>({ y, clip.y0, 0 });
+		int64_t right = min<int64_t>({ scast<int64_t>(x) + mask.width, clip.x1, framebuffer.width });
+		int64_t bottom = min<int64_t>({ scast<int64_t>(y) + mask.height, clip.y1, framebuffer.height });
+		
+		if (left >= right
+			|| top >= bottom)
+		{
+			return 0;
+		}
+		
+		const u32 count = scast<u32>(right - left);
+		const size_t channels = scast<size_t>(framebuffer.format);
+		
+		const u8 gray = scast<u8>((color.r * 77u + color.g * 150u + color.b * 29u + 128u) >> 8);
+		
+		for (int64_t row = top; row < bottom; ++row)
+		{
+			const u8* coverage = mask.pixels
+				+ scast<size_t>(row - y) * mask.stride
+				+ scast<size_t>(left - x);
+			
+			u8* dst = framebuffer.pixels
+				+ scast<size_t>(row) * framebuffer.stride
+				+ scast<size_t>(left) * channels;
+			
+			if (framebuffer.format == PixelFormat::FORMAT_RGBA8)
+			{
+				if (mode == BlendMode::BLEND_GAMMA) Composite::BlendRowRGBA8Gamma(dst, coverage, count, color);
+				else Composite::BlendRowRGBA8Linear(dst, coverage, count, color);
+			}
+			else
+			{
+				if (mode == BlendMode::BLEND_GAMMA) Composite::BlendRowGray8Gamma(dst, coverage, count, gray, color.a);
+				else Composite::BlendRowGray8Linear(dst, coverage, count, gray, color.a);
+			}
+		}
+		
+		return scast<u64>(count) * scast<u64>(bottom - top);
+	}
+	
+	//Blends glyphs laid out with LayoutText into the framebuffer. masks is indexed by the glyph indices
+	//LayoutText wrote, see BuildCoverageMasks. Returns how many mask pixels were inside the clip rectangle
+	inline u64 CompositeText(
+		Framebuffer& framebuffer,
+		const vector<CoverageMask>& masks,
+		const LayoutVertex* vertices,
+		const u16* glyphIndices,
+		u32 glyphCount,
+		f32 originX,
+		f32 originY,
+		CompositeColor color,
+		const ClipRect& clip = {},
+		BlendMode mode = BlendMode::BLEND_LINEAR)
+	{
+		u64 blended{};
+		
+		for (u32 i = 0; i < glyphCount; ++i)
+		{
+			u16 index = glyphIndices[i];
+			if (index >= masks.size()) continue;
+			
+			//the top-left vertex is the top-left pixel of the mask
+			const LayoutVertex& topLeft = vertices[scast<size_t>(i) * 4];
+			
+			i32 x = scast<i32>(floor(originX + topLeft.x + 0.5f));
+			i32 y = scast<i32>(floor(originY - topLeft.y + 0.5f));
+			
+			blended += BlendMask(
+				framebuffer,
+				masks[index],
+				x,
+				y,
+				color,
+				clip,
+				mode);
+		}
+		
+		return blended;
+	}
+}
\ No newline at end of file
@@ -18,7 +18,7 @@ Offset | Size | Field
 -------|------|--------------------------------------------
 0      | 4    | KFD magic word, always 'K', 'F', 'D', '\0'
 4      | 1    | kfd binary version
-5      | 1    | type, '1' for bitmap, '2' for glyph
+5      | 1    | type, '1' for bitmap, '2' for glyph, '3' for instance
 6      | 2    | height of glyphs passed during export
 8      | 4    | max number of allowed glyphs
 12     | 1    | first indice, always '0'
@@ -64,15 +64,62 @@ Offset | Size | Field
 ??+34  | 1    | each raw pixel value
 ...
 
+# KFD subpixel phase variants
+
+Glyph and instance kfd files can be compiled with 2, 3 or 4 horizontal subpixel phases.
+Every phase after the first is an extra glyph rendered with its outline moved right by
+phase / phase count pixels, and its char code keeps the phase above the unicode bits:
+char code | (phase << KFD_SUBPIXEL_PHASE_SHIFT). Phase 0 glyphs keep their plain char code,
+so readers that do not know about phases only see the normal glyphs.
+
+# KFD instance glyph block vertices
+
+Type '3' files are glyph files whose four vertex pairs hold a packed GlyphInstance
+instead, since the vertices can always be rebuilt from the bearings and size.
+Every glyph gets a place in an atlas page of KFD_ATLAS_PAGE_SIZE x KFD_ATLAS_PAGE_SIZE
+texels with KFD_ATLAS_PADDING empty texels around it. Read them with GetGlyphInstances.
+The file only stores placements, the page texels are built from the glyph pixels
+after import with BuildAtlasPages and uploaded by the caller.
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+??+14  | 2    | left edge relative to the pen (X)
+??+16  | 2    | top edge relative to the baseline (Y)
+??+18  | 2    | width
+??+20  | 2    | height
+??+22  | 2    | atlas page left texel (X)
+??+24  | 2    | atlas page top texel (Y)
+??+26  | 2    | atlas page index
+??+28  | 2    | advance
+
 ------------------------------------------------------------------------------*/
 
 #pragma once
 
 #include <vector>
 #include <array>
+#include <span>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+#include "KalaHeaders/trace_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#define KFD_HAS_IO_URING 1
+	#endif
+#endif
 
 //reinterpret_cast
 #ifndef rcast
@@ -88,6 +135,7 @@ namespace KalaHeaders::KalaFontData
 {	
 	using std::vector;
 	using std::array;
+	using std::span;
 	using std::string;
 	using std::ifstream;
 	using std::filesystem::path;
@@ -101,10 +149,22 @@ namespace KalaHeaders::KalaFontData
 	using std::streamsize;
 	using std::ios;
 	using std::move;
+	using std::stable_sort;
+	using std::max;
+	using std::memcpy;
+	using std::memset;
+	using std::min;
+	using std::atomic;
+	using std::atomic_ref;
+	using std::thread;
+	using std::filesystem::file_size;
+	
+	using KalaHeaders::KalaThread::WorkPool;
 	
 	using u8 = uint8_t;
 	using u16 = uint16_t;
 	using u32 = uint32_t;
+	using u64 = uint64_t;
 	using i8 = int8_t;
 	using i16 = int16_t;
 	
@@ -143,6 +203,32 @@ namespace KalaHeaders::KalaFontData
 		+ MAX_GLYPH_TABLE_SIZE 
 		+ MAX_GLYPH_BLOCK_SIZE;
 	
+	//Max gap in bytes between two requested glyph blocks
+	//that still lets StreamGlyphs read them with a single read
+	constexpr u32 STREAM_MERGE_GAP = 4096u;
+	
+	//How many reads the io_uring backend keeps in flight at once on linux
+	constexpr u32 STREAM_QUEUE_DEPTH = 64u;
+	
+	//Max worker threads the pread fallback uses on linux when io_uring is unavailable
+	constexpr u32 STREAM_MAX_READ_THREADS = 8u;
+	
+	//Char codes of subpixel phase variants store their phase from this bit up,
+	//unicode codepoints only need the low 21 bits
+	constexpr u32 KFD_SUBPIXEL_PHASE_SHIFT = 24u;
+	
+	//Mask that removes the subpixel phase from a glyph char code
+	constexpr u32 KFD_CHAR_CODE_MASK = (1u << KFD_SUBPIXEL_PHASE_SHIFT) - 1u;
+	
+	//Max horizontal subpixel phases a glyph can be compiled with
+	constexpr u8 KFD_MAX_SUBPIXEL_PHASES = 4;
+	
+	//Width and height of each atlas page of instance type kfd files in texels
+	constexpr u16 KFD_ATLAS_PAGE_SIZE = 1024u;
+	
+	//Empty texels between glyphs in instance type atlas pages so sampling never bleeds
+	constexpr u16 KFD_ATLAS_PADDING = 1u;
+	
 	//Min allowed glyph height
 	constexpr u8 MIN_GLYPH_HEIGHT = 10;
 	//Max allowed glyph height
@@ -153,7 +239,7 @@ namespace KalaHeaders::KalaFontData
 	{
 		u32 magic = KFD_MAGIC;    //kfd magic word
 		u8 version = KFD_VERSION; //kfd binary version
-		u8 type{};                //1 = bitmap, 2 = glyph
+		u8 type{};                //1 = bitmap, 2 = glyph, 3 = instance
 		u16 glyphHeight{};        //height of all glyphs in pixels
 		u32 glyphCount{};         //number of glyphs
 		array<u8, 6> indices = { 0, 1, 2, 2, 3, 0 };
@@ -191,6 +277,86 @@ namespace KalaHeaders::KalaFontData
 		vector<u8> rawPixels{};             //8-bit raw pixels of this glyph (0 - 255, 0 is transparent, 255 is white)
 	};
 	
+	//The block containing data of each glyph when imported with ImportKFDPacked,
+	//its pixels live in one shared pixel arena instead of a per-glyph vector
+	struct PackedGlyphBlock
+	{
+		u32 charCode{};                     //glyph character code in unicode
+		u16 width{};                        //glyph width
+		u16 height{};                       //glyph height
+		i16 bearingX{};                     //glyph left bearing
+		i16 bearingY{};                     //glyph top bearing
+		u16 advance{};                      //glyph advance
+		array<array<i16, 2>, 4> vertices{}; //vertices of this glyph, can be negative
+		u32 pixelOffset{};                  //offset of this glyph's first pixel in the pixel arena
+		u32 rawPixelSize{};                 //size of this glyph's pixels
+	};
+	
+	//Layout metrics of each glyph without its vertices or pixels
+	struct GlyphMetrics
+	{
+		u32 charCode{}; //glyph character code in unicode
+		u16 width{};    //glyph width
+		u16 height{};   //glyph height
+		i16 bearingX{}; //glyph left bearing
+		i16 bearingY{}; //glyph top bearing
+		u16 advance{};  //glyph advance
+	};
+	
+	//One glyph ready to be uploaded into an instance buffer, a quad is drawn from
+	//pen + (offsetX, offsetY) to pen + (offsetX + width, offsetY - height) in y-up space
+	//and samples texels (atlasX, atlasY) to (atlasX + width, atlasY + height) of its atlas page
+	struct alignas(16) GlyphInstance
+	{
+		i16 offsetX{};   //left edge relative to the pen
+		i16 offsetY{};   //top edge relative to the baseline
+		u16 width{};     //quad and texel width
+		u16 height{};    //quad and texel height
+		u16 atlasX{};    //left texel in the atlas page
+		u16 atlasY{};    //top texel in the atlas page
+		u16 atlasPage{}; //atlas page index, the glyph index for files that are not instance type
+		u16 advance{};   //how far the pen moves after this glyph
+	};
+	static_assert(sizeof(GlyphInstance) == 16, "GlyphInstance must stay 16 bytes");
+	
+	//Returns the subpixel phase of a glyph char code, 0 for normal glyphs
+	inline u32 GetSubpixelPhase(u32 charCode)
+	{
+		return charCode >> KFD_SUBPIXEL_PHASE_SHIFT;
+	}
+	
+	//Returns the unicode codepoint of a glyph char code without its subpixel phase
+	inline u32 GetBaseCharCode(u32 charCode)
+	{
+		return charCode & KFD_CHAR_CODE_MASK;
+	}
+	
+	//Returns the pixels of a packed glyph from the pixel arena it was imported with
+	inline span<const u8> GetPackedPixels(
+		const vector<u8>& pixelArena,
+		const PackedGlyphBlock& block)
+	{
+		return span<const u8>(
+			pixelArena.data() + block.pixelOffset,
+			block.rawPixelSize);
+	}
+	
+	//Returns how many bytes apart the pixel rows of a glyph are. FreeType can pad rows past
+	//the width, so the stride comes from the stored size, 0 if the rows can not be addressed.
+	//Works with GlyphBlock and PackedGlyphBlock
+	template<typename T>
+	inline u32 GetRowStride(const T& block)
+	{
+		if (block.height == 0
+			|| block.rawPixelSize % block.height != 0)
+		{
+			return 0;
+		}
+		
+		u32 stride = block.rawPixelSize / block.height;
+		return stride < block.width ? 0 : stride;
+	}
+	
 	enum class ImportResult : u8
 	{
 		RESULT_SUCCESS                     = 0, //No errors, succeeded with import
@@ -214,12 +380,18 @@ namespace KalaHeaders::KalaFontData
 		
 		RESULT_INVALID_MAGIC               = 8,  //magic must be 'KFD\0'
 		RESULT_INVALID_VERSION             = 9,  //version must match
-		RESULT_INVALID_TYPE                = 10, //type must be '1' or '2'
+		RESULT_INVALID_TYPE                = 10, //type must be '1', '2' or '3'
 		RESULT_INVALID_GLYPH_HEIGHT        = 11, //glyph height must be within range
 		RESULT_INVALID_GLYPH_TABLE_SIZE    = 12, //found a glyph table that wasnt the correct size
 		RESULT_INVALID_GLYPH_BLOCK_SIZE    = 13, //found a glyph block that was less or more than the allowed size
 		RESULT_INVALID_GLYPH_COUNT         = 14, //total glyph count was above allowed max glyph count
-		RESULT_UNEXPECTED_EOF              = 15  //file reached end sooner than expected
+		RESULT_UNEXPECTED_EOF              = 15, //file reached end sooner than expected
+		
+		//
+		// STREAM ERRORS
+		//
+		
+		RESULT_CANCELLED                   = 16  //async stream request was cancelled before it was read
 	};
 	
 	inline string ResultToString(ImportResult result)
@@ -261,6 +433,9 @@ namespace KalaHeaders::KalaFontData
 			return "RESULT_INVALID_GLYPH_COUNT";
 		case ImportResult::RESULT_UNEXPECTED_EOF:
 			return "RESULT_UNEXPECTED_EOF";
+			
+		case ImportResult::RESULT_CANCELLED:
+			return "RESULT_CANCELLED";
 		}
 		
 		return "RESULT_UNKNOWN";
@@ -336,6 +511,8 @@ namespace KalaHeaders::KalaFontData
 		GlyphHeader& outHeader,
 		bool skipChecks = false)
 	{
+		KALA_TRACE_ZONE("GetHeaderData");
+		
 		if (!skipChecks)
 		{
 			ImportResult preReadResult = PreReadCheck(inFile);
@@ -369,7 +546,8 @@ namespace KalaHeaders::KalaFontData
 				
 			memcpy(&header.type, headerData.data() + 5,  sizeof(u8));
 			if (header.type != 1
-				&& header.type != 2)
+				&& header.type != 2
+				&& header.type != 3)
 			{
 				return ImportResult::RESULT_INVALID_TYPE;
 			}
@@ -422,6 +600,8 @@ namespace KalaHeaders::KalaFontData
 		vector<GlyphTable>& outTables,
 		bool skipChecks = false)
 	{
+		KALA_TRACE_ZONE("GetTableData");
+		
 		if (!skipChecks)
 		{
 			ImportResult preReadResult = PreReadCheck(inFile);
@@ -482,13 +662,391 @@ namespace KalaHeaders::KalaFontData
 		}
 	}
 	
-	//Returns glyph blocks for the inserted tables, set skipChecks to true if the file has already been checked
+	//
+	// STREAM READ BACKEND
+	//
+	
+	//One contiguous byte range of a kfd file that StreamGlyphs wants in memory
+	struct StreamReadRange
+	{
+		size_t offset{}; //absolute offset from start of file
+		size_t size{};   //how many bytes to read
+		u8* data{};      //where the bytes are written to
+	};
+	
+#ifdef __linux__
+	//Reads the remainder of a range with pread, returns false on error or EOF
+	inline bool PreadRange(
+		int fd,
+		const StreamReadRange& r,
+		size_t done = 0)
+	{
+		while (done < r.size)
+		{
+			ssize_t got = pread(
+				fd,
+				r.data + done,
+				r.size - done,
+				scast<off_t>(r.offset + done));
+				
+			if (got < 0 && errno == EINTR) continue;
+			if (got <= 0) return false;
+			
+			done += scast<size_t>(got);
+		}
+		
+		return true;
+	}
+	
+	//Persistent read threads of the pread fallback, created on first use and shared by every
+	//StreamGlyphs call so cold loading many fonts does not start and join threads for each one.
+	//Calls from several threads take turns on it
+	inline WorkPool& GetPreadPool()
+	{
+		static WorkPool pool(min(max(thread::hardware_concurrency(), 1u), STREAM_MAX_READ_THREADS));
+		return pool;
+	}
+	
+	//Reads all ranges with pread, spread across the read pool when there are enough of them
+	inline bool PreadRanges(
+		int fd,
+		vector<StreamReadRange>& ranges)
+	{
+		KALA_TRACE_ZONE("PreadRanges");
+		
+		if (ranges.size() < 4
+			|| thread::hardware_concurrency() < 2)
+		{
+			for (const auto& r : ranges)
+			{
+				if (!PreadRange(fd, r)) return false;
+			}
+			
+			return true;
+		}
+		
+		atomic<bool> failed{};
+		
+		GetPreadPool().ParallelFor(
+			ranges.size(),
+			1,
+			[&](size_t begin, size_t end, u32)
+			{
+				KALA_TRACE_ZONE("PreadWorker");
+				
+				for (size_t i = begin; i < end; ++i)
+				{
+					if (!PreadRange(fd, ranges[i])) failed.store(true, std::memory_order_relaxed);
+				}
+			});
+		
+		return !failed.load(std::memory_order_relaxed);
+	}
+	
+#ifdef KFD_HAS_IO_URING
+	//Minimal io_uring ring that submits a whole batch of reads with one syscall,
+	//one ring is created lazily per thread and reused by every StreamGlyphs call on it
+	class StreamRing
+	{
+	public:
+		~StreamRing()
+		{
+			if (sqes)                        munmap(sqes, sqesSize);
+			if (cqRing && cqRing != sqRing)  munmap(cqRing, cqRingSize);
+			if (sqRing)                      munmap(sqRing, sqRingSize);
+			if (ringFD >= 0)                 close(ringFD);
+		}
+		
+		//Returns the ring of this thread or nullptr if io_uring is not usable on this system
+		static StreamRing* Get()
+		{
+			static atomic<bool> isUnavailable{};
+			if (isUnavailable.load(std::memory_order_relaxed)) return nullptr;
+			
+			thread_local StreamRing ring{};
+			if (ring.ringFD >= 0) return &ring;
+			
+			if (!ring.Setup())
+			{
+				isUnavailable.store(true, std::memory_order_relaxed);
+				return nullptr;
+			}
+			
+			return &ring;
+		}
+		
+		//Reads all ranges, keeping up to STREAM_QUEUE_DEPTH reads in flight.
+		//Reads the kernel rejects or cuts short are finished with pread.
+		//Returns only once the kernel is done with every read it took, also on failure,
+		//since those reads write into buffers the caller frees and their completions
+		//would otherwise be left in the ring for the next call
+		bool Read(
+			int fd,
+			vector<StreamReadRange>& ranges)
+		{
+			size_t queued{};    //in the submission ring but not taken by the kernel yet
+			size_t submitted{}; //taken by the kernel
+			size_t completed{};
+			bool isFailed{};
+			
+			while (completed < submitted
+				|| (!isFailed
+				&& completed < ranges.size()))
+			{
+				while (!isFailed
+					&& submitted + queued < ranges.size()
+					&& submitted + queued - completed < sqEntries)
+				{
+					size_t next = submitted + queued;
+					const StreamReadRange& r = ranges[next];
+					
+					u32 tail = *sqTail;
+					u32 index = tail & *sqMask;
+					
+					io_uring_sqe& sqe = sqes[index];
+					memset(&sqe, 0, sizeof(sqe));
+					
+					sqe.opcode = IORING_OP_READ;
+					sqe.fd = fd;
+					sqe.addr = rcast<u64>(r.data);
+					sqe.len = scast<u32>(r.size);
+					sqe.off = r.offset;
+					sqe.user_data = next;
+					
+					sqArray[index] = index;
+					atomic_ref<u32>(*sqTail).store(tail + 1, std::memory_order_release);
+					
+					++queued;
+				}
+				
+				//a short submit returns without waiting, the rest is submitted on the next pass
+				
+				int entered = scast<int>(syscall(
+					__NR_io_uring_enter,
+					ringFD,
+					scast<u32>(queued),
+					1u,
+					IORING_ENTER_GETEVENTS,
+					nullptr,
+					0));
+					
+				if (entered < 0)
+				{
+					if (errno == EINTR
+						|| errno == EAGAIN
+						|| errno == EBUSY)
+					{
+						continue;
+					}
+					
+					//nothing polls the submission ring, so reads the kernel has
+					//not taken yet can still be removed from it
+					
+					isFailed = true;
+					DropQueued(queued);
+				}
+				else
+				{
+					submitted += scast<size_t>(entered);
+					queued -= scast<size_t>(entered);
+				}
+				
+				u32 head = *cqHead;
+				u32 tail = atomic_ref<u32>(*cqTail).load(std::memory_order_acquire);
+				
+				while (head != tail)
+				{
+					const io_uring_cqe& cqe = cqes[head & *cqMask];
+					const StreamReadRange& r = ranges[scast<size_t>(cqe.user_data)];
+					
+					size_t done = cqe.res > 0 ? scast<size_t>(cqe.res) : 0;
+					if (!isFailed
+						&& done < r.size
+						&& !PreadRange(fd, r, done))
+					{
+						isFailed = true;
+						DropQueued(queued);
+					}
+					
+					++head;
+					++completed;
+				}
+				
+				atomic_ref<u32>(*cqHead).store(head, std::memory_order_release);
+			}
+			
+			return !isFailed;
+		}
+	private:
+		bool Setup()
+		{
+			io_uring_params params{};
+			
+			ringFD = scast<int>(syscall(
+				__NR_io_uring_setup,
+				STREAM_QUEUE_DEPTH,
+				&params));
+				
+			if (ringFD < 0) return false;
+			
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			
+			bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (isSingleMap) sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+			
+			void* sq = mmap(
+				nullptr,
+				sqRingSize,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE,
+				ringFD,
+				IORING_OFF_SQ_RING);
+				
+			if (sq == MAP_FAILED) return Fail();
+			sqRing = scast<u8*>(sq);
+			
+			if (isSingleMap) cqRing = sqRing;
+			else
+			{
+				void* cq = mmap(
+					nullptr,
+					cqRingSize,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE,
+					ringFD,
+					IORING_OFF_CQ_RING);
+					
+				if (cq == MAP_FAILED) return Fail();
+				cqRing = scast<u8*>(cq);
+			}
+			
+			sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			
+			void* sqeMap = mmap(
+				nullptr,
+				sqesSize,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE,
+				ringFD,
+				IORING_OFF_SQES);
+				
+			if (sqeMap == MAP_FAILED) return Fail();
+			sqes = scast<io_uring_sqe*>(sqeMap);
+			
+			sqTail = rcast<u32*>(sqRing + params.sq_off.tail);
+			sqMask = rcast<u32*>(sqRing + params.sq_off.ring_mask);
+			sqArray = rcast<u32*>(sqRing + params.sq_off.array);
+			sqEntries = params.sq_entries;
+			
+			cqHead = rcast<u32*>(cqRing + params.cq_off.head);
+			cqTail = rcast<u32*>(cqRing + params.cq_off.tail);
+			cqMask = rcast<u32*>(cqRing + params.cq_off.ring_mask);
+			cqes = rcast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+			
+			return true;
+		}
+		
+		//Takes back reads that are in the submission ring but not submitted yet
+		void DropQueued(size_t& queued)
+		{
+			u32 tail = *sqTail - scast<u32>(queued);
+			atomic_ref<u32>(*sqTail).store(tail, std::memory_order_release);
+			
+			queued = 0;
+		}
+		
+		bool Fail()
+		{
+			if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+			if (sqRing)                     munmap(sqRing, sqRingSize);
+			
+			close(ringFD);
+			
+			ringFD = -1;
+			sqRing = nullptr;
+			cqRing = nullptr;
+			
+			return false;
+		}
+		
+		int ringFD = -1;
+		
+		u8* sqRing{};
+		u8* cqRing{};
+		io_uring_sqe* sqes{};
+		size_t sqRingSize{};
+		size_t cqRingSize{};
+		size_t sqesSize{};
+		
+		u32* sqTail{};
+		u32* sqMask{};
+		u32* sqArray{};
+		u32 sqEntries{};
+		
+		u32* cqHead{};
+		u32* cqTail{};
+		u32* cqMask{};
+		io_uring_cqe* cqes{};
+	};
+#endif //KFD_HAS_IO_URING
+#endif //__linux__
+	
+	//Reads every range of the file into memory. On linux all ranges are submitted
+	//as one io_uring batch, with a pread worker fallback when io_uring is unavailable.
+	//Other platforms read the ranges one after another
+	inline bool ReadStreamRanges(
+		const path& inFile,
+		vector<StreamReadRange>& ranges)
+	{
+#ifdef __linux__
+		int fd = open(inFile.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return false;
+		
+		bool result{};
+		
+	#ifdef KFD_HAS_IO_URING
+		StreamRing* ring = ranges.size() > 1 ? StreamRing::Get() : nullptr;
+		
+		if (ring) result = ring->Read(fd, ranges);
+		else      result = PreadRanges(fd, ranges);
+	#else
+		result = PreadRanges(fd, ranges);
+	#endif
+	
+		close(fd);
+		
+		return result;
+#else
+		ifstream in(inFile, ios::in | ios::binary);
+		
+		for (const auto& r : ranges)
+		{
+			in.seekg(scast<streamoff>(r.offset));
+			in.read(
+				rcast<char*>(r.data),
+				scast<streamsize>(r.size));
+				
+			if (scast<size_t>(in.gcount()) != r.size) return false;
+		}
+		
+		in.close();
+		
+		return true;
+#endif
+	}
+	
+	//Returns glyph blocks for the inserted tables, set skipChecks to true if the file has already been checked.
+	//Blocks are read in file order with nearby blocks merged into a single read and all reads submitted
+	//as one batch, but outBlocks is always returned in the same order as inTables
 	inline ImportResult StreamGlyphs(
 		const path& inFile,
 		const vector<GlyphTable>& inTables,
 		vector<GlyphBlock>& outBlocks,
 		bool skipChecks = false)
 	{
+		KALA_TRACE_ZONE("StreamGlyphs");
+		
 		if (!skipChecks)
 		{
 			ImportResult preReadResult = PreReadCheck(inFile);
@@ -500,59 +1058,259 @@ namespace KalaHeaders::KalaFontData
 		
 		try
 		{
-			ifstream in(inFile, ios::in | ios::binary);
-			
-			in.seekg(0, ios::end);
-			size_t fileSize = scast<size_t>(in.tellg());
-			
-			//glyph block data
-			
-			vector<GlyphBlock> blocks{};
-			blocks.reserve(inTables.size());
+			size_t fileSize = scast<size_t>(file_size(inFile));
 			
 			for (const auto& t : inTables)
 			{
-				GlyphBlock b{};
-				
-				size_t offset = t.blockOffset;
-				
 				//verify that block size is not OOB
-				if (offset + t.blockSize > fileSize)
+				if (scast<size_t>(t.blockOffset) + t.blockSize > fileSize)
 				{
 					return ImportResult::RESULT_UNEXPECTED_EOF;
 				}
 				
-				in.seekg(offset);
+				//verify that block can hold its info
+				if (t.blockSize < RAW_PIXEL_DATA_OFFSET)
+				{
+					return ImportResult::RESULT_INVALID_GLYPH_BLOCK_SIZE;
+				}
+			}
+			
+			//sort requested tables by their offset in the file
+			
+			vector<u32> order(inTables.size());
+			for (u32 i = 0; i < order.size(); ++i) order[i] = i;
+			
+			stable_sort(
+				order.begin(),
+				order.end(),
+				[&inTables](u32 a, u32 b)
+				{
+					return inTables[a].blockOffset < inTables[b].blockOffset;
+				});
 				
-				in.read(rcast<char*>(&b.charCode), sizeof(u32));
-				in.read(rcast<char*>(&b.width),    sizeof(u16));
-				in.read(rcast<char*>(&b.height),   sizeof(u16));
-				in.read(rcast<char*>(&b.bearingX), sizeof(i16));
-				in.read(rcast<char*>(&b.bearingY), sizeof(i16));
-				in.read(rcast<char*>(&b.advance),  sizeof(u16));
+			//merge all blocks that start close enough to the previous read range,
+			//rangeFirst stores the first sorted table index of each range
+			
+			vector<StreamReadRange> ranges{};
+			vector<size_t> rangeFirst{};
+			size_t scratchSize{};
+			
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				const GlyphTable& t = inTables[order[i]];
+				size_t blockEnd = scast<size_t>(t.blockOffset) + t.blockSize;
 				
-				//vertices
-				in.read(rcast<char*>(&b.vertices), sizeof(b.vertices));
+				if (!ranges.empty()
+					&& t.blockOffset <= ranges.back().offset + ranges.back().size + STREAM_MERGE_GAP)
+				{
+					StreamReadRange& r = ranges.back();
+					
+					size_t newSize = max(r.offset + r.size, blockEnd) - r.offset;
+					scratchSize += newSize - r.size;
+					r.size = newSize;
+					
+					continue;
+				}
 				
-				//raw pixel size
-				in.read(rcast<char*>(&b.rawPixelSize), sizeof(u32));
+				ranges.push_back({ t.blockOffset, t.blockSize, nullptr });
+				rangeFirst.push_back(i);
+				scratchSize += t.blockSize;
+			}
+			rangeFirst.push_back(order.size());
+			
+			//read every range into one scratch buffer in a single batch
+			
+			vector<u8> scratch(scratchSize);
+			
+			size_t scratchOffset{};
+			for (auto& r : ranges)
+			{
+				r.data = scratch.data() + scratchOffset;
+				scratchOffset += r.size;
+			}
+			
+			if (!ReadStreamRanges(inFile, ranges))
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+			
+			//glyph block data
+			
+			vector<GlyphBlock> blocks(inTables.size());
+			
+			for (size_t ri = 0; ri < ranges.size(); ++ri)
+			{
+				const StreamReadRange& r = ranges[ri];
 				
-				//verify that pixel data is not OOB
-				if (offset + RAW_PIXEL_DATA_OFFSET + b.rawPixelSize > fileSize)
+				for (size_t i = rangeFirst[ri]; i < rangeFirst[ri + 1]; ++i)
+				{
+					const GlyphTable& t = inTables[order[i]];
+					GlyphBlock& b = blocks[order[i]];
+					
+					const u8* data = r.data + (t.blockOffset - r.offset);
+					
+					memcpy(&b.charCode, data + 0,  sizeof(u32));
+					memcpy(&b.width,    data + 4,  sizeof(u16));
+					memcpy(&b.height,   data + 6,  sizeof(u16));
+					memcpy(&b.bearingX, data + 8,  sizeof(i16));
+					memcpy(&b.bearingY, data + 10, sizeof(i16));
+					memcpy(&b.advance,  data + 12, sizeof(u16));
+					
+					//vertices
+					memcpy(&b.vertices, data + 14, sizeof(b.vertices));
+					
+					//raw pixel size
+					memcpy(&b.rawPixelSize, data + 30, sizeof(u32));
+					
+					//verify that pixel data is not OOB
+					if (scast<size_t>(RAW_PIXEL_DATA_OFFSET) + b.rawPixelSize > t.blockSize)
+					{
+						return ImportResult::RESULT_UNEXPECTED_EOF;
+					}
+					
+					//raw pixel data
+					b.rawPixels.assign(
+						data + RAW_PIXEL_DATA_OFFSET,
+						data + RAW_PIXEL_DATA_OFFSET + b.rawPixelSize);
+				}
+			}
+			
+			outBlocks = move(blocks);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		catch (...)
+		{
+			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+		}
+	}
+	
+	//Returns the glyph tables and the layout metrics of every glyph without reading any pixel data,
+	//outMetrics[i] belongs to outTables[i] so its pixels can be streamed later with StreamGlyphs.
+	//Set skipChecks to true if the file has already been checked
+	inline ImportResult GetMetricsData(
+		const path& inFile,
+		vector<GlyphTable>& outTables,
+		vector<GlyphMetrics>& outMetrics,
+		bool skipChecks = false)
+	{
+		KALA_TRACE_ZONE("GetMetricsData");
+		
+		if (!skipChecks)
+		{
+			ImportResult preReadResult = PreReadCheck(inFile);
+			if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+			
+			ImportResult tryOpenResult = TryOpenCheck(inFile);
+			if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+		}
+		
+		vector<GlyphTable> tables{};
+			
+		ImportResult tableResult = GetTableData(
+			inFile,
+			tables,
+			true);
+			
+		if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
+		
+		try
+		{
+			size_t fileSize = scast<size_t>(file_size(inFile));
+			
+			for (const auto& t : tables)
+			{
+				//verify that block size is not OOB
+				if (scast<size_t>(t.blockOffset) + t.blockSize > fileSize)
 				{
 					return ImportResult::RESULT_UNEXPECTED_EOF;
 				}
 				
-				//raw pixel data
-				b.rawPixels.resize(b.rawPixelSize);
-				in.read(rcast<char*>(b.rawPixels.data()), b.rawPixelSize);
+				//verify that block can hold its info
+				if (t.blockSize < RAW_PIXEL_DATA_OFFSET)
+				{
+					return ImportResult::RESULT_INVALID_GLYPH_BLOCK_SIZE;
+				}
+			}
+			
+			//only the info part of each block is read, never the pixels.
+			//infos are sorted by their offset in the file and merged like StreamGlyphs does,
+			//rangeFirst stores the first sorted table index of each range
+			
+			vector<u32> order(tables.size());
+			for (u32 i = 0; i < order.size(); ++i) order[i] = i;
+			
+			stable_sort(
+				order.begin(),
+				order.end(),
+				[&tables](u32 a, u32 b)
+				{
+					return tables[a].blockOffset < tables[b].blockOffset;
+				});
+			
+			vector<StreamReadRange> ranges{};
+			vector<size_t> rangeFirst{};
+			size_t scratchSize{};
+			
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				const GlyphTable& t = tables[order[i]];
+				size_t infoEnd = scast<size_t>(t.blockOffset) + RAW_PIXEL_DATA_OFFSET;
 				
-				blocks.push_back(move(b));
+				if (!ranges.empty()
+					&& t.blockOffset <= ranges.back().offset + ranges.back().size + STREAM_MERGE_GAP)
+				{
+					StreamReadRange& r = ranges.back();
+					
+					size_t newSize = max(r.offset + r.size, infoEnd) - r.offset;
+					scratchSize += newSize - r.size;
+					r.size = newSize;
+					
+					continue;
+				}
+				
+				ranges.push_back({ t.blockOffset, RAW_PIXEL_DATA_OFFSET, nullptr });
+				rangeFirst.push_back(i);
+				scratchSize += RAW_PIXEL_DATA_OFFSET;
 			}
+			rangeFirst.push_back(order.size());
 			
-			in.close();
+			vector<u8> scratch(scratchSize);
 			
-			outBlocks = move(blocks);
+			size_t scratchOffset{};
+			for (auto& r : ranges)
+			{
+				r.data = scratch.data() + scratchOffset;
+				scratchOffset += r.size;
+			}
+			
+			if (!ReadStreamRanges(inFile, ranges))
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+			
+			vector<GlyphMetrics> metrics(tables.size());
+			
+			for (size_t ri = 0; ri < ranges.size(); ++ri)
+			{
+				const StreamReadRange& r = ranges[ri];
+				
+				for (size_t i = rangeFirst[ri]; i < rangeFirst[ri + 1]; ++i)
+				{
+					const u8* data = r.data + (tables[order[i]].blockOffset - r.offset);
+					GlyphMetrics& m = metrics[order[i]];
+					
+					memcpy(&m.charCode, data + 0,  sizeof(u32));
+					memcpy(&m.width,    data + 4,  sizeof(u16));
+					memcpy(&m.height,   data + 6,  sizeof(u16));
+					memcpy(&m.bearingX, data + 8,  sizeof(i16));
+					memcpy(&m.bearingY, data + 10, sizeof(i16));
+					memcpy(&m.advance,  data + 12, sizeof(u16));
+				}
+			}
+			
+			outTables = move(tables);
+			outMetrics = move(metrics);
 			
 			return ImportResult::RESULT_SUCCESS;
 		}
@@ -569,6 +1327,8 @@ namespace KalaHeaders::KalaFontData
 		vector<GlyphTable>& outTables,
 		vector<GlyphBlock>& outBlocks)
 	{
+		KALA_TRACE_ZONE("ImportKFD");
+		
 		ImportResult preReadResult = PreReadCheck(inFile);
 		if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
 		
@@ -669,4 +1429,279 @@ namespace KalaHeaders::KalaFontData
 			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
 		}
 	}
+	
+	//Returns the entire kfd file binary content in structs with the pixels of every glyph
+	//inside outPixelArena. The glyph block region is read straight into the arena and the
+	//blocks point at their pixels in place, so pixels are never copied after the read and
+	//the allocation count stays the same no matter how many glyphs the file has
+	inline ImportResult ImportKFDPacked(
+		const path& inFile,
+		GlyphHeader& outHeader,
+		vector<GlyphTable>& outTables,
+		vector<PackedGlyphBlock>& outBlocks,
+		vector<u8>& outPixelArena)
+	{
+		KALA_TRACE_ZONE("ImportKFDPacked");
+		
+		ImportResult preReadResult = PreReadCheck(inFile);
+		if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+		
+		ImportResult tryOpenResult = TryOpenCheck(inFile);
+		if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+		
+		//header data
+			
+		GlyphHeader header{};
+			
+		ImportResult headerResult = GetHeaderData(
+			inFile,
+			header,
+			true);
+			
+		if (headerResult != ImportResult::RESULT_SUCCESS) return headerResult;
+			
+		//glyph table data
+			
+		vector<GlyphTable> tables{};
+			
+		ImportResult tableResult = GetTableData(
+			inFile,
+			tables,
+			true);
+			
+		if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
+				
+		try
+		{
+			ifstream in(inFile, ios::in | ios::binary);
+			
+			vector<u8> pixelArena(header.glyphBlockSize);
+			
+			//start at the end of the tables
+			
+			size_t blockRegionStart = CORRECT_GLYPH_HEADER_SIZE + header.glyphTableSize;
+			in.seekg(blockRegionStart);
+			
+			//read in the size of all blocks
+			in.read(
+				rcast<char*>(pixelArena.data()),
+				scast<streamsize>(header.glyphBlockSize));
+			
+			if (in.gcount() != scast<streamsize>(header.glyphBlockSize))
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+				
+			in.close();
+			
+			//glyph block data
+			
+			vector<PackedGlyphBlock> blocks{};
+			blocks.reserve(tables.size());
+			
+			for (const auto& t : tables)
+			{
+				PackedGlyphBlock b{};
+				
+				//verify that block size is not OOB
+				if (t.blockOffset < blockRegionStart
+					|| t.blockOffset - blockRegionStart + t.blockSize > pixelArena.size()
+					|| t.blockSize < RAW_PIXEL_DATA_OFFSET)
+				{
+					return ImportResult::RESULT_UNEXPECTED_EOF;
+				}
+				
+				const u8* data = pixelArena.data() + (t.blockOffset - blockRegionStart);
+				
+				memcpy(&b.charCode, data + 0,  sizeof(u32));
+				memcpy(&b.width,    data + 4,  sizeof(u16));
+				memcpy(&b.height,   data + 6,  sizeof(u16));
+				memcpy(&b.bearingX, data + 8,  sizeof(i16));
+				memcpy(&b.bearingY, data + 10, sizeof(i16));
+				memcpy(&b.advance,  data + 12, sizeof(u16));
+				
+				//vertices
+				memcpy(&b.vertices, data + 14, sizeof(b.vertices));
+				
+				//raw pixel size
+				memcpy(&b.rawPixelSize, data + 30, sizeof(u32));
+				
+				//verify that pixel data is not OOB
+				if (scast<size_t>(RAW_PIXEL_DATA_OFFSET) + b.rawPixelSize > t.blockSize)
+				{
+					return ImportResult::RESULT_UNEXPECTED_EOF;
+				}
+				
+				//raw pixel data stays where it was read
+				b.pixelOffset = scast<u32>(t.blockOffset - blockRegionStart + RAW_PIXEL_DATA_OFFSET);
+				
+				blocks.push_back(b);
+			}
+			
+			outHeader = header;
+			outTables = move(tables);
+			outBlocks = move(blocks);
+			outPixelArena = move(pixelArena);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		catch (...)
+		{
+			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+		}
+	}
+	
+	//Returns the instance record of one imported glyph. Instance type files store it in the
+	//vertex slot of the block, other types get it from the bearings and size with the
+	//glyph index as the atlas page since every glyph is its own texture.
+	//Works with GlyphBlock and PackedGlyphBlock
+	template<typename T>
+	inline GlyphInstance GetGlyphInstance(
+		const GlyphHeader& header,
+		const T& block,
+		u16 glyphIndex)
+	{
+		if (header.type == 3)
+		{
+			return GlyphInstance
+			{
+				.offsetX = block.vertices[0][0],
+				.offsetY = block.vertices[0][1],
+				.width = scast<u16>(block.vertices[1][0]),
+				.height = scast<u16>(block.vertices[1][1]),
+				.atlasX = scast<u16>(block.vertices[2][0]),
+				.atlasY = scast<u16>(block.vertices[2][1]),
+				.atlasPage = scast<u16>(block.vertices[3][0]),
+				.advance = scast<u16>(block.vertices[3][1])
+			};
+		}
+		
+		return GlyphInstance
+		{
+			.offsetX = block.bearingX,
+			.offsetY = block.bearingY,
+			.width = block.width,
+			.height = block.height,
+			.atlasX = 0,
+			.atlasY = 0,
+			.atlasPage = glyphIndex,
+			.advance = block.advance
+		};
+	}
+	
+	//Returns the instance records of every imported glyph in import order as one
+	//contiguous 16-byte aligned array that can be uploaded as a single instance buffer
+	template<typename T>
+	inline vector<GlyphInstance> GetGlyphInstances(
+		const GlyphHeader& header,
+		const vector<T>& blocks)
+	{
+		KALA_TRACE_ZONE("GetGlyphInstances");
+		
+		vector<GlyphInstance> instances(blocks.size());
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			instances[i] = GetGlyphInstance(header, blocks[i], scast<u16>(i));
+		}
+		
+		return instances;
+	}	
+	//Copies the pixels of every glyph of an instance type kfd to its placement and returns
+	//the 8-bit atlas pages in page index order, each KFD_ATLAS_PAGE_SIZE x KFD_ATLAS_PAGE_SIZE
+	//texels in rows. Padding texels stay 0. Returns no pages for other types or if a glyph
+	//placement or its pixels do not fit. The getter returns the pixels of one block
+	template<typename T, typename PixelGetter>
+	inline vector<vector<u8>> BuildAtlasPages(
+		const GlyphHeader& header,
+		const vector<T>& blocks,
+		PixelGetter getPixels)
+	{
+		KALA_TRACE_ZONE("BuildAtlasPages");
+		
+		if (header.type != 3) return {};
+		
+		constexpr size_t pageTexels = scast<size_t>(KFD_ATLAS_PAGE_SIZE) * KFD_ATLAS_PAGE_SIZE;
+		
+		vector<vector<u8>> pages{};
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const T& block = blocks[i];
+			
+			GlyphInstance instance = GetGlyphInstance(header, block, scast<u16>(i));
+			u32 stride = GetRowStride(block);
+			
+			//empty glyphs own no texels
+			
+			if (instance.width == 0
+				|| instance.height == 0
+				|| stride == 0)
+			{
+				continue;
+			}
+			
+			span<const u8> pixels = getPixels(block);
+			
+			if (instance.width != block.width
+				|| instance.height != block.height
+				|| scast<u32>(instance.atlasX) + instance.width > KFD_ATLAS_PAGE_SIZE
+				|| scast<u32>(instance.atlasY) + instance.height > KFD_ATLAS_PAGE_SIZE
+				|| pixels.size() < scast<size_t>(stride) * block.height)
+			{
+				return {};
+			}
+			
+			if (instance.atlasPage >= pages.size()) pages.resize(scast<size_t>(instance.atlasPage) + 1);
+			
+			vector<u8>& page = pages[instance.atlasPage];
+			if (page.empty()) page.resize(pageTexels);
+			
+			for (u32 y = 0; y < block.height; ++y)
+			{
+				memcpy(
+					page.data() + (scast<size_t>(instance.atlasY) + y) * KFD_ATLAS_PAGE_SIZE + instance.atlasX,
+					pixels.data() + scast<size_t>(y) * stride,
+					block.width);
+			}
+		}
+		
+		//pages no glyph landed on are still full size so indices stay direct
+		
+		for (vector<u8>& page : pages)
+		{
+			if (page.empty()) page.resize(pageTexels);
+		}
+		
+		return pages;
+	}
+	
+	//Builds the atlas pages of an instance type kfd imported with ImportKFD
+	inline vector<vector<u8>> BuildAtlasPages(
+		const GlyphHeader& header,
+		const vector<GlyphBlock>& blocks)
+	{
+		return BuildAtlasPages(
+			header,
+			blocks,
+			[](const GlyphBlock& block)
+			{
+				return span<const u8>(block.rawPixels);
+			});
+	}
+	
+	//Builds the atlas pages of an instance type kfd imported with ImportKFDPacked
+	inline vector<vector<u8>> BuildAtlasPages(
+		const GlyphHeader& header,
+		const vector<PackedGlyphBlock>& blocks,
+		const vector<u8>& pixelArena)
+	{
+		return BuildAtlasPages(
+			header,
+			blocks,
+			[&pixelArena](const PackedGlyphBlock& block)
+			{
+				return GetPackedPixels(pixelArena, block);
+			});
+	}
 }
\ No newline at end of file
@@ -0,0 +1,668 @@
+//------------------------------------------------------------------------------
+// layout_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Layout font built once from imported kfd glyphs for fast codepoint lookups
+//   - Batched UTF-8 text layout into caller-provided quad vertex buffers without allocations,
+//     decoded through the utf8_utils.hpp transcoder
+//   - Text measurement (width, ink bounds, line height) with a fixed-size memo cache
+//------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+
+# Layout output
+
+Each laid out glyph writes four LayoutVertex values in the same order as the
+kfd block vertices, so the kfd header indices (0, 1, 2, 2, 3, 0) can be reused
+for every quad with a base vertex of glyph index * 4.
+
+Vertex | Corner
+-------|--------------
+0      | top-left
+1      | top-right
+2      | bottom-right
+3      | bottom-left
+
+Positions are y-up like the kfd vertices, the pen y position is the baseline.
+Glyphs without pixels (like space) only move the pen and write no quad.
+
+Fonts compiled with subpixel phases snap every quad to a whole pixel and pick
+the phase variant nearest to the fractional pen x position instead, so glyph
+positions stay smooth while every quad still maps its texels one to one.
+
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <cmath>
+
+#include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/utf8_utils.hpp"
+
+//static_cast
+#ifndef scast
+	#define scast static_cast
+#endif
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::array;
+	using std::string_view;
+	using std::lower_bound;
+	using std::sort;
+	using std::min;
+	using std::max;
+	using std::atomic;
+	using std::bit_ceil;
+	using std::floor;
+	
+	using KalaHeaders::KalaUTF8::UTF8ToUTF32;
+	using KalaHeaders::KalaUTF8::TranscodeResult;
+	
+	using f32 = float;
+	using u64 = uint64_t;
+	
+	//Codepoint that is drawn when the font has no glyph for the requested codepoint
+	constexpr u32 LAYOUT_MISSING_CODEPOINT = '?';
+	
+	//Codepoints below this are found with a direct lookup instead of a binary search
+	constexpr u32 LAYOUT_DIRECT_LOOKUP_SIZE = 256u;
+	
+	//How many codepoints LayoutText decodes at once before laying them out
+	constexpr u32 LAYOUT_DECODE_CHUNK = 256u;
+	
+	//Default slot count of MeasureCache, always rounded up to a power of two
+	constexpr u32 MEASURE_CACHE_DEFAULT_SLOTS = 4096u;
+	
+	//How many neighbouring slots MeasureCache checks before replacing the oldest one
+	constexpr u32 MEASURE_CACHE_MAX_PROBE = 8u;
+	
+	//One corner of a laid out glyph quad
+	struct LayoutVertex
+	{
+		f32 x{};
+		f32 y{};
+		f32 u{};
+		f32 v{};
+	};
+	
+	//Precomputed quad of one glyph relative to the pen position
+	struct LayoutGlyph
+	{
+		f32 x0{};      //left edge
+		f32 y0{};      //bottom edge
+		f32 x1{};      //right edge
+		f32 y1{};      //top edge
+		f32 u0{};      //left uv
+		f32 v0{};      //top uv
+		f32 u1{};      //right uv
+		f32 v1{};      //bottom uv
+		f32 advance{}; //how far the pen moves after this glyph
+		u32 hasQuad{}; //1 if this glyph has pixels, 0 if it only moves the pen
+	};
+	
+	//Returned by LayoutText so long text can be laid out over several calls
+	struct LayoutResult
+	{
+		u32 glyphCount{};   //how many quads were written
+		size_t bytesRead{}; //how many bytes of the text were consumed
+		f32 penX{};         //pen x position after the last consumed codepoint
+		f32 penY{};         //pen y position after the last consumed codepoint
+	};
+	
+	//Glyph lookup and precomputed quads of one kfd font,
+	//build it once after import and reuse it for every LayoutText call
+	struct LayoutFont
+	{
+		u64 fontID{};                        //unique per BuildLayoutFont call, used as the font part of cache keys
+		f32 lineHeight{};                    //how far the pen moves down after '\n'
+		vector<LayoutGlyph> glyphs{};        //one per imported glyph in import order, plus one empty glyph
+		vector<u32> charCodes{};             //glyph char codes, same order as glyphs
+		array<u16, LAYOUT_DIRECT_LOOKUP_SIZE> directLookup{}; //glyph index of each codepoint below LAYOUT_DIRECT_LOOKUP_SIZE
+		vector<u32> sortedCodes{};           //codepoints at or above LAYOUT_DIRECT_LOOKUP_SIZE, sorted
+		vector<u16> sortedIndices{};         //glyph index of each sorted codepoint
+		u16 missingIndex{};                  //glyph index used for codepoints this font does not have
+		u32 phaseCount = 1;                  //horizontal subpixel phases the font was compiled with
+		vector<u16> phaseGlyphs{};           //glyph index of each (glyph, phase) pair, only filled if phaseCount > 1
+		
+		//Returns the glyph index of a codepoint, or missingIndex if the font does not have it
+		inline u16 Find(u32 codepoint) const
+		{
+			if (codepoint < LAYOUT_DIRECT_LOOKUP_SIZE) return directLookup[codepoint];
+			
+			auto it = lower_bound(sortedCodes.begin(), sortedCodes.end(), codepoint);
+			if (it == sortedCodes.end()
+				|| *it != codepoint)
+			{
+				return missingIndex;
+			}
+			
+			return sortedIndices[scast<size_t>(it - sortedCodes.begin())];
+		}
+		
+		//Returns the glyph index of the subpixel phase variant of a glyph,
+		//the glyph itself if the font has no variant for that phase
+		inline u16 FindPhase(
+			u16 glyphIndex,
+			u32 phase) const
+		{
+			return phaseGlyphs[scast<size_t>(glyphIndex) * phaseCount + phase];
+		}
+		
+		//Overrides the uv rect of a glyph, for example after placing it into an atlas
+		inline void SetGlyphUV(
+			u16 glyphIndex,
+			f32 u0,
+			f32 v0,
+			f32 u1,
+			f32 v1)
+		{
+			if (glyphIndex >= glyphs.size()) return;
+			
+			LayoutGlyph& g = glyphs[glyphIndex];
+			g.u0 = u0;
+			g.v0 = v0;
+			g.u1 = u1;
+			g.v1 = v1;
+		}
+	};
+	
+	//Returns a new font id, never 0
+	inline u64 NextLayoutFontID()
+	{
+		static atomic<u64> lastFontID{};
+		return ++lastFontID;
+	}
+	
+	//Builds the layout font from imported glyphs. Works with GlyphBlock,
+	//PackedGlyphBlock and GlyphMetrics since it only reads their metrics
+	template<typename T>
+	inline LayoutFont BuildLayoutFont(
+		const GlyphHeader& header,
+		const vector<T>& blocks)
+	{
+		LayoutFont font{};
+		font.fontID = NextLayoutFontID();
+		font.lineHeight = scast<f32>(header.glyphHeight);
+		
+		//one extra empty glyph at the end for fonts without LAYOUT_MISSING_CODEPOINT
+		
+		font.glyphs.resize(blocks.size() + 1);
+		font.charCodes.resize(blocks.size() + 1);
+		
+		u16 emptyIndex = scast<u16>(blocks.size());
+		font.missingIndex = emptyIndex;
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const T& b = blocks[i];
+			LayoutGlyph& g = font.glyphs[i];
+			
+			g.x0 = scast<f32>(b.bearingX);
+			g.y0 = scast<f32>(b.bearingY - b.height);
+			g.x1 = scast<f32>(b.bearingX + b.width);
+			g.y1 = scast<f32>(b.bearingY);
+			
+			g.u0 = scast<f32>(header.uvs[0][0]);
+			g.v0 = scast<f32>(header.uvs[0][1]);
+			g.u1 = scast<f32>(header.uvs[2][0]);
+			g.v1 = scast<f32>(header.uvs[2][1]);
+			
+			g.advance = scast<f32>(b.advance);
+			g.hasQuad = (b.width > 0 && b.height > 0) ? 1u : 0u;
+			
+			font.charCodes[i] = b.charCode;
+			
+			if (b.charCode == LAYOUT_MISSING_CODEPOINT) font.missingIndex = scast<u16>(i);
+			
+			u32 phase = GetSubpixelPhase(b.charCode);
+			if (phase < KFD_MAX_SUBPIXEL_PHASES) font.phaseCount = max(font.phaseCount, phase + 1);
+		}
+		
+		font.directLookup.fill(font.missingIndex);
+		
+		vector<u32> order{};
+		order.reserve(blocks.size());
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			u32 code = blocks[i].charCode;
+			
+			//phase variants are only reached through phaseGlyphs
+			if (GetSubpixelPhase(code) != 0) continue;
+			
+			if (code < LAYOUT_DIRECT_LOOKUP_SIZE) font.directLookup[code] = scast<u16>(i);
+			else order.push_back(scast<u32>(i));
+		}
+		
+		sort(
+			order.begin(),
+			order.end(),
+			[&blocks](u32 a, u32 b)
+			{
+				return blocks[a].charCode < blocks[b].charCode;
+			});
+		
+		font.sortedCodes.reserve(order.size());
+		font.sortedIndices.reserve(order.size());
+		
+		for (u32 i : order)
+		{
+			font.sortedCodes.push_back(blocks[i].charCode);
+			font.sortedIndices.push_back(scast<u16>(i));
+		}
+		
+		if (font.phaseCount > 1)
+		{
+			//every glyph starts out as its own variant for every phase
+			
+			font.phaseGlyphs.resize(font.glyphs.size() * font.phaseCount);
+			for (size_t i = 0; i < font.glyphs.size(); ++i)
+			{
+				for (u32 p = 0; p < font.phaseCount; ++p)
+				{
+					font.phaseGlyphs[i * font.phaseCount + p] = scast<u16>(i);
+				}
+			}
+			
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				u32 phase = GetSubpixelPhase(blocks[i].charCode);
+				if (phase == 0
+					|| phase >= font.phaseCount)
+				{
+					continue;
+				}
+				
+				u16 baseIndex = font.Find(GetBaseCharCode(blocks[i].charCode));
+				if (baseIndex == font.missingIndex
+					&& font.charCodes[baseIndex] != GetBaseCharCode(blocks[i].charCode))
+				{
+					continue;
+				}
+				
+				font.phaseGlyphs[scast<size_t>(baseIndex) * font.phaseCount + phase] = scast<u16>(i);
+			}
+		}
+		
+		return font;
+	}
+	
+	//Returns the subpixel phase variant a glyph drawn at penX uses and writes the whole pixel its
+	//quad is snapped to into outPixel. Kfd advances are whole pixels, so every glyph of a line shares
+	//the phase and pixel offset of the pen position the line started at
+	inline u32 GetPenPhase(
+		const LayoutFont& font,
+		f32 penX,
+		f32& outPixel)
+	{
+		outPixel = floor(penX);
+		if (font.phaseCount <= 1) return 0;
+		
+		//use the variant rendered nearest to the fraction
+		
+		u32 phase = scast<u32>((penX - outPixel) * scast<f32>(font.phaseCount) + 0.5f);
+		if (phase >= font.phaseCount)
+		{
+			phase = 0;
+			outPixel += 1.0f;
+		}
+		
+		return phase;
+	}
+	
+	//Lays out UTF-8 text starting from the pen position and writes four vertices per visible glyph
+	//into outVertices, which must have room for maxGlyphs * 4 vertices. If outGlyphIndices is not null
+	//it receives the glyph index of each written quad so the caller can pick its texture.
+	//Stops early when maxGlyphs quads have been written, continue from result.bytesRead and the returned pen
+	inline LayoutResult LayoutText(
+		const LayoutFont& font,
+		string_view text,
+		f32 penX,
+		f32 penY,
+		LayoutVertex* outVertices,
+		u16* outGlyphIndices,
+		u32 maxGlyphs)
+	{
+		const u8* bytes = rcast<const u8*>(text.data());
+		const size_t size = text.size();
+		const LayoutGlyph* glyphs = font.glyphs.data();
+		
+		const f32 originX = penX;
+		
+		const bool hasPhases = font.phaseCount > 1;
+		
+		//the phase is picked once, quads then move along their own whole pixel pen
+		//so nothing but the advance sits between two glyphs
+		
+		f32 originPixel{};
+		const u32 phase = GetPenPhase(font, originX, originPixel);
+		
+		f32 quadPenX = hasPhases ? originPixel : penX;
+		
+		//one scratch slot so invisible glyphs can write unconditionally
+		u16 discardIndex{};
+		
+		size_t i{};
+		u32 count{};
+		
+		u32 codepoints[LAYOUT_DECODE_CHUNK];
+		
+		while (i < size
+			&& count < maxGlyphs)
+		{
+			//never decode more codepoints than there are free quads so the whole chunk always fits
+			
+			size_t chunkSize = min(scast<size_t>(LAYOUT_DECODE_CHUNK), scast<size_t>(maxGlyphs - count));
+			
+			TranscodeResult decoded = UTF8ToUTF32(
+				bytes + i,
+				size - i,
+				codepoints,
+				chunkSize);
+			
+			i += decoded.bytesRead;
+			
+			for (size_t k = 0; k < decoded.codepointCount; ++k)
+			{
+				u32 codepoint = codepoints[k];
+				
+				if (codepoint == '\n')
+				{
+					penX = originX;
+					quadPenX = hasPhases ? originPixel : originX;
+					penY -= font.lineHeight;
+					continue;
+				}
+				
+				u16 index = font.Find(codepoint);
+				if (hasPhases) index = font.FindPhase(index, phase);
+				
+				const f32 quadX = quadPenX;
+				
+				const LayoutGlyph& g = glyphs[index];
+				
+				//always write the quad, only keep it if the glyph has pixels
+				
+				LayoutVertex* v = outVertices + scast<size_t>(count) * 4;
+				
+				f32 left = quadX + g.x0;
+				f32 right = quadX + g.x1;
+				f32 top = penY + g.y1;
+				f32 bottom = penY + g.y0;
+				
+				v[0] = { left,  top,    g.u0, g.v0 }; //top-left
+				v[1] = { right, top,    g.u1, g.v0 }; //top-right
+				v[2] = { right, bottom, g.u1, g.v1 }; //bottom-right
+				v[3] = { left,  bottom, g.u0, g.v1 }; //bottom-left
+				
+				u16* indexTarget = outGlyphIndices ? outGlyphIndices + count : &discardIndex;
+				*indexTarget = index;
+				
+				count += g.hasQuad;
+				penX += g.advance;
+				quadPenX += g.advance;
+			}
+		}
+		
+		return LayoutResult
+		{
+			.glyphCount = count,
+			.bytesRead = i,
+			.penX = penX,
+			.penY = penY
+		};
+	}
+	
+	//Returned by MeasureText, every value is relative to the pen origin on the first baseline, y-up
+	struct TextMetrics
+	{
+		f32 width{};      //pen advance of the widest line
+		f32 inkLeft{};    //left edge of all glyph quads
+		f32 inkBottom{};  //bottom edge of all glyph quads
+		f32 inkRight{};   //right edge of all glyph quads
+		f32 inkTop{};     //top edge of all glyph quads
+		f32 lineHeight{}; //how far each '\n' moves the pen down
+		u32 lineCount{};  //how many lines the text has, 0 for empty text
+	};
+	
+	//Measures UTF-8 text the same way LayoutText would lay it out, without writing any vertices.
+	//Ink bounds are all 0 if no glyph has pixels
+	inline TextMetrics MeasureText(
+		const LayoutFont& font,
+		string_view text)
+	{
+		const u8* bytes = rcast<const u8*>(text.data());
+		const size_t size = text.size();
+		const LayoutGlyph* glyphs = font.glyphs.data();
+		
+		TextMetrics m{};
+		m.lineHeight = font.lineHeight;
+		if (size == 0) return m;
+		
+		m.lineCount = 1;
+		
+		f32 penX{};
+		f32 penY{};
+		bool hasInk{};
+		
+		size_t i{};
+		u32 codepoints[LAYOUT_DECODE_CHUNK];
+		
+		while (i < size)
+		{
+			TranscodeResult decoded = UTF8ToUTF32(
+				bytes + i,
+				size - i,
+				codepoints,
+				LAYOUT_DECODE_CHUNK);
+			
+			i += decoded.bytesRead;
+			
+			for (size_t k = 0; k < decoded.codepointCount; ++k)
+			{
+				u32 codepoint = codepoints[k];
+				
+				if (codepoint == '\n')
+				{
+					m.width = max(m.width, penX);
+					penX = 0.0f;
+					penY -= font.lineHeight;
+					++m.lineCount;
+					continue;
+				}
+				
+				const LayoutGlyph& g = glyphs[font.Find(codepoint)];
+				
+				if (g.hasQuad)
+				{
+					f32 left = penX + g.x0;
+					f32 right = penX + g.x1;
+					f32 top = penY + g.y1;
+					f32 bottom = penY + g.y0;
+					
+					if (!hasInk)
+					{
+						m.inkLeft = left;
+						m.inkRight = right;
+						m.inkTop = top;
+						m.inkBottom = bottom;
+						hasInk = true;
+					}
+					else
+					{
+						m.inkLeft = min(m.inkLeft, left);
+						m.inkRight = max(m.inkRight, right);
+						m.inkTop = max(m.inkTop, top);
+						m.inkBottom = min(m.inkBottom, bottom);
+					}
+				}
+				
+				penX += g.advance;
+			}
+		}
+		
+		m.width = max(m.width, penX);
+		
+		return m;
+	}
+	
+	//Hashes a (font id, text) cache key, never returns 0.
+	//Multiply-xorshift over 8 bytes at a time and FNV-1a over the remaining bytes
+	inline u64 HashLayoutText(
+		u64 fontID,
+		string_view text)
+	{
+		const char* data = text.data();
+		const size_t size = text.size();
+		
+		u64 hash = (fontID ^ 14695981039346656037ull) * 0x9E3779B97F4A7C15ull;
+		
+		size_t i{};
+		for (; i + 8 <= size; i += 8)
+		{
+			u64 word{};
+			memcpy(&word, data + i, 8);
+			
+			hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+			hash ^= hash >> 32;
+		}
+		for (; i < size; ++i)
+		{
+			hash ^= scast<u8>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		
+		//final avalanche so the low bits used for the slot index depend on every byte
+		
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+		
+		return hash == 0 ? 1 : hash;
+	}
+	
+	//Hit and miss counters of a MeasureCache
+	struct MeasureCacheStats
+	{
+		u64 hits{};      //lookups answered from the cache
+		u64 misses{};    //lookups that had to measure the text
+		u64 evictions{}; //misses that replaced an older entry
+		
+		inline f32 GetHitRate() const
+		{
+			u64 total = hits + misses;
+			return total == 0 ? 0.0f : scast<f32>(hits) / scast<f32>(total);
+		}
+	};
+	
+	//Fixed-size open-addressed memo cache for MeasureText keyed by a hash of (font, text).
+	//Never allocates after construction, a full probe window replaces its least recently used entry.
+	//Entries are matched by their 64-bit hash, font id and text size without keeping the text.
+	//Not thread safe, use one cache per thread
+	class MeasureCache
+	{
+	public:
+		explicit MeasureCache(u32 slotCount = MEASURE_CACHE_DEFAULT_SLOTS)
+		{
+			slotCount = bit_ceil(max(slotCount, MEASURE_CACHE_MAX_PROBE));
+			
+			slots.resize(slotCount);
+			slotMask = slotCount - 1;
+		}
+		
+		//Returns the cached metrics of this text, measures and stores them on a miss
+		TextMetrics MeasureText(
+			const LayoutFont& font,
+			string_view text)
+		{
+			const u64 hash = HashLayoutText(font.fontID, text);
+			const u32 textSize = scast<u32>(text.size());
+			const u32 start = scast<u32>(hash) & slotMask;
+			
+			++clock;
+			
+			//the whole window is always checked since Invalidate leaves holes in it
+			
+			Slot* replace = nullptr;
+			for (u32 p = 0; p < MEASURE_CACHE_MAX_PROBE; ++p)
+			{
+				Slot& s = slots[(start + p) & slotMask];
+				
+				if (s.hash == hash
+					&& s.fontID == font.fontID
+					&& s.textSize == textSize)
+				{
+					s.lastUsed = clock;
+					++stats.hits;
+					return s.metrics;
+				}
+				
+				if (!replace
+					|| (replace->hash != 0
+					&& (s.hash == 0 || s.lastUsed < replace->lastUsed)))
+				{
+					replace = &s;
+				}
+			}
+			
+			++stats.misses;
+			if (replace->hash != 0) ++stats.evictions;
+			
+			replace->hash = hash;
+			replace->fontID = font.fontID;
+			replace->textSize = textSize;
+			replace->lastUsed = clock;
+			replace->metrics = KalaFontData::MeasureText(font, text);
+			
+			return replace->metrics;
+		}
+		
+		//Drops every entry of one font, call it when the kfd behind that font is reloaded
+		void Invalidate(u64 fontID)
+		{
+			for (auto& s : slots)
+			{
+				if (s.fontID == fontID) s = Slot{};
+			}
+		}
+		
+		//Drops every entry, the counters are kept
+		void Clear()
+		{
+			for (auto& s : slots) s = Slot{};
+		}
+		
+		const MeasureCacheStats& GetStats() const { return stats; }
+		void ResetStats() { stats = MeasureCacheStats{}; }
+	private:
+		struct Slot
+		{
+			u64 hash{};     //0 marks an empty slot
+			u64 fontID{};
+			u32 textSize{};
+			u32 lastUsed{};
+			TextMetrics metrics{};
+		};
+		
+		vector<Slot> slots{};
+		u32 slotMask{};
+		u32 clock{};
+		MeasureCacheStats stats{};
+	};
+}
\ No newline at end of file
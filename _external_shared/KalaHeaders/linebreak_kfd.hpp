@@ -0,0 +1,378 @@
+//------------------------------------------------------------------------------
+// linebreak_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Word wrapping of UTF-8 text on kfd glyph advances from layout_kfd.hpp
+//   - Greedy and minimum raggedness line breaking
+//   - Per-word widths measured once per text, width changes only reflow from the first affected line
+//------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+
+# Breaking rules
+
+Text is split into paragraphs at '\n' and every paragraph into words at ' ' and '\t'.
+Spaces and tabs after a word are not counted in the line width, spaces in front of
+the first word of a paragraph are kept as its indent. A word that is wider than
+the line width gets a line of its own and overflows it, words are never split.
+
+Line byte offsets point into the text passed to SetText, so that text must
+outlive the LineBreaker if the offsets are used to slice it.
+
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <limits>
+
+#include "KalaHeaders/layout_kfd.hpp"
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::string_view;
+	using std::upper_bound;
+	using std::max;
+	using std::numeric_limits;
+	
+	using KalaHeaders::KalaUTF8::DecodeUTF8;
+	
+	using f64 = double;
+	
+	enum class LineBreakMode : u8
+	{
+		BREAK_GREEDY         = 0, //fill every line as much as possible, reflows only from the first affected line
+		BREAK_MIN_RAGGEDNESS = 1  //minimize the squared free space of every line except the last line of a paragraph
+	};
+	
+	//One broken line
+	struct LineInfo
+	{
+		size_t byteStart{}; //offset of the first byte of the line
+		size_t byteEnd{};   //offset past the last visible byte of the line, trailing spaces excluded
+		f32 width{};        //pen advance from the line start to the end of its last word
+		u32 firstWord{};    //index of the first word of the line
+		u32 wordCount{};    //how many words the line has, 0 for empty lines
+	};
+	
+	//Breaks one text into lines and keeps the result so a new width only reflows what changed.
+	//Not thread safe, each thread needs its own LineBreaker
+	class LineBreaker
+	{
+	public:
+		//Splits the text into paragraphs and words and measures every word once,
+		//call it again when the text or the font changes
+		void SetText(
+			const LayoutFont& font,
+			string_view text)
+		{
+			wordStart.clear();
+			wordEnd.clear();
+			wordByteStart.clear();
+			wordByteEnd.clear();
+			paragraphs.clear();
+			lines.clear();
+			hasLines = false;
+			
+			const u8* bytes = rcast<const u8*>(text.data());
+			const size_t size = text.size();
+			
+			//pen position from the start of the text, f64 so long texts keep exact sums
+			f64 pen{};
+			f64 paragraphPen{};
+			
+			Paragraph paragraph{};
+			bool isInWord{};
+			
+			size_t i{};
+			while (i <= size)
+			{
+				size_t codepointStart = i;
+				
+				if (i == size
+					|| bytes[i] == '\n')
+				{
+					if (isInWord)
+					{
+						wordEnd.push_back(pen);
+						wordByteEnd.push_back(codepointStart);
+						isInWord = false;
+					}
+					
+					paragraph.endWord = scast<u32>(wordStart.size());
+					paragraphs.push_back(paragraph);
+					
+					paragraph = Paragraph
+					{
+						.firstWord = paragraph.endWord,
+						.endWord = paragraph.endWord,
+						.byteStart = i + 1
+					};
+					paragraphPen = pen;
+					
+					++i;
+					continue;
+				}
+				
+				u32 codepoint = DecodeUTF8(bytes, size, i);
+				
+				if (codepoint == ' '
+					|| codepoint == '\t')
+				{
+					if (isInWord)
+					{
+						wordEnd.push_back(pen);
+						wordByteEnd.push_back(codepointStart);
+						isInWord = false;
+					}
+				}
+				else if (!isInWord)
+				{
+					//the first word of a paragraph starts at the paragraph start to keep its indent
+					
+					bool isFirst = wordStart.size() == paragraph.firstWord;
+					
+					wordStart.push_back(isFirst ? paragraphPen : pen);
+					wordByteStart.push_back(isFirst ? paragraph.byteStart : codepointStart);
+					isInWord = true;
+				}
+				
+				pen += font.glyphs[font.Find(codepoint)].advance;
+			}
+		}
+		
+		//Breaks the text to fit maxWidth. Greedy breaking keeps every line in front of the
+		//first line that no longer fits or could now take the next word, paragraphs that are
+		//not affected at all are kept as they are. Returns the same lines as GetLines
+		const vector<LineInfo>& Break(
+			f32 maxWidth,
+			LineBreakMode mode = LineBreakMode::BREAK_GREEDY)
+		{
+			if (hasLines
+				&& maxWidth == lastWidth
+				&& mode == lastMode)
+			{
+				return lines;
+			}
+			
+			const f64 width = scast<f64>(maxWidth);
+			
+			//old lines are only reused by greedy to greedy reflows
+			
+			bool canReuse =
+				hasLines
+				&& mode == LineBreakMode::BREAK_GREEDY
+				&& lastMode == LineBreakMode::BREAK_GREEDY;
+			
+			scratchLines.clear();
+			
+			size_t oldLine{};
+			for (const auto& p : paragraphs)
+			{
+				if (p.firstWord == p.endWord)
+				{
+					scratchLines.push_back(LineInfo
+					{
+						.byteStart = p.byteStart,
+						.byteEnd = p.byteStart,
+						.width = 0.0f,
+						.firstWord = p.firstWord,
+						.wordCount = 0
+					});
+					
+					++oldLine;
+					continue;
+				}
+				
+				u32 reflowWord = p.firstWord;
+				
+				if (canReuse)
+				{
+					//keep old lines of this paragraph until the first one that is not valid anymore
+					
+					while (oldLine < lines.size()
+						&& lines[oldLine].firstWord < p.endWord)
+					{
+						const LineInfo& line = lines[oldLine++];
+						
+						if (reflowWord != line.firstWord
+							|| !IsGreedyLineValid(line, p, width))
+						{
+							continue;
+						}
+						
+						scratchLines.push_back(line);
+						reflowWord = line.firstWord + line.wordCount;
+					}
+				}
+				
+				if (reflowWord == p.endWord) continue;
+				
+				if (mode == LineBreakMode::BREAK_MIN_RAGGEDNESS)
+				{
+					BreakMinRaggedness(p, width);
+				}
+				else BreakGreedy(p, reflowWord, width);
+			}
+			
+			lines.swap(scratchLines);
+			
+			hasLines = true;
+			lastWidth = maxWidth;
+			lastMode = mode;
+			
+			return lines;
+		}
+		
+		const vector<LineInfo>& GetLines() const { return lines; }
+		size_t GetWordCount() const { return wordStart.size(); }
+		size_t GetParagraphCount() const { return paragraphs.size(); }
+	private:
+		struct Paragraph
+		{
+			u32 firstWord{};
+			u32 endWord{};      //one past the last word of the paragraph
+			size_t byteStart{};
+		};
+		
+		//A greedy line stays the same if it still fits, or only holds one word,
+		//and the next word of its paragraph still does not fit on it
+		bool IsGreedyLineValid(
+			const LineInfo& line,
+			const Paragraph& p,
+			f64 width) const
+		{
+			u32 lastWord = line.firstWord + line.wordCount - 1;
+			f64 start = wordStart[line.firstWord];
+			
+			bool fits =
+				line.wordCount == 1
+				|| wordEnd[lastWord] - start <= width;
+			
+			bool isFull =
+				lastWord + 1 == p.endWord
+				|| wordEnd[lastWord + 1] - start > width;
+			
+			return fits && isFull;
+		}
+		
+		void PushLine(
+			u32 firstWord,
+			u32 lastWord)
+		{
+			scratchLines.push_back(LineInfo
+			{
+				.byteStart = wordByteStart[firstWord],
+				.byteEnd = wordByteEnd[lastWord],
+				.width = scast<f32>(wordEnd[lastWord] - wordStart[firstWord]),
+				.firstWord = firstWord,
+				.wordCount = lastWord - firstWord + 1
+			});
+		}
+		
+		//Word ends only grow, so the last word of every line is found with a binary search
+		void BreakGreedy(
+			const Paragraph& p,
+			u32 firstWord,
+			f64 width)
+		{
+			while (firstWord < p.endWord)
+			{
+				f64 limit = wordStart[firstWord] + width;
+				
+				auto it = upper_bound(
+					wordEnd.begin() + firstWord,
+					wordEnd.begin() + p.endWord,
+					limit);
+				
+				u32 lastWord = scast<u32>(it - wordEnd.begin());
+				lastWord = lastWord > firstWord ? lastWord - 1 : firstWord;
+				
+				PushLine(firstWord, lastWord);
+				firstWord = lastWord + 1;
+			}
+		}
+		
+		//Dynamic programming from the last word backwards, the cost of a line is its squared
+		//free space and the last line of the paragraph is free
+		void BreakMinRaggedness(
+			const Paragraph& p,
+			f64 width)
+		{
+			const u32 count = p.endWord - p.firstWord;
+			
+			if (wordEnd[p.endWord - 1] - wordStart[p.firstWord] <= width)
+			{
+				PushLine(p.firstWord, p.endWord - 1);
+				return;
+			}
+			
+			cost.assign(count + 1, 0.0);
+			nextBreak.assign(count + 1, count);
+			
+			for (u32 i = count; i-- > 0;)
+			{
+				const u32 first = p.firstWord + i;
+				const f64 start = wordStart[first];
+				
+				f64 best = numeric_limits<f64>::max();
+				u32 bestNext = i + 1;
+				
+				for (u32 j = i; j < count; ++j)
+				{
+					f64 lineWidth = wordEnd[p.firstWord + j] - start;
+					if (lineWidth > width
+						&& j > i)
+					{
+						break;
+					}
+					
+					f64 slack = width - lineWidth;
+					f64 lineCost = j + 1 == count ? 0.0 : slack * slack;
+					f64 total = lineCost + cost[j + 1];
+					
+					if (total < best)
+					{
+						best = total;
+						bestNext = j + 1;
+					}
+				}
+				
+				cost[i] = best;
+				nextBreak[i] = bestNext;
+			}
+			
+			for (u32 i = 0; i < count; i = nextBreak[i])
+			{
+				PushLine(p.firstWord + i, p.firstWord + nextBreak[i] - 1);
+			}
+		}
+		
+		//per word, in the order they appear in the text
+		vector<f64> wordStart{};       //pen position where the word starts, the paragraph start for first words
+		vector<f64> wordEnd{};         //pen position after the last glyph of the word
+		vector<size_t> wordByteStart{};
+		vector<size_t> wordByteEnd{};
+		
+		vector<Paragraph> paragraphs{};
+		
+		vector<LineInfo> lines{};
+		vector<LineInfo> scratchLines{};
+		
+		//minimum raggedness scratch
+		vector<f64> cost{};
+		vector<u32> nextBreak{};
+		
+		bool hasLines{};
+		f32 lastWidth{};
+		LineBreakMode lastMode{};
+	};
+}
\ No newline at end of file
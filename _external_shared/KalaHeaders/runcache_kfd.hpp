@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+// runcache_kfd.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Glyph run cache that keeps laid out vertices of repeated strings from layout_kfd.hpp
+//   - Origin-free runs that are copied with a pen offset instead of being laid out again
+//   - Memory budget with least recently used eviction and per-font invalidation
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+
+#include "KalaHeaders/layout_kfd.hpp"
+
+namespace KalaHeaders::KalaFontData
+{
+	using std::vector;
+	using std::string;
+	using std::string_view;
+	using std::list;
+	using std::unordered_map;
+	using std::prev;
+	
+	//Default memory budget of GlyphRunCache in bytes
+	constexpr size_t RUN_CACHE_DEFAULT_BUDGET = 8u * 1024u * 1024u;
+	
+	//One laid out string with its pen origin at 0, 0, or at phase / phaseCount, 0 for one subpixel phase
+	//of a font with phases, so its quads sit on whole pixels like LayoutText places them
+	struct GlyphRun
+	{
+		vector<LayoutVertex> vertices{}; //four per quad, same order as LayoutText
+		vector<u16> glyphIndices{};      //glyph index of each quad
+		u32 glyphCount{};                //how many quads the run has
+		f32 penX{};                      //pen x position after the run
+		f32 penY{};                      //pen y position after the run
+	};
+	
+	//Hit and miss counters and memory use of a GlyphRunCache
+	struct RunCacheStats
+	{
+		u64 hits{};      //runs answered from the cache
+		u64 misses{};    //runs that had to be laid out
+		u64 evictions{}; //runs dropped to stay inside the memory budget
+		size_t bytesUsed{};
+		size_t runCount{};
+	};
+	
+	//Keeps laid out runs of (font, text) keys inside a memory budget, the least recently used
+	//run is dropped first. Returned runs stay valid until the next call that can add or drop runs.
+	//Runs are keyed by LayoutFont::fontID, so a rebuilt font never hits old runs, call
+	//InvalidateFont when a kfd is reloaded or after SetGlyphUV to free the old runs right away.
+	//Not thread safe, use one cache per thread
+	class GlyphRunCache
+	{
+	public:
+		explicit GlyphRunCache(size_t maxBytes = RUN_CACHE_DEFAULT_BUDGET)
+			: budget(maxBytes) {}
+		
+		//Returns the cached run of this text, lays it out and stores it on a miss.
+		//Fonts with subpixel phases keep one run per phase, get the phase of a pen position with GetPenPhase.
+		//Runs bigger than the whole budget are laid out every time and never stored
+		const GlyphRun& GetRun(
+			const LayoutFont& font,
+			string_view text,
+			u32 phase = 0)
+		{
+			if (phase >= font.phaseCount) phase = 0;
+			
+			const u64 hash = HashLayoutText(font.fontID, text) ^ (scast<u64>(phase) * 0x9E3779B97F4A7C15ull);
+			
+			auto found = index.find(hash);
+			if (found != index.end())
+			{
+				Entry& e = *found->second;
+				
+				if (e.fontID == font.fontID
+					&& e.phase == phase
+					&& e.text == text)
+				{
+					//move to the front of the recently used list
+					
+					entries.splice(entries.begin(), entries, found->second);
+					++stats.hits;
+					return e.run;
+				}
+				
+				//hash collision, the new run replaces the old one
+				Drop(found->second);
+			}
+			
+			++stats.misses;
+			
+			GlyphRun run = Layout(font, text, phase);
+			size_t cost = GetCost(text, run);
+			
+			if (cost > budget)
+			{
+				oversizedRun = move(run);
+				return oversizedRun;
+			}
+			
+			while (stats.bytesUsed + cost > budget
+				&& !entries.empty())
+			{
+				Drop(prev(entries.end()));
+				++stats.evictions;
+			}
+			
+			entries.push_front(Entry
+			{
+				.hash = hash,
+				.fontID = font.fontID,
+				.phase = phase,
+				.text = string(text),
+				.run = move(run),
+				.cost = cost
+			});
+			index[hash] = entries.begin();
+			
+			stats.bytesUsed += cost;
+			stats.runCount = entries.size();
+			
+			return entries.front().run;
+		}
+		
+		//Writes the run of this text at the pen position into outVertices and outGlyphIndices
+		//the same way LayoutText would, fonts with subpixel phases use the run of the pen phase
+		//and snap it to the same whole pixel. Returns how many quads were written.
+		//outVertices needs room for maxGlyphs * 4 vertices, outGlyphIndices can be null
+		u32 EmitRun(
+			const LayoutFont& font,
+			string_view text,
+			f32 penX,
+			f32 penY,
+			LayoutVertex* outVertices,
+			u16* outGlyphIndices,
+			u32 maxGlyphs)
+		{
+			//runs of fonts with phases already hold the fraction, only whole pixels are added
+			
+			f32 offsetX = penX;
+			u32 phase{};
+			if (font.phaseCount > 1) phase = GetPenPhase(font, penX, offsetX);
+			
+			const GlyphRun& run = GetRun(font, text, phase);
+			
+			u32 count = min(run.glyphCount, maxGlyphs);
+			size_t vertexCount = scast<size_t>(count) * 4;
+			
+			const LayoutVertex* in = run.vertices.data();
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				LayoutVertex v = in[i];
+				v.x += offsetX;
+				v.y += penY;
+				outVertices[i] = v;
+			}
+			
+			if (outGlyphIndices
+				&& count > 0)
+			{
+				memcpy(outGlyphIndices, run.glyphIndices.data(), count * sizeof(u16));
+			}
+			
+			return count;
+		}
+		
+		//Drops every run of one font, returns how many were dropped
+		size_t InvalidateFont(u64 fontID)
+		{
+			size_t count{};
+			
+			for (auto it = entries.begin(); it != entries.end();)
+			{
+				auto following = it;
+				++following;
+				if (it->fontID == fontID)
+				{
+					Drop(it);
+					++count;
+				}
+				it = following;
+			}
+			
+			return count;
+		}
+		
+		//Drops every run, the counters are kept
+		void Clear()
+		{
+			entries.clear();
+			index.clear();
+			oversizedRun = GlyphRun{};
+			
+			stats.bytesUsed = 0;
+			stats.runCount = 0;
+		}
+		
+		//Changes the memory budget and drops the oldest runs until the cache fits
+		void SetBudget(size_t maxBytes)
+		{
+			budget = maxBytes;
+			
+			while (stats.bytesUsed > budget
+				&& !entries.empty())
+			{
+				Drop(prev(entries.end()));
+				++stats.evictions;
+			}
+		}
+		
+		const RunCacheStats& GetStats() const { return stats; }
+		void ResetStats()
+		{
+			stats.hits = 0;
+			stats.misses = 0;
+			stats.evictions = 0;
+		}
+	private:
+		struct Entry
+		{
+			u64 hash{};
+			u64 fontID{};
+			u32 phase{};
+			string text{};
+			GlyphRun run{};
+			size_t cost{};
+		};
+		
+		using EntryIt = list<Entry>::iterator;
+		
+		static GlyphRun Layout(
+			const LayoutFont& font,
+			string_view text,
+			u32 phase)
+		{
+			//one codepoint per byte at most, so the text always fits in one call
+			
+			GlyphRun run{};
+			run.vertices.resize(text.size() * 4);
+			run.glyphIndices.resize(text.size());
+			
+			const f32 originX = scast<f32>(phase) / scast<f32>(font.phaseCount);
+			
+			LayoutResult result = LayoutText(
+				font,
+				text,
+				originX,
+				0.0f,
+				run.vertices.data(),
+				run.glyphIndices.data(),
+				scast<u32>(text.size()));
+			
+			run.glyphCount = result.glyphCount;
+			run.penX = result.penX - originX;
+			run.penY = result.penY;
+			
+			run.vertices.resize(scast<size_t>(result.glyphCount) * 4);
+			run.vertices.shrink_to_fit();
+			run.glyphIndices.resize(result.glyphCount);
+			run.glyphIndices.shrink_to_fit();
+			
+			return run;
+		}
+		
+		static size_t GetCost(
+			string_view text,
+			const GlyphRun& run)
+		{
+			return sizeof(Entry)
+				+ text.size()
+				+ run.vertices.size() * sizeof(LayoutVertex)
+				+ run.glyphIndices.size() * sizeof(u16);
+		}
+		
+		void Drop(EntryIt it)
+		{
+			stats.bytesUsed -= it->cost;
+			
+			index.erase(it->hash);
+			entries.erase(it);
+			
+			stats.runCount = entries.size();
+		}
+		
+		size_t budget{};
+		
+		list<Entry> entries{}; //most recently used first
+		unordered_map<u64, EntryIt> index{};
+		
+		GlyphRun oversizedRun{};
+		RunCacheStats stats{};
+	};
+}
\ No newline at end of file
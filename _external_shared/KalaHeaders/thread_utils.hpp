@@ -11,6 +11,7 @@
 //   - lock_m, lockwait_m (where applicable) and unlock_m for mutexes
 //   - jthread (joinable thread) which returns the created thread so it can be joined
 //   - dthread (self-exiting thread)
+//   - WorkPool (persistent worker threads with work stealing parallel for loops)
 //------------------------------------------------------------------------------
 
 #pragma once
@@ -19,6 +20,11 @@
 #include <concepts>
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
 
 namespace KalaHeaders::KalaThread
 {	
@@ -39,6 +45,14 @@ namespace KalaHeaders::KalaThread
 	using std::chrono::duration;
 	using std::chrono::time_point;
 	using std::remove_cvref_t;
+	using std::vector;
+	using std::mutex;
+	using std::lock_guard;
+	using std::unique_ptr;
+	using std::make_unique;
+	using std::min;
+	using std::max;
+	using std::memory_order_acq_rel;
 	
 	using abool = atomic<bool>;
 	
@@ -311,4 +325,192 @@ namespace KalaHeaders::KalaThread
 		ptr.store(value, memory_order_release);
 		return true;
 	}
+	
+	//
+	// WORK POOL
+	//
+	
+	//Persistent worker threads for parallel for loops. Every participant starts on its own
+	//even slice of the chunks and steals single chunks from the back of other slices once
+	//its own slice is empty, so uneven chunks still finish at about the same time.
+	//Calls from several threads are run one after another, ParallelFor must not be called
+	//from inside the loop body
+	class WorkPool
+	{
+	public:
+		//threadCount 0 uses one worker per hardware thread, the calling thread always works too
+		explicit WorkPool(uint32_t threadCount = 0)
+		{
+			if (threadCount == 0)
+			{
+				threadCount = max(thread::hardware_concurrency(), 1u);
+			}
+			
+			participantCount = threadCount;
+			slices = make_unique<Slice[]>(participantCount);
+			
+			workers.reserve(threadCount - 1);
+			for (uint32_t i = 0; i + 1 < threadCount; ++i)
+			{
+				workers.push_back(jthread([this, i]() { Run(i); }));
+			}
+		}
+		~WorkPool()
+		{
+			isStopping.store(true, memory_order_release);
+			generation.fetch_add(1, memory_order_release);
+			generation.notify_all();
+			
+			for (auto& t : workers) t.join();
+		}
+		
+		WorkPool(const WorkPool&) = delete;
+		WorkPool& operator=(const WorkPool&) = delete;
+		
+		//How many threads run the loop bodies, the calling thread included
+		uint32_t GetThreadCount() const { return participantCount; }
+		
+		//Runs func(begin, end, participant) over [0, count) in chunks of chunkSize and blocks until
+		//every chunk is done. participant is below GetThreadCount and unique among the threads that
+		//run at the same time, so it can pick per-thread scratch memory
+		template <typename F>
+		void ParallelFor(
+			size_t count,
+			size_t chunkSize,
+			F&& func)
+		{
+			if (count == 0) return;
+			
+			chunkSize = max(chunkSize, size_t{ 1 });
+			size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+			
+			lock_guard<mutex> runLock(runMutex);
+			
+			//one chunk or no workers, nothing to share
+			
+			if (chunkCount == 1
+				|| workers.empty())
+			{
+				for (size_t begin = 0; begin < count; begin += chunkSize)
+				{
+					func(begin, min(begin + chunkSize, count), participantCount - 1);
+				}
+				return;
+			}
+			
+			auto body = [&func, count, chunkSize](size_t chunk, uint32_t participant)
+				{
+					size_t begin = chunk * chunkSize;
+					func(begin, min(begin + chunkSize, count), participant);
+				};
+			
+			task = &body;
+			runChunk = [](void* context, size_t chunk, uint32_t participant)
+				{
+					(*static_cast<decltype(body)*>(context))(chunk, participant);
+				};
+			
+			for (uint32_t i = 0; i < participantCount; ++i)
+			{
+				uint64_t front = chunkCount * i / participantCount;
+				uint64_t back = chunkCount * (i + 1) / participantCount;
+				slices[i].range.store(Pack(front, back), memory_order_relaxed);
+			}
+			
+			busyWorkers.store(static_cast<uint32_t>(workers.size()), memory_order_relaxed);
+			generation.fetch_add(1, memory_order_release);
+			generation.notify_all();
+			
+			RunChunks(participantCount - 1);
+			
+			for (uint32_t busy = busyWorkers.load(memory_order_acquire);
+				busy != 0;
+				busy = busyWorkers.load(memory_order_acquire))
+			{
+				busyWorkers.wait(busy, memory_order_acquire);
+			}
+		}
+	private:
+		//Front and back chunk of one slice packed into one word so the owner
+		//and thieves can both take chunks with a single compare exchange
+		struct alignas(64) Slice
+		{
+			atomic<uint64_t> range{};
+		};
+		
+		static uint64_t Pack(uint64_t front, uint64_t back) { return (front << 32) | back; }
+		static uint64_t Front(uint64_t range) { return range >> 32; }
+		static uint64_t Back(uint64_t range) { return range & 0xFFFFFFFFu; }
+		
+		void Run(uint32_t participant)
+		{
+			uint64_t seen{};
+			
+			while (true)
+			{
+				generation.wait(seen, memory_order_acquire);
+				seen = generation.load(memory_order_acquire);
+				
+				if (isStopping.load(memory_order_acquire)) return;
+				
+				RunChunks(participant);
+				
+				if (busyWorkers.fetch_sub(1, memory_order_acq_rel) == 1)
+				{
+					busyWorkers.notify_all();
+				}
+			}
+		}
+		
+		void RunChunks(uint32_t participant)
+		{
+			//own slice from the front
+			
+			Slice& own = slices[participant];
+			uint64_t range = own.range.load(memory_order_acquire);
+			while (Front(range) < Back(range))
+			{
+				if (own.range.compare_exchange_weak(
+					range,
+					Pack(Front(range) + 1, Back(range)),
+					memory_order_acq_rel))
+				{
+					runChunk(task, Front(range), participant);
+					range = own.range.load(memory_order_acquire);
+				}
+			}
+			
+			//other slices from the back until every slice is empty
+			
+			for (uint32_t offset = 1; offset < participantCount; ++offset)
+			{
+				Slice& victim = slices[(participant + offset) % participantCount];
+				
+				range = victim.range.load(memory_order_acquire);
+				while (Front(range) < Back(range))
+				{
+					if (victim.range.compare_exchange_weak(
+						range,
+						Pack(Front(range), Back(range) - 1),
+						memory_order_acq_rel))
+					{
+						runChunk(task, Back(range) - 1, participant);
+						range = victim.range.load(memory_order_acquire);
+					}
+				}
+			}
+		}
+		
+		uint32_t participantCount{};
+		vector<thread> workers{};
+		unique_ptr<Slice[]> slices{};
+		
+		mutex runMutex{};
+		void* task{};
+		void (*runChunk)(void*, size_t, uint32_t){};
+		
+		atomic<uint64_t> generation{};
+		atomic<uint32_t> busyWorkers{};
+		atomic<bool> isStopping{};
+	};
 }
\ No newline at end of file
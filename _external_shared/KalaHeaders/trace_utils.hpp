@@ -0,0 +1,286 @@
+//------------------------------------------------------------------------------
+// trace_utils.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - Scoped trace zones recorded into per-thread lock-free ring buffers
+//   - Chrome trace event json output for Perfetto and chrome://tracing
+//   - KALA_TRACE_ZONE macro that compiles to nothing unless KALA_ENABLE_TRACE is defined
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+#include <cstdint>
+
+namespace KalaHeaders::KalaTrace
+{
+	using std::atomic;
+	using std::memory_order_acquire;
+	using std::memory_order_release;
+	using std::memory_order_relaxed;
+	using std::chrono::steady_clock;
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+	using std::vector;
+	using std::unique_ptr;
+	using std::make_unique;
+	using std::mutex;
+	using std::lock_guard;
+	using std::string;
+	using std::ofstream;
+	using std::ios;
+	using std::filesystem::path;
+	using std::snprintf;
+	
+	//Events one thread can hold between flushes, newer events are dropped once it is full
+	constexpr size_t TRACE_RING_SIZE = size_t{ 1 } << 15;
+	
+	//One finished zone, times are nanoseconds since Start
+	struct TraceEvent
+	{
+		const char* name{}; //must outlive the trace, string literals are expected
+		uint64_t start{};
+		uint64_t end{};
+	};
+	
+	//Single producer single consumer ring, the owning thread writes and the flushing thread reads.
+	//Rings outlive their threads so short lived workers can still be flushed, and a ring is
+	//handed to the next new thread once its owner exits
+	struct TraceRing
+	{
+		unique_ptr<TraceEvent[]> events = make_unique<TraceEvent[]>(TRACE_RING_SIZE);
+		alignas(64) atomic<uint64_t> head{}; //next event to write
+		alignas(64) atomic<uint64_t> tail{}; //next event to read
+		atomic<uint64_t> dropped{};
+		atomic<bool> isOwned{};
+		uint32_t threadId{};
+	};
+	
+	class Trace
+	{
+	public:
+		//Clears everything recorded so far and starts recording zones
+		static void Start()
+		{
+			lock_guard<mutex> lock(registryMutex);
+			
+			for (auto& r : rings)
+			{
+				r->tail.store(r->head.load(memory_order_acquire), memory_order_release);
+				r->dropped.store(0, memory_order_relaxed);
+			}
+			flushed.clear();
+			
+			origin.store(
+				static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count()),
+				memory_order_relaxed);
+			isEnabled.store(true, memory_order_release);
+		}
+		
+		//Stops recording, recorded zones can still be written
+		static void Stop() { isEnabled.store(false, memory_order_release); }
+		
+		static bool IsEnabled() { return isEnabled.load(memory_order_relaxed); }
+		
+		//Nanoseconds since Start
+		static uint64_t Now()
+		{
+			return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count())
+				- origin.load(memory_order_relaxed);
+		}
+		
+		//Adds one finished zone to the ring of the calling thread, never blocks once the thread has a ring
+		static void Record(
+			const char* name,
+			uint64_t start,
+			uint64_t end)
+		{
+			if (end < start) return; //started before a restart
+			
+			TraceRing* ring = GetRing();
+			
+			uint64_t head = ring->head.load(memory_order_relaxed);
+			if (head - ring->tail.load(memory_order_acquire) == TRACE_RING_SIZE)
+			{
+				ring->dropped.fetch_add(1, memory_order_relaxed);
+				return;
+			}
+			
+			ring->events[head & (TRACE_RING_SIZE - 1)] = TraceEvent
+			{
+				.name = name,
+				.start = start,
+				.end = end
+			};
+			ring->head.store(head + 1, memory_order_release);
+		}
+		
+		//Moves every recorded zone out of the rings and writes all zones since Start
+		//as chrome trace event json. Can be called again to write a longer trace
+		static bool WriteJson(const path& target)
+		{
+			lock_guard<mutex> lock(registryMutex);
+			
+			uint64_t dropped{};
+			
+			for (auto& r : rings)
+			{
+				uint64_t tail = r->tail.load(memory_order_relaxed);
+				uint64_t head = r->head.load(memory_order_acquire);
+				
+				for (; tail != head; ++tail)
+				{
+					flushed.push_back(FlushedEvent
+					{
+						.event = r->events[tail & (TRACE_RING_SIZE - 1)],
+						.threadId = r->threadId
+					});
+				}
+				
+				r->tail.store(head, memory_order_release);
+				dropped += r->dropped.load(memory_order_relaxed);
+			}
+			
+			ofstream file(target, ios::binary);
+			if (!file) return false;
+			
+			file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << dropped << "},\"traceEvents\":[";
+			
+			char line[512]{};
+			bool isFirst = true;
+			
+			for (const auto& r : rings)
+			{
+				snprintf(
+					line,
+					sizeof(line),
+					"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+					isFirst ? "" : ",",
+					r->threadId,
+					r->threadId);
+				
+				file << line;
+				isFirst = false;
+			}
+			
+			for (const auto& f : flushed)
+			{
+				//microseconds with nanosecond precision
+				
+				snprintf(
+					line,
+					sizeof(line),
+					"%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					isFirst ? "" : ",",
+					f.event.name,
+					f.threadId,
+					static_cast<double>(f.event.start) / 1000.0,
+					static_cast<double>(f.event.end - f.event.start) / 1000.0);
+				
+				file << line;
+				isFirst = false;
+			}
+			
+			file << "\n]}\n";
+			file.close();
+			
+			return !file.fail();
+		}
+	private:
+		//Event moved out of a ring, kept until the next Start
+		struct FlushedEvent
+		{
+			TraceEvent event{};
+			uint32_t threadId{};
+		};
+		
+		//Gives the ring back when its thread exits
+		struct ThreadRing
+		{
+			TraceRing* ring{};
+			
+			~ThreadRing()
+			{
+				if (ring) ring->isOwned.store(false, memory_order_release);
+			}
+		};
+		
+		static TraceRing* GetRing()
+		{
+			thread_local ThreadRing local{};
+			if (local.ring) return local.ring;
+			
+			lock_guard<mutex> lock(registryMutex);
+			
+			for (auto& r : rings)
+			{
+				if (r->isOwned.load(memory_order_acquire)) continue;
+				
+				r->isOwned.store(true, memory_order_relaxed);
+				local.ring = r.get();
+				return local.ring;
+			}
+			
+			rings.push_back(make_unique<TraceRing>());
+			rings.back()->isOwned.store(true, memory_order_relaxed);
+			rings.back()->threadId = static_cast<uint32_t>(rings.size());
+			
+			local.ring = rings.back().get();
+			return local.ring;
+		}
+		
+		static inline atomic<bool> isEnabled{};
+		static inline atomic<uint64_t> origin{};
+		
+		static inline mutex registryMutex{};
+		static inline vector<unique_ptr<TraceRing>> rings{};
+		static inline vector<FlushedEvent> flushed{};
+	};
+	
+	//Records the time from construction to destruction as one zone while tracing is enabled
+	class TraceZone
+	{
+	public:
+		explicit TraceZone(const char* name)
+			: name(name),
+			isActive(Trace::IsEnabled())
+		{
+			if (isActive) start = Trace::Now();
+		}
+		~TraceZone()
+		{
+			if (isActive) Trace::Record(name, start, Trace::Now());
+		}
+		
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+	private:
+		const char* name{};
+		bool isActive{};
+		uint64_t start{};
+	};
+}
+
+#define KALA_TRACE_CONCAT_INNER(a, b) a##b
+#define KALA_TRACE_CONCAT(a, b) KALA_TRACE_CONCAT_INNER(a, b)
+
+//Trace zones only exist when KALA_ENABLE_TRACE is defined, otherwise they compile to nothing.
+//With it defined a zone costs one relaxed load until Trace::Start is called
+#ifdef KALA_ENABLE_TRACE
+	#define KALA_TRACE_ZONE(name) KalaHeaders::KalaTrace::TraceZone KALA_TRACE_CONCAT(kalaTraceZone, __LINE__)(name)
+#else
+	#define KALA_TRACE_ZONE(name)
+#endif
\ No newline at end of file
@@ -0,0 +1,809 @@
+//------------------------------------------------------------------------------
+// utf8_utils.hpp
+//
+// Copyright (C) 2026 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - UTF-8 to UTF-32 transcoding with validation
+//   - SSE2 and AVX2 ascii fast paths (16 or 32 bytes per iteration) with a scalar fallback
+//   - SSSE3 multibyte validation and decoding 16 bytes at a time when compiled with SSSE3 or AVX enabled
+//   - Single codepoint decoding for callers that walk text themselves
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+#if defined(__AVX2__)
+	#define KALA_UTF8_AVX2 1
+#endif
+#if defined(__SSE2__) \
+	|| defined(_M_X64) \
+	|| (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define KALA_UTF8_SSE2 1
+#endif
+
+//pshufb is what lets the multibyte paths classify bytes with table lookups,
+//msvc only enables it through /arch:AVX and newer
+#if defined(__SSSE3__) \
+	|| defined(__AVX__) \
+	|| defined(KALA_UTF8_AVX2)
+	#define KALA_UTF8_SSSE3 1
+#endif
+
+#if defined(KALA_UTF8_AVX2) || defined(KALA_UTF8_SSE2) || defined(KALA_UTF8_SSSE3)
+	#include <immintrin.h>
+#endif
+
+//function inlining for the per-codepoint decoder
+#ifndef FORCE_INLINE
+	#if defined(_MSC_VER)
+		#define FORCE_INLINE __forceinline
+	#elif defined(__GNUC__) || defined(__clang__)
+		#define FORCE_INLINE inline __attribute__((always_inline))
+	#else
+		#define FORCE_INLINE inline
+	#endif
+#endif
+
+//reinterpret_cast
+#ifndef rcast
+	#define rcast reinterpret_cast
+#endif
+
+//static_cast
+#ifndef scast
+	#define scast static_cast
+#endif
+
+namespace KalaHeaders::KalaUTF8
+{
+	using std::countr_zero;
+	
+	using u8 = uint8_t;
+	using u32 = uint32_t;
+	
+	//Codepoint written for every invalid or cut off byte sequence
+	constexpr u32 UTF8_REPLACEMENT_CODEPOINT = 0xFFFDu;
+	
+	//Bytes decoded by the scalar decoder before builds without SSSE3
+	//check for an ascii run the vector loops can take again
+	constexpr size_t UTF8_SCALAR_RUN = 128;
+	
+	//Returned by UTF8ToUTF32
+	struct TranscodeResult
+	{
+		size_t bytesRead{};      //how many input bytes were consumed
+		size_t codepointCount{}; //how many codepoints were written
+		bool isValid = true;     //false if any invalid sequence was replaced with U+FFFD
+	};
+	
+	//Decodes one UTF-8 codepoint starting at text[i] and moves i past it.
+	//Invalid, overlong, surrogate or cut off sequences return UTF8_REPLACEMENT_CODEPOINT,
+	//skip a single byte and set isValid to false
+	FORCE_INLINE u32 DecodeUTF8(
+		const u8* text,
+		size_t size,
+		size_t& i,
+		bool& isValid)
+	{
+		u32 c = text[i];
+		if (c < 0x80)
+		{
+			++i;
+			return c;
+		}
+		
+		//each length checks its continuation bytes and rejects
+		//overlong forms, surrogates and values past the unicode range
+		
+		if ((c & 0xE0) == 0xC0)
+		{
+			if (c >= 0xC2
+				&& i + 1 < size)
+			{
+				u32 c1 = text[i + 1];
+				if ((c1 & 0xC0) == 0x80)
+				{
+					i += 2;
+					return ((c & 0x1F) << 6) | (c1 & 0x3F);
+				}
+			}
+		}
+		else if ((c & 0xF0) == 0xE0)
+		{
+			if (i + 2 < size)
+			{
+				u32 c1 = text[i + 1];
+				u32 c2 = text[i + 2];
+				if (((c1 & 0xC0) == 0x80)
+					&& ((c2 & 0xC0) == 0x80))
+				{
+					u32 codepoint = ((c & 0x0F) << 12) | ((c1 & 0x3F) << 6) | (c2 & 0x3F);
+					if (codepoint >= 0x800
+						&& (codepoint < 0xD800 || codepoint > 0xDFFF))
+					{
+						i += 3;
+						return codepoint;
+					}
+				}
+			}
+		}
+		else if ((c & 0xF8) == 0xF0)
+		{
+			if (i + 3 < size)
+			{
+				u32 c1 = text[i + 1];
+				u32 c2 = text[i + 2];
+				u32 c3 = text[i + 3];
+				if (((c1 & 0xC0) == 0x80)
+					&& ((c2 & 0xC0) == 0x80)
+					&& ((c3 & 0xC0) == 0x80))
+				{
+					u32 codepoint = ((c & 0x07) << 18) | ((c1 & 0x3F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+					if (codepoint >= 0x10000
+						&& codepoint <= 0x10FFFF)
+					{
+						i += 4;
+						return codepoint;
+					}
+				}
+			}
+		}
+		
+		++i;
+		isValid = false;
+		return UTF8_REPLACEMENT_CODEPOINT;
+	}
+	
+	//Decodes one UTF-8 codepoint starting at text[i] and moves i past it,
+	//invalid sequences return UTF8_REPLACEMENT_CODEPOINT and skip a single byte
+	inline u32 DecodeUTF8(
+		const u8* text,
+		size_t size,
+		size_t& i)
+	{
+		bool isValid{};
+		return DecodeUTF8(text, size, i, isValid);
+	}
+	
+#ifdef KALA_UTF8_SSSE3
+	//Error bits of the byte pair lookups in CheckUTF8Block, a byte is invalid
+	//when all three lookups of it and the byte in front of it share a bit
+	constexpr u8 UTF8_TOO_SHORT      = 1u << 0; //lead byte not followed by a continuation byte
+	constexpr u8 UTF8_TOO_LONG       = 1u << 1; //continuation byte after an ascii byte
+	constexpr u8 UTF8_OVERLONG_3     = 1u << 2; //E0 80..9F
+	constexpr u8 UTF8_TOO_LARGE      = 1u << 3; //F4 90..BF and F5..FF 90..BF
+	constexpr u8 UTF8_SURROGATE      = 1u << 4; //ED A0..BF
+	constexpr u8 UTF8_OVERLONG_2     = 1u << 5; //C0 and C1 leads
+	constexpr u8 UTF8_TOO_LARGE_1000 = 1u << 6; //F5..FF 80..8F
+	constexpr u8 UTF8_OVERLONG_4     = 1u << 6; //F0 80..8F
+	constexpr u8 UTF8_TWO_CONTS      = 1u << 7; //continuation byte after a continuation byte
+	
+	//Bits the low nibble lookup of the first byte always keeps so the high nibble lookups decide them
+	constexpr u8 UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS;
+	
+	//Shuffles that pack the 32-bit lanes whose bit is set in the index to the front
+	//and how many lanes each of them keeps
+	struct UTF8CompressTable
+	{
+		alignas(16) u8 masks[16][16]{};
+		u8 laneCounts[16]{};
+	};
+	
+	constexpr UTF8CompressTable BuildUTF8CompressTable()
+	{
+		UTF8CompressTable table{};
+		
+		for (u32 bits = 0; bits < 16; ++bits)
+		{
+			u32 lane{};
+			for (u32 k = 0; k < 4; ++k)
+			{
+				if ((bits & (1u << k)) == 0) continue;
+				
+				for (u32 b = 0; b < 4; ++b) table.masks[bits][lane * 4 + b] = scast<u8>(k * 4 + b);
+				++lane;
+			}
+			
+			//lanes past the kept ones are zeroed, they are overwritten by the next store anyway
+			for (u32 b = lane * 4; b < 16; ++b) table.masks[bits][b] = 0x80u;
+			
+			table.laneCounts[bits] = scast<u8>(lane);
+		}
+		
+		return table;
+	}
+	
+	inline constexpr UTF8CompressTable UTF8_COMPRESS_TABLE = BuildUTF8CompressTable();
+	
+	//Same as UTF8CompressTable for 8 16-bit lanes, used by blocks without three or four byte sequences
+	struct UTF8CompressTable16
+	{
+		alignas(16) u8 masks[256][16]{};
+		u8 laneCounts[256]{};
+	};
+	
+	constexpr UTF8CompressTable16 BuildUTF8CompressTable16()
+	{
+		UTF8CompressTable16 table{};
+		
+		for (u32 bits = 0; bits < 256; ++bits)
+		{
+			u32 lane{};
+			for (u32 k = 0; k < 8; ++k)
+			{
+				if ((bits & (1u << k)) == 0) continue;
+				
+				table.masks[bits][lane * 2] = scast<u8>(k * 2);
+				table.masks[bits][lane * 2 + 1] = scast<u8>(k * 2 + 1);
+				++lane;
+			}
+			
+			for (u32 b = lane * 2; b < 16; ++b) table.masks[bits][b] = 0x80u;
+			
+			table.laneCounts[bits] = scast<u8>(lane);
+		}
+		
+		return table;
+	}
+	
+	inline constexpr UTF8CompressTable16 UTF8_COMPRESS_TABLE_16 = BuildUTF8CompressTable16();
+	
+	//Returns a vector that is not zero where the 16 input bytes are not valid UTF-8 as a
+	//continuation of the 16 bytes in front of them. Sequences that run past the input
+	//are not flagged, callers check them with the next block.
+	//This is the lookup algorithm of Keiser and Lemire that simdutf uses
+	inline __m128i CheckUTF8Block(
+		__m128i input,
+		__m128i prevInput)
+	{
+		const __m128i lowNibble = _mm_set1_epi8(0x0F);
+		
+		const __m128i byte1HighTable = _mm_setr_epi8(
+			//0_______ ascii
+			UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+			UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+			//10______ continuation
+			scast<char>(UTF8_TWO_CONTS), scast<char>(UTF8_TWO_CONTS),
+			scast<char>(UTF8_TWO_CONTS), scast<char>(UTF8_TWO_CONTS),
+			//1100____, 1101____ two byte leads
+			UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+			UTF8_TOO_SHORT,
+			//1110____ three byte leads
+			UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+			//1111____ four byte leads
+			UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+		
+		const __m128i byte1LowTable = _mm_setr_epi8(
+			//____0000, ____0001
+			scast<char>(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+			scast<char>(UTF8_CARRY | UTF8_OVERLONG_2),
+			//____001_
+			scast<char>(UTF8_CARRY),
+			scast<char>(UTF8_CARRY),
+			//____0100
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE),
+			//____0101 to ____1100
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			//____1101
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+			//____111_
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+			scast<char>(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000));
+		
+		const __m128i byte2HighTable = _mm_setr_epi8(
+			//0_______ ascii
+			UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+			UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+			//1000____
+			scast<char>(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+			//1001____
+			scast<char>(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+			//101_____
+			scast<char>(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+			scast<char>(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+			//11______ leads
+			UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+		
+		__m128i prev1 = _mm_alignr_epi8(input, prevInput, 15);
+		
+		__m128i byte1High = _mm_shuffle_epi8(byte1HighTable, _mm_and_si128(_mm_srli_epi16(prev1, 4), lowNibble));
+		__m128i byte1Low = _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(prev1, lowNibble));
+		__m128i byte2High = _mm_shuffle_epi8(byte2HighTable, _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble));
+		
+		__m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+		
+		//the third and fourth byte of a sequence are not covered by the pair lookups,
+		//they must be continuation bytes exactly when a three or four byte lead is 2 or 3 bytes back
+		
+		__m128i prev2 = _mm_alignr_epi8(input, prevInput, 14);
+		__m128i prev3 = _mm_alignr_epi8(input, prevInput, 13);
+		
+		__m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8(scast<char>(0xE0 - 0x80)));
+		__m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8(scast<char>(0xF0 - 0x80)));
+		__m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8(scast<char>(0x80)));
+		
+		return _mm_xor_si128(must23, special);
+	}
+	
+	//Decodes the sequences whose lead byte is in the first 4 bytes of payload and writes them
+	//to out[count]. Payload holds the codepoint bits of every byte from the first lead on,
+	//lengths the (sequence length - 1) * 4 of the 4 lead bytes and leads a bit for each of
+	//the 4 bytes that starts a sequence
+	FORCE_INLINE void DecodeUTF8Group(
+		__m128i payload,
+		__m128i lengths,
+		u32 leads,
+		u32* out,
+		size_t& count)
+	{
+		//every 32-bit lane gets the 4 bytes from its own position on
+		const __m128i spread = _mm_setr_epi8(
+			0, 1, 2, 3,
+			1, 2, 3, 4,
+			2, 3, 4, 5,
+			3, 4, 5, 6);
+		
+		const __m128i broadcast = _mm_setr_epi8(
+			0, 0, 0, 0,
+			1, 1, 1, 1,
+			2, 2, 2, 2,
+			3, 3, 3, 3);
+		
+		const __m128i laneBytes = _mm_setr_epi8(
+			0, 1, 2, 3,
+			0, 1, 2, 3,
+			0, 1, 2, 3,
+			0, 1, 2, 3);
+		
+		//maddubs byte weights and madd pair weights of each sequence length, together
+		//they move the bits of every byte in place and drop the bytes past the sequence
+		
+		const __m128i byteWeights = _mm_setr_epi8(
+			1, 0, 0, 0,
+			64, 1, 0, 0,
+			64, 1, 1, 0,
+			64, 1, 64, 1);
+		
+		const __m128i pairWeights = _mm_setr_epi8(
+			1, 0, 0, 0,
+			1, 0, 0, 0,
+			64, 0, 1, 0,
+			0, 0x10, 1, 0);
+		
+		__m128i weightIndex = _mm_add_epi8(_mm_shuffle_epi8(lengths, broadcast), laneBytes);
+		
+		__m128i bytes = _mm_shuffle_epi8(payload, spread);
+		__m128i pairs = _mm_maddubs_epi16(bytes, _mm_shuffle_epi8(byteWeights, weightIndex));
+		__m128i codepoints = _mm_madd_epi16(pairs, _mm_shuffle_epi8(pairWeights, weightIndex));
+		
+		//continuation byte lanes are dropped, the 16 byte store may run past the kept lanes
+		
+		__m128i packed = _mm_shuffle_epi8(
+			codepoints,
+			_mm_load_si128(rcast<const __m128i*>(UTF8_COMPRESS_TABLE.masks[leads])));
+		
+		_mm_storeu_si128(rcast<__m128i*>(out + count), packed);
+		count += UTF8_COMPRESS_TABLE.laneCounts[leads];
+	}
+	
+	//Same as DecodeUTF8Group for 8 lead bytes of a block without three or four byte sequences,
+	//every sequence fits a 16-bit lane so half as many lanes need to be decoded
+	FORCE_INLINE void DecodeUTF8Group16(
+		__m128i payload,
+		__m128i lengths,
+		u32 leads,
+		u32* out,
+		size_t& count)
+	{
+		//every 16-bit lane gets the 2 bytes from its own position on
+		const __m128i spread = _mm_setr_epi8(
+			0, 1, 1, 2, 2, 3, 3, 4,
+			4, 5, 5, 6, 6, 7, 7, 8);
+		
+		const __m128i broadcast = _mm_setr_epi8(
+			0, 0, 1, 1, 2, 2, 3, 3,
+			4, 4, 5, 5, 6, 6, 7, 7);
+		
+		const __m128i laneBytes = _mm_setr_epi8(
+			0, 1, 0, 1, 0, 1, 0, 1,
+			0, 1, 0, 1, 0, 1, 0, 1);
+		
+		//indexed like the byte weights of DecodeUTF8Group, only the first two lengths exist here
+		const __m128i byteWeights = _mm_setr_epi8(
+			1, 0, 0, 0,
+			64, 1, 0, 0,
+			0, 0, 0, 0,
+			0, 0, 0, 0);
+		
+		__m128i weightIndex = _mm_add_epi8(_mm_shuffle_epi8(lengths, broadcast), laneBytes);
+		
+		__m128i bytes = _mm_shuffle_epi8(payload, spread);
+		__m128i codepoints = _mm_maddubs_epi16(bytes, _mm_shuffle_epi8(byteWeights, weightIndex));
+		
+		__m128i packed = _mm_shuffle_epi8(
+			codepoints,
+			_mm_load_si128(rcast<const __m128i*>(UTF8_COMPRESS_TABLE_16.masks[leads])));
+		
+		const __m128i zero = _mm_setzero_si128();
+		
+		_mm_storeu_si128(rcast<__m128i*>(out + count), _mm_unpacklo_epi16(packed, zero));
+		_mm_storeu_si128(rcast<__m128i*>(out + count + 4), _mm_unpackhi_epi16(packed, zero));
+		count += UTF8_COMPRESS_TABLE_16.laneCounts[leads];
+	}
+	
+	//Decodes 16 byte blocks from in[i] on while every sequence in them is valid and each
+	//block has multibyte sequences, writing one codepoint per sequence to out[count].
+	//in[i] must start a sequence, stops at the start of a sequence in front of the first
+	//block that is invalid or all ascii, or when fewer than 32 input bytes or 16 output slots are left
+	inline void DecodeUTF8Blocks(
+		const u8* in,
+		size_t size,
+		size_t& i,
+		u32* out,
+		size_t maxOut,
+		size_t& count)
+	{
+		if (i + 32 > size
+			|| maxOut - count < 16)
+		{
+			return;
+		}
+		
+		__m128i block = _mm_loadu_si128(rcast<const __m128i*>(in + i));
+		if (_mm_movemask_epi8(block) == 0) return;
+		
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowNibble = _mm_set1_epi8(0x0F);
+		
+		//continuation bytes are 0x80 to 0xBF, the only bytes below -64 as signed
+		const __m128i continuationLimit = _mm_set1_epi8(scast<char>(0xC0));
+		
+		//codepoint bits and sequence lengths of every byte come from its high nibble
+		
+		const __m128i payloadBitsTable = _mm_setr_epi8(
+			0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+			0x3F, 0x3F, 0x3F, 0x3F,
+			0x1F, 0x1F, 0x0F, 0x07);
+		
+		const __m128i lengthTable = _mm_setr_epi8(
+			0, 0, 0, 0, 0, 0, 0, 0,
+			0, 0, 0, 0,
+			4, 4, 8, 12);
+		
+		//the first block starts a sequence so nothing in front of it is carried in,
+		//every later block is checked against the one in front of it
+		
+		__m128i blockErrors = CheckUTF8Block(block, zero);
+		bool isDecoded{};
+		
+		while (true)
+		{
+			//sequences of this block can end in the next one, so both must be valid
+			
+			__m128i next = _mm_loadu_si128(rcast<const __m128i*>(in + i + 16));
+			__m128i nextErrors = CheckUTF8Block(next, block);
+			
+			__m128i errors = _mm_or_si128(blockErrors, nextErrors);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, zero)) != 0xFFFF) break;
+			
+			__m128i blockHigh = _mm_and_si128(_mm_srli_epi16(block, 4), lowNibble);
+			__m128i nextHigh = _mm_and_si128(_mm_srli_epi16(next, 4), lowNibble);
+			
+			__m128i blockPayload = _mm_and_si128(block, _mm_shuffle_epi8(payloadBitsTable, blockHigh));
+			__m128i nextPayload = _mm_and_si128(next, _mm_shuffle_epi8(payloadBitsTable, nextHigh));
+			__m128i lengths = _mm_shuffle_epi8(lengthTable, blockHigh);
+			
+			//continuation bytes at the start of a block belong to the last sequence
+			//of the block in front of it, they start no lane of their own
+			
+			u32 leads = ~scast<u32>(_mm_movemask_epi8(_mm_cmplt_epi8(block, continuationLimit)));
+			
+			//blocks of only one and two byte sequences, like most latin, greek and cyrillic text
+			
+			__m128i longLeads = _mm_subs_epu8(block, _mm_set1_epi8(scast<char>(0xDF)));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(longLeads, zero)) == 0xFFFF)
+			{
+				DecodeUTF8Group16(blockPayload, lengths, leads & 0xFFu, out, count);
+				
+				DecodeUTF8Group16(
+					_mm_alignr_epi8(nextPayload, blockPayload, 8),
+					_mm_srli_si128(lengths, 8),
+					(leads >> 8) & 0xFFu,
+					out,
+					count);
+			}
+			else
+			{
+				DecodeUTF8Group(blockPayload, lengths, leads & 0xFu, out, count);
+				
+				DecodeUTF8Group(
+					_mm_alignr_epi8(nextPayload, blockPayload, 4),
+					_mm_srli_si128(lengths, 4),
+					(leads >> 4) & 0xFu,
+					out,
+					count);
+				
+				DecodeUTF8Group(
+					_mm_alignr_epi8(nextPayload, blockPayload, 8),
+					_mm_srli_si128(lengths, 8),
+					(leads >> 8) & 0xFu,
+					out,
+					count);
+				
+				DecodeUTF8Group(
+					_mm_alignr_epi8(nextPayload, blockPayload, 12),
+					_mm_srli_si128(lengths, 12),
+					(leads >> 12) & 0xFu,
+					out,
+					count);
+			}
+			
+			i += 16;
+			isDecoded = true;
+			
+			if (i + 32 > size
+				|| maxOut - count < 16
+				|| _mm_movemask_epi8(next) == 0)
+			{
+				break;
+			}
+			
+			block = next;
+			blockErrors = nextErrors;
+		}
+		
+		//the last decoded sequence can end up to 3 bytes into the block it stopped at
+		
+		if (isDecoded)
+		{
+			while ((in[i] & 0xC0) == 0x80) ++i;
+		}
+	}
+#endif
+	
+	//Transcodes UTF-8 to UTF-32 until the input ends or maxOut codepoints have been written.
+	//Invalid sequences are written as U+FFFD. An output with as many slots as there are
+	//input bytes is always big enough for the whole input
+	inline TranscodeResult UTF8ToUTF32(
+		const u8* in,
+		size_t size,
+		u32* out,
+		size_t maxOut)
+	{
+		size_t i{};
+		size_t count{};
+		bool isValid = true;
+		
+		while (i < size
+			&& count < maxOut)
+		{
+#ifdef KALA_UTF8_AVX2
+			//32 bytes at a time, a chunk with multibyte sequences still
+			//keeps the ascii bytes in front of its first multibyte sequence
+			
+			while (i + 32 <= size
+				&& maxOut - count >= 32)
+			{
+				__m256i chunk = _mm256_loadu_si256(rcast<const __m256i*>(in + i));
+				u32 mask = scast<u32>(_mm256_movemask_epi8(chunk));
+				
+				for (size_t k = 0; k < 32; k += 8)
+				{
+					__m128i bytes = _mm_loadl_epi64(rcast<const __m128i*>(in + i + k));
+					_mm256_storeu_si256(
+						rcast<__m256i*>(out + count + k),
+						_mm256_cvtepu8_epi32(bytes));
+				}
+				
+				u32 asciiCount = mask == 0 ? 32u : scast<u32>(countr_zero(mask));
+				
+				i += asciiCount;
+				count += asciiCount;
+				
+				if (mask != 0) break;
+			}
+#endif
+#ifdef KALA_UTF8_SSE2
+			//16 bytes at a time, a chunk with multibyte sequences still
+			//keeps the ascii bytes in front of its first multibyte sequence
+			
+			while (i + 16 <= size
+				&& maxOut - count >= 16)
+			{
+				__m128i chunk = _mm_loadu_si128(rcast<const __m128i*>(in + i));
+				u32 mask = scast<u32>(_mm_movemask_epi8(chunk));
+				
+				const __m128i zero = _mm_setzero_si128();
+				__m128i low = _mm_unpacklo_epi8(chunk, zero);
+				__m128i high = _mm_unpackhi_epi8(chunk, zero);
+				
+				_mm_storeu_si128(rcast<__m128i*>(out + count + 0),  _mm_unpacklo_epi16(low, zero));
+				_mm_storeu_si128(rcast<__m128i*>(out + count + 4),  _mm_unpackhi_epi16(low, zero));
+				_mm_storeu_si128(rcast<__m128i*>(out + count + 8),  _mm_unpacklo_epi16(high, zero));
+				_mm_storeu_si128(rcast<__m128i*>(out + count + 12), _mm_unpackhi_epi16(high, zero));
+				
+				u32 asciiCount = mask == 0 ? 16u : scast<u32>(countr_zero(mask));
+				
+				i += asciiCount;
+				count += asciiCount;
+				
+				if (mask != 0) break;
+			}
+#endif
+#ifdef KALA_UTF8_SSSE3
+			//16 bytes with multibyte sequences at a time until a block is all ascii
+			//or holds an invalid sequence, which the scalar decoder below replaces
+			
+			size_t blockStart = i;
+			DecodeUTF8Blocks(in, size, i, out, maxOut, count);
+			
+			if (i != blockStart) continue;
+#endif
+			if (i >= size
+				|| count >= maxOut)
+			{
+				break;
+			}
+			
+#ifdef KALA_UTF8_SSSE3
+			//scalar ascii up to the next multibyte sequence, then the whole multibyte run
+			
+			while (i < size
+				&& count < maxOut
+				&& in[i] < 0x80)
+			{
+				out[count++] = in[i++];
+			}
+			
+			while (i < size
+				&& count < maxOut
+				&& in[i] >= 0x80)
+			{
+				out[count++] = DecodeUTF8(in, size, i, isValid);
+				
+				//the block decoder takes over again after the sequence it stopped at
+				if (i + 32 <= size) break;
+			}
+#else
+			//without SSSE3 mixed text stays on the scalar decoder for UTF8_SCALAR_RUN bytes,
+			//going back to the ascii loops after every multibyte sequence is slower than
+			//decoding it one codepoint at a time. Every codepoint takes at least one byte,
+			//so the run never writes more than maxOut codepoints
+			
+			size_t runSize = size - i;
+			if (maxOut - count < runSize) runSize = maxOut - count;
+			if (UTF8_SCALAR_RUN < runSize) runSize = UTF8_SCALAR_RUN;
+			
+			size_t runEnd = i + runSize;
+			
+			while (i < runEnd)
+			{
+				u32 c = in[i];
+				if (c < 0x80) [[likely]]
+				{
+					out[count++] = c;
+					++i;
+					continue;
+				}
+				
+				out[count++] = DecodeUTF8(in, size, i, isValid);
+			}
+#endif
+		}
+		
+		return TranscodeResult
+		{
+			.bytesRead = i,
+			.codepointCount = count,
+			.isValid = isValid
+		};
+	}
+	
+	//Returns true if the whole input is valid UTF-8
+	inline bool IsValidUTF8(
+		const u8* in,
+		size_t size)
+	{
+		bool isValid = true;
+		size_t i{};
+		
+#ifdef KALA_UTF8_SSSE3
+		//every block is checked against the one in front of it, ascii blocks only have to
+		//make sure the block in front of them did not end in the middle of a sequence
+		
+		const __m128i zero = _mm_setzero_si128();
+		
+		//a lead byte this close to the end of a block continues into the next block
+		const __m128i incompleteLimit = _mm_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			scast<char>(0xF0 - 1),
+			scast<char>(0xE0 - 1),
+			scast<char>(0xC0 - 1));
+		
+		__m128i prevInput = zero;
+		__m128i incomplete = zero;
+		__m128i errors = zero;
+		
+		while (i + 16 <= size)
+		{
+#ifdef KALA_UTF8_AVX2
+			if (i + 32 <= size
+				&& _mm256_movemask_epi8(_mm256_loadu_si256(rcast<const __m256i*>(in + i))) == 0)
+			{
+				errors = _mm_or_si128(errors, incomplete);
+				incomplete = zero;
+				prevInput = zero;
+				i += 32;
+				continue;
+			}
+#endif
+			__m128i input = _mm_loadu_si128(rcast<const __m128i*>(in + i));
+			
+			if (_mm_movemask_epi8(input) == 0) errors = _mm_or_si128(errors, incomplete);
+			else errors = _mm_or_si128(errors, CheckUTF8Block(input, prevInput));
+			
+			incomplete = _mm_subs_epu8(input, incompleteLimit);
+			prevInput = input;
+			i += 16;
+		}
+		
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, zero)) != 0xFFFF) return false;
+		
+		//a sequence the last block could not finish is checked again from its lead byte
+		
+		for (size_t back = 1; back <= 3 && back <= i; ++back)
+		{
+			if (in[i - back] >= 0xC0)
+			{
+				i -= back;
+				break;
+			}
+		}
+#endif
+		while (i < size)
+		{
+#ifdef KALA_UTF8_AVX2
+			while (i + 32 <= size
+				&& _mm256_movemask_epi8(_mm256_loadu_si256(rcast<const __m256i*>(in + i))) == 0)
+			{
+				i += 32;
+			}
+#endif
+#ifdef KALA_UTF8_SSE2
+			while (i + 16 <= size
+				&& _mm_movemask_epi8(_mm_loadu_si128(rcast<const __m128i*>(in + i))) == 0)
+			{
+				i += 16;
+			}
+#endif
+			while (i < size
+				&& in[i] < 0x80)
+			{
+				++i;
+			}
+			
+			while (i < size
+				&& in[i] >= 0x80)
+			{
+				DecodeUTF8(in, size, i, isValid);
+				if (!isValid) return false;
+			}
+		}
+		
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+namespace KalaFontBench
+{
+	using std::vector;
+	using std::string;
+	using std::function;
+	using std::sort;
+	using std::ceil;
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+	
+	using f64 = double;
+	
+	//How many untimed runs are done before measuring
+	constexpr int WARMUP_RUNS = 3;
+	
+	//How many timed runs are measured
+	constexpr int MEASURED_RUNS = 15;
+	
+	//How many timed runs latency benchmarks measure so p90 and p99 mean something
+	constexpr int LATENCY_RUNS = 101;
+	
+	//Folder of new.ttf and test.kfd, CMake points it at the test_fonts folder of the repository
+#ifndef KALAFONT_TEST_FONTS
+	#define KALAFONT_TEST_FONTS "test_fonts"
+#endif
+	
+	//Run times of one benchmark in seconds
+	struct BenchStats
+	{
+		int runs{};
+		f64 min{};
+		f64 median{};
+		f64 p90{};
+		f64 p99{};
+		f64 max{};
+	};
+	
+	//One measured row of the csv and json results
+	struct BenchResult
+	{
+		string group{};   //benchmark the row belongs to, like "utf8" or "import"
+		string name{};    //what was measured within the group
+		BenchStats stats{};
+		f64 work{};       //units of work done by one run
+		string unit{};    //what the work is counted in, like "glyphs" or "bytes"
+	};
+	
+	inline vector<BenchResult> benchResults{};
+	
+	inline volatile char doNotOptimizeSink{};
+	
+	//Keeps the optimizer from removing work whose result is never used
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+		doNotOptimizeSink = *reinterpret_cast<const volatile char*>(&value);
+	}
+	
+	//Runs the function WARMUP_RUNS times untimed, then measures it runs times
+	inline BenchStats MeasureStats(
+		const function<void()>& func,
+		int runs = MEASURED_RUNS)
+	{
+		for (int i = 0; i < WARMUP_RUNS; ++i) func();
+		
+		vector<f64> seconds{};
+		seconds.reserve(runs);
+		
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = steady_clock::now();
+			func();
+			auto end = steady_clock::now();
+			
+			seconds.push_back(duration<f64>(end - start).count());
+		}
+		
+		sort(seconds.begin(), seconds.end());
+		
+		//nearest rank
+		auto Percentile = [&seconds](f64 p)
+			{
+				size_t rank = static_cast<size_t>(ceil(p * seconds.size()));
+				return seconds[rank == 0 ? 0 : rank - 1];
+			};
+		
+		return BenchStats
+		{
+			.runs = runs,
+			.min = seconds.front(),
+			.median = seconds[seconds.size() / 2],
+			.p90 = Percentile(0.90),
+			.p99 = Percentile(0.99),
+			.max = seconds.back()
+		};
+	}
+	
+	//Runs the function WARMUP_RUNS times untimed, then MEASURED_RUNS times
+	//and returns the median run time in seconds
+	inline f64 MeasureMedian(const function<void()>& func)
+	{
+		return MeasureStats(func).median;
+	}
+	
+	//Adds a row to the csv and json results
+	inline void AddResult(
+		const string& group,
+		const string& name,
+		const BenchStats& stats,
+		f64 work,
+		const string& unit)
+	{
+		benchResults.push_back(BenchResult
+		{
+			.group = group,
+			.name = name,
+			.stats = stats,
+			.work = work,
+			.unit = unit
+		});
+	}
+	
+	//Writes every added row as csv or json depending on the extension of the path,
+	//returns false if the extension is not .csv or .json or the file could not be written
+	bool WriteResults(const string& resultsPath);
+	
+	//UTF-8 decode throughput
+	void BenchUTF8();
+	
+	//Coverage mask blending throughput of composite_kfd.hpp
+	void BenchComposite();
+	
+	//Multi-threaded layout throughput of batch_kfd.hpp
+	void BenchBatchLayout();
+	
+	//SetText cost and greedy and minimum raggedness reflow time of linebreak_kfd.hpp
+	//while a 100k character document is resized one pixel at a time
+	void BenchLineBreak();
+	
+	//FreeType rasterization throughput of new.ttf at several heights, rendered like the parse command does
+	void BenchRasterize();
+	
+	//SerializeGlyph serialization and kfd file write bandwidth
+	void BenchExport();
+	
+	//ImportKFD, GetTableData and StreamGlyphs latency against test.kfd
+	void BenchImport();
+	
+	//Codepoint to glyph lookup cost of LayoutFont
+	void BenchLookup();
+}
\ No newline at end of file
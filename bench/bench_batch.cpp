@@ -0,0 +1,136 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <thread>
+
+#include "KalaHeaders/batch_kfd.hpp"
+
+#include "bench.hpp"
+
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::GlyphMetrics;
+using KalaHeaders::KalaFontData::LayoutFont;
+using KalaHeaders::KalaFontData::LayoutJob;
+using KalaHeaders::KalaFontData::BatchLayout;
+using KalaHeaders::KalaFontData::BuildLayoutFont;
+using KalaHeaders::KalaThread::WorkPool;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::printf;
+using std::thread;
+
+using u16 = uint16_t;
+using u32 = uint32_t;
+using i16 = int16_t;
+
+//How many labels are laid out per measured batch
+constexpr u32 LABEL_COUNT = 50000;
+
+//Biggest thread count that is measured
+constexpr u32 MAX_BENCH_THREADS = 16;
+
+//Printable ascii glyphs with metrics that look like a 32 px font
+static LayoutFont BuildAsciiFont()
+{
+	GlyphHeader header
+	{
+		.type = 2,
+		.glyphHeight = 32
+	};
+	
+	vector<GlyphMetrics> metrics{};
+	for (u32 c = ' '; c <= '~'; ++c)
+	{
+		metrics.push_back(GlyphMetrics
+		{
+			.charCode = c,
+			.width = scast<u16>(c == ' ' ? 0 : 12 + c % 8),
+			.height = scast<u16>(c == ' ' ? 0 : 18 + c % 6),
+			.bearingX = 1,
+			.bearingY = scast<i16>(18 + c % 6),
+			.advance = scast<u16>(14 + c % 8)
+		});
+	}
+	
+	return BuildLayoutFont(header, metrics);
+}
+
+//Short map and chart labels of uneven length
+static vector<string> BuildLabels()
+{
+	vector<string> labels{};
+	labels.reserve(LABEL_COUNT);
+	
+	for (u32 i = 0; i < LABEL_COUNT; ++i)
+	{
+		string label = "Label " + to_string(i * 7919u);
+		label.append(i % 41, i % 2 == 0 ? 'x' : ' ');
+		labels.push_back(label);
+	}
+	
+	return labels;
+}
+
+namespace KalaFontBench
+{
+	void BenchBatchLayout()
+	{
+		LayoutFont font = BuildAsciiFont();
+		vector<string> labels = BuildLabels();
+		
+		vector<LayoutJob> jobs(labels.size());
+		for (size_t i = 0; i < labels.size(); ++i)
+		{
+			jobs[i] = LayoutJob
+			{
+				.font = &font,
+				.text = labels[i],
+				.originX = scast<float>(i % 64) * 30.0f,
+				.originY = scast<float>(i / 64) * 36.0f
+			};
+		}
+		
+		printf(
+			"batch layout (median of %d runs, %u labels, %u hardware threads)\n",
+			MEASURED_RUNS,
+			LABEL_COUNT,
+			thread::hardware_concurrency());
+		
+		f64 singleSeconds{};
+		for (u32 threads = 1; threads <= MAX_BENCH_THREADS; threads *= 2)
+		{
+			WorkPool pool(threads);
+			BatchLayout batch(pool);
+			
+			u32 glyphCount{};
+			BenchStats stats = MeasureStats([&]()
+				{
+					glyphCount = batch.LayoutJobs(jobs.data(), jobs.size()).glyphCount;
+				});
+			f64 seconds = stats.median;
+			
+			if (threads == 1) singleSeconds = seconds;
+			
+			DoNotOptimize(glyphCount);
+			printf(
+				"  %2u threads %10.1f Mglyphs/s %6.2fx\n",
+				threads,
+				(glyphCount / 1e6) / seconds,
+				singleSeconds / seconds);
+			
+			AddResult(
+				"batch layout",
+				to_string(threads) + " threads",
+				stats,
+				glyphCount,
+				"glyphs");
+		}
+	}
+}
\ No newline at end of file
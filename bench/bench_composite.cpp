@@ -0,0 +1,187 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "KalaHeaders/composite_kfd.hpp"
+
+#include "bench.hpp"
+
+using KalaHeaders::KalaFontData::Framebuffer;
+using KalaHeaders::KalaFontData::CoverageMask;
+using KalaHeaders::KalaFontData::CompositeColor;
+using KalaHeaders::KalaFontData::ClipRect;
+using KalaHeaders::KalaFontData::PixelFormat;
+using KalaHeaders::KalaFontData::BlendMode;
+using KalaHeaders::KalaFontData::BlendMask;
+
+using std::vector;
+using std::string;
+using std::printf;
+using std::sqrt;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using i32 = int32_t;
+
+//Size of the generated framebuffer
+constexpr u32 FRAME_WIDTH = 1920;
+constexpr u32 FRAME_HEIGHT = 1080;
+
+//Size of each generated glyph mask, about a 32 px font
+constexpr u32 MASK_WIDTH = 24;
+constexpr u32 MASK_HEIGHT = 32;
+
+//How many different masks are cycled through
+constexpr u32 MASK_COUNT = 64;
+
+//How many glyphs are blended per measured run
+constexpr u32 GLYPHS_PER_RUN = 20000;
+
+//Builds glyph-like masks: a solid ring with antialiased edges
+//and empty corners, so every row has zero, partial and full coverage
+static vector<u8> BuildMaskPixels()
+{
+	vector<u8> pixels(MASK_COUNT * MASK_WIDTH * MASK_HEIGHT);
+	
+	for (u32 m = 0; m < MASK_COUNT; ++m)
+	{
+		float radius = 8.0f + scast<float>(m % 5);
+		
+		for (u32 y = 0; y < MASK_HEIGHT; ++y)
+		{
+			for (u32 x = 0; x < MASK_WIDTH; ++x)
+			{
+				float dx = scast<float>(x) - MASK_WIDTH * 0.5f;
+				float dy = scast<float>(y) - MASK_HEIGHT * 0.5f;
+				float edge = 3.0f - std::fabs(sqrt(dx * dx + dy * dy) - radius);
+				
+				float coverage = edge < 0.0f ? 0.0f : (edge > 1.0f ? 1.0f : edge);
+				
+				pixels[(m * MASK_HEIGHT + y) * MASK_WIDTH + x] = scast<u8>(coverage * 255.0f);
+			}
+		}
+	}
+	
+	return pixels;
+}
+
+static void PrintRow(
+	const char* formatName,
+	const char* modeName,
+	u64 pixels,
+	const KalaFontBench::BenchStats& stats)
+{
+	printf(
+		"  %-6s %-7s %10.1f Mpix/s\n",
+		formatName,
+		modeName,
+		(pixels / 1e6) / stats.median);
+	
+	KalaFontBench::AddResult(
+		"composite",
+		string(formatName) + " " + modeName,
+		stats,
+		static_cast<KalaFontBench::f64>(pixels),
+		"pixels");
+}
+
+namespace KalaFontBench
+{
+	void BenchComposite()
+	{
+		vector<u8> maskPixels = BuildMaskPixels();
+		
+		vector<CoverageMask> masks(MASK_COUNT);
+		for (u32 m = 0; m < MASK_COUNT; ++m)
+		{
+			masks[m] = CoverageMask
+			{
+				.pixels = maskPixels.data() + m * MASK_WIDTH * MASK_HEIGHT,
+				.width = MASK_WIDTH,
+				.height = MASK_HEIGHT,
+				.stride = MASK_WIDTH
+			};
+		}
+		
+		struct Target
+		{
+			const char* name;
+			PixelFormat format;
+		};
+		
+		Target targets[] =
+		{
+			{ "rgba8", PixelFormat::FORMAT_RGBA8 },
+			{ "gray8", PixelFormat::FORMAT_GRAY8 }
+		};
+		
+		struct Mode
+		{
+			const char* name;
+			BlendMode mode;
+		};
+		
+		Mode modes[] =
+		{
+			{ "linear", BlendMode::BLEND_LINEAR },
+			{ "gamma",  BlendMode::BLEND_GAMMA }
+		};
+		
+		//a clip rectangle a bit smaller than the frame so edge glyphs are clipped too
+		const ClipRect clip{ 8, 8, FRAME_WIDTH - 8, FRAME_HEIGHT - 8 };
+		const CompositeColor color{ 230, 200, 40, 255 };
+		
+		printf("glyph compositing (median of %d runs, %ux%u masks)\n", MEASURED_RUNS, MASK_WIDTH, MASK_HEIGHT);
+		
+		for (const auto& t : targets)
+		{
+			u32 channels = scast<u32>(t.format);
+			vector<u8> pixels(scast<size_t>(FRAME_WIDTH) * FRAME_HEIGHT * channels, 16);
+			
+			Framebuffer framebuffer
+			{
+				.pixels = pixels.data(),
+				.width = FRAME_WIDTH,
+				.height = FRAME_HEIGHT,
+				.stride = FRAME_WIDTH * channels,
+				.format = t.format
+			};
+			
+			for (const auto& m : modes)
+			{
+				u64 blended{};
+				
+				BenchStats stats = MeasureStats([&]()
+					{
+						blended = 0;
+						
+						//glyphs are placed like lines of text over the whole frame
+						for (u32 g = 0; g < GLYPHS_PER_RUN; ++g)
+						{
+							i32 x = scast<i32>((g * 19u) % FRAME_WIDTH) - 4;
+							i32 y = scast<i32>(((g * 19u) / FRAME_WIDTH) * 36u % FRAME_HEIGHT);
+							
+							blended += BlendMask(
+								framebuffer,
+								masks[g % MASK_COUNT],
+								x,
+								y,
+								color,
+								clip,
+								m.mode);
+						}
+					});
+				
+				DoNotOptimize(pixels[pixels.size() / 2]);
+				PrintRow(t.name, m.name, blended, stats);
+			}
+		}
+	}
+}
\ No newline at end of file
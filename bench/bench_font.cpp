@@ -0,0 +1,472 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+
+#include "FreeType/include/ft2build.h"
+#include FT_FREETYPE_H
+
+#include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/layout_kfd.hpp"
+
+#include "export.hpp"
+
+#include "bench.hpp"
+
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::GlyphTable;
+using KalaHeaders::KalaFontData::GlyphBlock;
+using KalaHeaders::KalaFontData::ImportResult;
+using KalaHeaders::KalaFontData::ImportKFD;
+using KalaHeaders::KalaFontData::GetHeaderData;
+using KalaHeaders::KalaFontData::GetTableData;
+using KalaHeaders::KalaFontData::StreamGlyphs;
+using KalaHeaders::KalaFontData::GetBaseCharCode;
+using KalaHeaders::KalaFontData::LayoutFont;
+using KalaHeaders::KalaFontData::BuildLayoutFont;
+
+using KalaFont::Export;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::printf;
+using std::abs;
+using std::move;
+using std::ofstream;
+using std::ios;
+using std::streamsize;
+using std::filesystem::path;
+using std::filesystem::exists;
+using std::filesystem::remove;
+using std::filesystem::temp_directory_path;
+using std::error_code;
+
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using i16 = int16_t;
+
+//Glyph heights rasterization is measured at
+constexpr u32 RASTER_HEIGHTS[] = { 16, 32, 64, 128 };
+
+//Glyph height of the glyphs ExportGlyph serializes
+constexpr u32 EXPORT_HEIGHT = 32;
+
+//How many tables the small StreamGlyphs read asks for, about one short string
+constexpr size_t STREAM_SUBSET_SIZE = 16;
+
+//How many codepoints are looked up per measured run
+constexpr size_t LOOKUP_COUNT = size_t{ 1 } << 20;
+
+//One glyph of the charmap
+struct GlyphSource
+{
+	u32 charCode{};
+	FT_UInt glyphIndex{};
+};
+
+//FreeType library and one face of it, closed when it goes out of scope
+struct BenchFace
+{
+	FT_Library ft{};
+	FT_Face face{};
+	
+	explicit BenchFace(const path& fontPath)
+	{
+		if (FT_Init_FreeType(&ft) != 0)
+		{
+			ft = nullptr;
+			return;
+		}
+		
+		if (FT_New_Face(ft, fontPath.string().c_str(), 0, &face) != 0) face = nullptr;
+	}
+	~BenchFace()
+	{
+		if (face) FT_Done_Face(face);
+		if (ft) FT_Done_FreeType(ft);
+	}
+	
+	BenchFace(const BenchFace&) = delete;
+	BenchFace& operator=(const BenchFace&) = delete;
+};
+
+static path GetTestFile(const char* name)
+{
+	return path(KALAFONT_TEST_FONTS) / name;
+}
+
+static bool HasTestFile(const path& file)
+{
+	if (exists(file)) return true;
+	
+	printf("  skipped, '%s' does not exist\n", file.string().c_str());
+	
+	return false;
+}
+
+static vector<GlyphSource> GetGlyphSources(FT_Face face)
+{
+	vector<GlyphSource> sources{};
+	
+	FT_UInt glyphIndex{};
+	FT_ULong charCode = FT_Get_First_Char(face, &glyphIndex);
+	while (glyphIndex != 0)
+	{
+		sources.push_back(GlyphSource
+		{
+			.charCode = static_cast<u32>(charCode),
+			.glyphIndex = glyphIndex
+		});
+		
+		charCode = FT_Get_Next_Char(face, charCode, &glyphIndex);
+	}
+	
+	return sources;
+}
+
+//Loads, renders and copies one glyph the same way the parse command does,
+//returns false if FreeType failed
+static bool RenderGlyph(
+	FT_Face face,
+	const GlyphSource& source,
+	GlyphBlock& outBlock)
+{
+	if (FT_Load_Glyph(face, source.glyphIndex, FT_LOAD_DEFAULT) != 0) return false;
+	
+	FT_GlyphSlot slot = face->glyph;
+	if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL) != 0) return false;
+	
+	FT_Bitmap& bmp = slot->bitmap;
+	
+	outBlock.charCode = source.charCode;
+	outBlock.width = static_cast<u16>(bmp.width);
+	outBlock.height = static_cast<u16>(bmp.rows);
+	outBlock.bearingX = static_cast<i16>(slot->bitmap_left);
+	outBlock.bearingY = static_cast<i16>(slot->bitmap_top);
+	outBlock.advance = static_cast<u16>((slot->advance.x >> 6));
+	
+	outBlock.rawPixels.assign(
+		bmp.buffer,
+		bmp.buffer + (bmp.rows * abs(bmp.pitch)));
+	
+	outBlock.rawPixelSize = static_cast<u32>(outBlock.rawPixels.size());
+	
+	return true;
+}
+
+static void PrintLatencyRow(
+	const char* name,
+	const KalaFontBench::BenchStats& stats)
+{
+	printf(
+		"  %-18s %10.1f us median %10.1f us p90 %10.1f us p99\n",
+		name,
+		stats.median * 1e6,
+		stats.p90 * 1e6,
+		stats.p99 * 1e6);
+}
+
+namespace KalaFontBench
+{
+	void BenchRasterize()
+	{
+		path fontPath = GetTestFile("new.ttf");
+		
+		printf("glyph rasterization (median of %d runs, %s)\n", MEASURED_RUNS, fontPath.filename().string().c_str());
+		
+		if (!HasTestFile(fontPath)) return;
+		
+		BenchFace font(fontPath);
+		if (!font.face)
+		{
+			printf("  skipped, FreeType could not open the font\n");
+			return;
+		}
+		
+		vector<GlyphSource> sources = GetGlyphSources(font.face);
+		GlyphBlock block{};
+		
+		for (u32 height : RASTER_HEIGHTS)
+		{
+			FT_Set_Pixel_Sizes(font.face, 0, height);
+			
+			u32 rendered{};
+			BenchStats stats = MeasureStats([&]()
+				{
+					rendered = 0;
+					for (const auto& s : sources) rendered += RenderGlyph(font.face, s, block) ? 1 : 0;
+				});
+			
+			DoNotOptimize(block.rawPixelSize);
+			printf(
+				"  %4u px %10.1f kglyphs/s %8.1f us p99\n",
+				height,
+				(rendered / 1e3) / stats.median,
+				stats.p99 * 1e6);
+			
+			AddResult(
+				"rasterize",
+				to_string(height) + " px",
+				stats,
+				rendered,
+				"glyphs");
+		}
+	}
+	
+	void BenchExport()
+	{
+		path fontPath = GetTestFile("new.ttf");
+		
+		printf("glyph export (median of %d runs, %s at %u px)\n", MEASURED_RUNS, fontPath.filename().string().c_str(), EXPORT_HEIGHT);
+		
+		if (!HasTestFile(fontPath)) return;
+		
+		vector<GlyphBlock> blocks{};
+		{
+			BenchFace font(fontPath);
+			if (!font.face)
+			{
+				printf("  skipped, FreeType could not open the font\n");
+				return;
+			}
+			
+			FT_Set_Pixel_Sizes(font.face, 0, EXPORT_HEIGHT);
+			
+			for (const auto& s : GetGlyphSources(font.face))
+			{
+				GlyphBlock block{};
+				if (RenderGlyph(font.face, s, block)) blocks.push_back(move(block));
+			}
+		}
+		
+		//serialization is timed on its own so the file write and the export logs stay out of it
+		
+		vector<u8> data{};
+		
+		bool isSerialized = true;
+		BenchStats serializeStats = MeasureStats([&]()
+			{
+				isSerialized = Export::SerializeGlyph(
+					2,
+					static_cast<u8>(EXPORT_HEIGHT),
+					blocks,
+					data)
+					&& isSerialized;
+			});
+		
+		if (!isSerialized)
+		{
+			printf("  skipped, SerializeGlyph failed\n");
+			return;
+		}
+		
+		path target = temp_directory_path() / "KalaFontBench_export.kfd";
+		
+		bool isWritten = true;
+		BenchStats writeStats = MeasureStats([&]()
+			{
+				ofstream file(target, ios::binary | ios::trunc);
+				file.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+				file.close();
+				
+				isWritten = !file.fail() && isWritten;
+			});
+		
+		error_code ec{};
+		remove(target, ec);
+		
+		u64 bytes = data.size();
+		
+		printf(
+			"  %-14s %10.1f MB/s %8zu glyphs %10llu bytes\n",
+			"SerializeGlyph",
+			(bytes / (1024.0 * 1024.0)) / serializeStats.median,
+			blocks.size(),
+			static_cast<unsigned long long>(bytes));
+		
+		AddResult(
+			"export",
+			"SerializeGlyph",
+			serializeStats,
+			static_cast<f64>(bytes),
+			"bytes");
+		
+		if (!isWritten)
+		{
+			printf("  file write skipped, '%s' could not be written\n", target.string().c_str());
+			return;
+		}
+		
+		printf(
+			"  %-14s %10.1f MB/s %8zu glyphs %10llu bytes\n",
+			"file write",
+			(bytes / (1024.0 * 1024.0)) / writeStats.median,
+			blocks.size(),
+			static_cast<unsigned long long>(bytes));
+		
+		AddResult(
+			"export",
+			"file write",
+			writeStats,
+			static_cast<f64>(bytes),
+			"bytes");
+	}
+	
+	void BenchImport()
+	{
+		path kfdPath = GetTestFile("test.kfd");
+		
+		printf("kfd import (%d runs, %s)\n", LATENCY_RUNS, kfdPath.filename().string().c_str());
+		
+		if (!HasTestFile(kfdPath)) return;
+		
+		GlyphHeader header{};
+		vector<GlyphTable> tables{};
+		vector<GlyphBlock> blocks{};
+		
+		if (ImportKFD(kfdPath, header, tables, blocks) != ImportResult::RESULT_SUCCESS
+			|| tables.empty())
+		{
+			printf("  skipped, ImportKFD failed\n");
+			return;
+		}
+		
+		//every nth table so the small read touches the whole file
+		
+		vector<GlyphTable> subset{};
+		size_t step = tables.size() / STREAM_SUBSET_SIZE + 1;
+		for (size_t i = 0; i < tables.size(); i += step) subset.push_back(tables[i]);
+		
+		struct ImportCase
+		{
+			const char* name;
+			f64 work;
+			function<void()> run;
+		};
+		
+		vector<ImportCase> cases =
+		{
+			{ "GetHeaderData", 1.0, [&]()
+				{
+					GlyphHeader h{};
+					DoNotOptimize(GetHeaderData(kfdPath, h));
+				} },
+			{ "GetTableData", static_cast<f64>(tables.size()), [&]()
+				{
+					vector<GlyphTable> t{};
+					DoNotOptimize(GetTableData(kfdPath, t));
+				} },
+			{ "StreamGlyphs all", static_cast<f64>(tables.size()), [&]()
+				{
+					vector<GlyphBlock> b{};
+					DoNotOptimize(StreamGlyphs(kfdPath, tables, b));
+				} },
+			{ "StreamGlyphs few", static_cast<f64>(subset.size()), [&]()
+				{
+					vector<GlyphBlock> b{};
+					DoNotOptimize(StreamGlyphs(kfdPath, subset, b));
+				} },
+			{ "ImportKFD", static_cast<f64>(tables.size()), [&]()
+				{
+					GlyphHeader h{};
+					vector<GlyphTable> t{};
+					vector<GlyphBlock> b{};
+					DoNotOptimize(ImportKFD(kfdPath, h, t, b));
+				} }
+		};
+		
+		for (const auto& c : cases)
+		{
+			BenchStats stats = MeasureStats(c.run, LATENCY_RUNS);
+			
+			PrintLatencyRow(c.name, stats);
+			
+			AddResult(
+				"import",
+				c.name,
+				stats,
+				c.work,
+				"glyphs");
+		}
+	}
+	
+	void BenchLookup()
+	{
+		path kfdPath = GetTestFile("test.kfd");
+		
+		printf("codepoint lookup (median of %d runs, %zu lookups)\n", MEASURED_RUNS, LOOKUP_COUNT);
+		
+		if (!HasTestFile(kfdPath)) return;
+		
+		GlyphHeader header{};
+		vector<GlyphTable> tables{};
+		vector<GlyphBlock> blocks{};
+		
+		if (ImportKFD(kfdPath, header, tables, blocks) != ImportResult::RESULT_SUCCESS
+			|| blocks.empty())
+		{
+			printf("  skipped, ImportKFD failed\n");
+			return;
+		}
+		
+		LayoutFont font = BuildLayoutFont(header, blocks);
+		
+		//the same pseudo random order every run so results can be compared
+		
+		u64 state = 0x9E3779B97F4A7C15ull;
+		auto Next = [&state]()
+			{
+				state = state * 6364136223846793005ull + 1442695040888963407ull;
+				return static_cast<u32>(state >> 33);
+			};
+		
+		vector<u32> present(LOOKUP_COUNT);
+		vector<u32> missing(LOOKUP_COUNT);
+		
+		for (size_t i = 0; i < LOOKUP_COUNT; ++i)
+		{
+			present[i] = GetBaseCharCode(blocks[Next() % blocks.size()].charCode);
+			
+			//private use area codepoints, test fonts do not have them
+			missing[i] = 0xF0000 + Next() % 0xFFFE;
+		}
+		
+		struct LookupCase
+		{
+			const char* name;
+			const vector<u32>* codepoints;
+		};
+		
+		for (const auto& c : { LookupCase{ "present", &present }, LookupCase{ "missing", &missing } })
+		{
+			u64 sum{};
+			BenchStats stats = MeasureStats([&]()
+				{
+					for (u32 codepoint : *c.codepoints) sum += font.Find(codepoint);
+				});
+			
+			DoNotOptimize(sum);
+			printf(
+				"  %-10s %10.2f ns/lookup\n",
+				c.name,
+				(stats.median * 1e9) / LOOKUP_COUNT);
+			
+			AddResult(
+				"lookup",
+				string("Find ") + c.name,
+				stats,
+				static_cast<f64>(LOOKUP_COUNT),
+				"lookups");
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+#include <vector>
+#include <string>
+
+#include "KalaHeaders/linebreak_kfd.hpp"
+
+#include "bench.hpp"
+
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::GlyphMetrics;
+using KalaHeaders::KalaFontData::LayoutFont;
+using KalaHeaders::KalaFontData::LineBreaker;
+using KalaHeaders::KalaFontData::LineBreakMode;
+using KalaHeaders::KalaFontData::BuildLayoutFont;
+
+using std::vector;
+using std::string;
+using std::printf;
+
+using u16 = uint16_t;
+using u32 = uint32_t;
+using i16 = int16_t;
+using f32 = float;
+
+//Size of the wrapped document in characters
+constexpr size_t DOCUMENT_SIZE = 100000;
+
+//How many line widths one measured run breaks the document to,
+//each one pixel wider than the last like a window that is being resized
+constexpr u32 RESIZE_STEPS = 64;
+
+//Width of the first resize step in pixels
+constexpr f32 RESIZE_START_WIDTH = 600.0f;
+
+//Printable ascii glyphs with metrics that look like a 32 px font
+static LayoutFont BuildAsciiFont()
+{
+	GlyphHeader header
+	{
+		.type = 2,
+		.glyphHeight = 32
+	};
+	
+	vector<GlyphMetrics> metrics{};
+	for (u32 c = ' '; c <= '~'; ++c)
+	{
+		metrics.push_back(GlyphMetrics
+		{
+			.charCode = c,
+			.width = scast<u16>(c == ' ' ? 0 : 12 + c % 8),
+			.height = scast<u16>(c == ' ' ? 0 : 18 + c % 6),
+			.bearingX = 1,
+			.bearingY = scast<i16>(18 + c % 6),
+			.advance = scast<u16>(14 + c % 8)
+		});
+	}
+	
+	return BuildLayoutFont(header, metrics);
+}
+
+//Prose of uneven word lengths split into paragraphs of 20 to 80 words
+static string BuildDocument()
+{
+	const char* words[] =
+	{
+		"the", "glyph", "atlas", "is", "rebuilt", "when", "a", "font",
+		"changes", "and", "every", "line", "of", "text", "wraps", "again",
+		"to", "fit", "its", "new", "width", "without", "splitting", "words"
+	};
+	constexpr u32 WORD_COUNT = sizeof(words) / sizeof(words[0]);
+	
+	string document{};
+	document.reserve(DOCUMENT_SIZE + 16);
+	
+	u32 wordIndex{};
+	u32 paragraphWords{};
+	while (document.size() < DOCUMENT_SIZE)
+	{
+		document += words[(wordIndex * 7u + wordIndex / 5u) % WORD_COUNT];
+		++wordIndex;
+		++paragraphWords;
+		
+		if (paragraphWords >= 20 + wordIndex % 61)
+		{
+			document += '\n';
+			paragraphWords = 0;
+		}
+		else document += ' ';
+	}
+	
+	return document;
+}
+
+namespace KalaFontBench
+{
+	void BenchLineBreak()
+	{
+		LayoutFont font = BuildAsciiFont();
+		string document = BuildDocument();
+		
+		printf(
+			"line break (median of %d runs, %zu characters, %u resize steps)\n",
+			MEASURED_RUNS,
+			document.size(),
+			RESIZE_STEPS);
+		
+		LineBreaker breaker{};
+		
+		BenchStats setTextStats = MeasureStats([&]()
+			{
+				breaker.SetText(font, document);
+			});
+		
+		printf(
+			"  %-16s %10.1f us %8zu words %6zu paragraphs\n",
+			"SetText",
+			setTextStats.median * 1e6,
+			breaker.GetWordCount(),
+			breaker.GetParagraphCount());
+		
+		AddResult(
+			"line break",
+			"SetText",
+			setTextStats,
+			static_cast<f64>(document.size()),
+			"characters");
+		
+		struct BreakCase
+		{
+			const char* name{};
+			LineBreakMode mode{};
+		};
+		
+		const BreakCase cases[] =
+		{
+			{ "greedy", LineBreakMode::BREAK_GREEDY },
+			{ "min raggedness", LineBreakMode::BREAK_MIN_RAGGEDNESS }
+		};
+		
+		for (const auto& c : cases)
+		{
+			size_t lineCount{};
+			BenchStats stats = MeasureStats([&]()
+				{
+					for (u32 step = 0; step < RESIZE_STEPS; ++step)
+					{
+						lineCount = breaker.Break(RESIZE_START_WIDTH + scast<f32>(step), c.mode).size();
+					}
+				});
+			
+			DoNotOptimize(lineCount);
+			printf(
+				"  %-16s %10.1f us per reflow %8zu lines\n",
+				c.name,
+				(stats.median / RESIZE_STEPS) * 1e6,
+				lineCount);
+			
+			AddResult(
+				"line break",
+				c.name,
+				stats,
+				RESIZE_STEPS,
+				"reflows");
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+
+#include "bench.hpp"
+
+using std::string;
+using std::ofstream;
+using std::ostringstream;
+using std::ios;
+using std::setprecision;
+using std::filesystem::path;
+
+using KalaFontBench::f64;
+using KalaFontBench::BenchResult;
+using KalaFontBench::benchResults;
+
+//Benchmark names are plain ascii, only quotes and backslashes need escaping
+static string EscapeJson(const string& text)
+{
+	string escaped{};
+	escaped.reserve(text.size());
+	
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') escaped += '\\';
+		escaped += c;
+	}
+	
+	return escaped;
+}
+
+static f64 GetThroughput(const BenchResult& r)
+{
+	return r.stats.median > 0.0 ? r.work / r.stats.median : 0.0;
+}
+
+static string BuildCsv()
+{
+	ostringstream csv{};
+	csv << setprecision(9)
+		<< "group,name,runs,min_s,median_s,p90_s,p99_s,max_s,work,unit,per_second\n";
+	
+	for (const auto& r : benchResults)
+	{
+		csv << r.group << ','
+			<< r.name << ','
+			<< r.stats.runs << ','
+			<< r.stats.min << ','
+			<< r.stats.median << ','
+			<< r.stats.p90 << ','
+			<< r.stats.p99 << ','
+			<< r.stats.max << ','
+			<< r.work << ','
+			<< r.unit << ','
+			<< GetThroughput(r) << '\n';
+	}
+	
+	return csv.str();
+}
+
+static string BuildJson()
+{
+	ostringstream json{};
+	json << setprecision(9)
+		<< "{\n  \"results\": [";
+	
+	for (size_t i = 0; i < benchResults.size(); ++i)
+	{
+		const BenchResult& r = benchResults[i];
+		
+		json << (i == 0 ? "\n" : ",\n")
+			<< "    { \"group\": \"" << EscapeJson(r.group) << "\", "
+			<< "\"name\": \"" << EscapeJson(r.name) << "\", "
+			<< "\"runs\": " << r.stats.runs << ", "
+			<< "\"minSeconds\": " << r.stats.min << ", "
+			<< "\"medianSeconds\": " << r.stats.median << ", "
+			<< "\"p90Seconds\": " << r.stats.p90 << ", "
+			<< "\"p99Seconds\": " << r.stats.p99 << ", "
+			<< "\"maxSeconds\": " << r.stats.max << ", "
+			<< "\"work\": " << r.work << ", "
+			<< "\"unit\": \"" << EscapeJson(r.unit) << "\", "
+			<< "\"perSecond\": " << GetThroughput(r) << " }";
+	}
+	
+	json << "\n  ]\n}\n";
+	
+	return json.str();
+}
+
+namespace KalaFontBench
+{
+	bool WriteResults(const string& resultsPath)
+	{
+		path target(resultsPath);
+		
+		string content{};
+		if (target.extension() == ".csv") content = BuildCsv();
+		else if (target.extension() == ".json") content = BuildJson();
+		else return false;
+		
+		ofstream file(target, ios::binary);
+		file << content;
+		file.close();
+		
+		return !file.fail();
+	}
+}
\ No newline at end of file
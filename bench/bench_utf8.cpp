@@ -0,0 +1,110 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+#include <vector>
+#include <string>
+
+#include "KalaHeaders/utf8_utils.hpp"
+
+#include "bench.hpp"
+
+using KalaHeaders::KalaUTF8::UTF8ToUTF32;
+using KalaHeaders::KalaUTF8::DecodeUTF8;
+using KalaHeaders::KalaUTF8::IsValidUTF8;
+using KalaHeaders::KalaUTF8::TranscodeResult;
+
+using std::vector;
+using std::string;
+using std::printf;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+
+//Size of each generated test text in bytes
+constexpr size_t CORPUS_SIZE = 8ull * 1024 * 1024;
+
+static string BuildCorpus(const char* piece)
+{
+	string corpus{};
+	corpus.reserve(CORPUS_SIZE + 64);
+	
+	while (corpus.size() < CORPUS_SIZE) corpus += piece;
+	
+	return corpus;
+}
+
+static void PrintRow(
+	const char* corpusName,
+	const char* pathName,
+	size_t bytes,
+	const KalaFontBench::BenchStats& stats)
+{
+	printf(
+		"  %-10s %-12s %10.1f MB/s\n",
+		corpusName,
+		pathName,
+		(bytes / (1024.0 * 1024.0)) / stats.median);
+	
+	KalaFontBench::AddResult(
+		"utf8",
+		string(corpusName) + " " + pathName,
+		stats,
+		static_cast<KalaFontBench::f64>(bytes),
+		"bytes");
+}
+
+namespace KalaFontBench
+{
+	void BenchUTF8()
+	{
+		struct Corpus
+		{
+			const char* name;
+			string text;
+		};
+		
+		vector<Corpus> corpora =
+		{
+			{ "ascii",  BuildCorpus("The quick brown fox jumps over the lazy dog. ") },
+			{ "latin",  BuildCorpus("P\xC3\xA4iv\xC3\xA4\xC3\xA4 ja hyv\xC3\xA4\xC3\xA4 y\xC3\xB6t\xC3\xA4, caf\xC3\xA9 cr\xC3\xA8me. ") },
+			{ "cjk",    BuildCorpus("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xE3\x80\x82") },
+			{ "emoji",  BuildCorpus("ok \xF0\x9F\x98\x80 \xF0\x9F\x91\x8D ") }
+		};
+		
+		printf("utf8 decode (median of %d runs)\n", MEASURED_RUNS);
+		
+		vector<u32> out(CORPUS_SIZE + 64);
+		
+		for (const auto& c : corpora)
+		{
+			const u8* data = reinterpret_cast<const u8*>(c.text.data());
+			size_t size = c.text.size();
+			
+			BenchStats transcode = MeasureStats([&]()
+				{
+					TranscodeResult r = UTF8ToUTF32(data, size, out.data(), out.size());
+					DoNotOptimize(r);
+				});
+			PrintRow(c.name, "UTF8ToUTF32", size, transcode);
+			
+			BenchStats scalar = MeasureStats([&]()
+				{
+					size_t i{};
+					size_t count{};
+					while (i < size) out[count++] = DecodeUTF8(data, size, i);
+					DoNotOptimize(count);
+				});
+			PrintRow(c.name, "DecodeUTF8", size, scalar);
+			
+			BenchStats validate = MeasureStats([&]()
+				{
+					bool isValid = IsValidUTF8(data, size);
+					DoNotOptimize(isValid);
+				});
+			PrintRow(c.name, "IsValidUTF8", size, validate);
+		}
+	}
+}
\ No newline at end of file
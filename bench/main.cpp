@@ -0,0 +1,35 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <cstdio>
+
+#include "bench.hpp"
+
+using std::printf;
+
+//Every argument is a results path, .csv and .json are written after all benchmarks ran
+int main(int argc, char* argv[])
+{
+	KalaFontBench::BenchUTF8();
+	KalaFontBench::BenchComposite();
+	KalaFontBench::BenchBatchLayout();
+	KalaFontBench::BenchLineBreak();
+	KalaFontBench::BenchRasterize();
+	KalaFontBench::BenchExport();
+	KalaFontBench::BenchImport();
+	KalaFontBench::BenchLookup();
+	
+	int result = 0;
+	
+	for (int i = 1; i < argc; ++i)
+	{
+		if (KalaFontBench::WriteResults(argv[i])) continue;
+		
+		printf("failed to write results '%s', only .csv and .json are supported\n", argv[i]);
+		result = 1;
+	}
+	
+	return result;
+}
\ No newline at end of file
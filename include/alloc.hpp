@@ -0,0 +1,125 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace KalaFont
+{
+	using std::size_t;
+	
+	using u8 = uint8_t;
+	
+	//Phases of one compile that allocations are counted under,
+	//allocations outside of every zone are counted as other
+	enum class AllocPhase : u8
+	{
+		ALLOC_OTHER,        //everything outside of the zones below
+		ALLOC_FACE_LOAD,    //opening faces, setting their size and walking the charmap
+		ALLOC_RENDER,       //FT_Load_Glyph and FT_Render_Glyph
+		ALLOC_GLYPH_BLOCKS, //the GlyphBlock vectors and their copied pixels
+		ALLOC_EXPORT,       //kfd buffers built and written by export
+		ALLOC_IMPORT,       //reading the exported kfd back in
+		ALLOC_COUNT
+	};
+	
+	//Counts every operator new and FreeType allocation per phase while KalaFont is built with
+	//KALAFONT_TRACK_ALLOCATIONS. Each allocation carries a small header with its size and phase
+	//so frees are taken off the phase that made them, even on another thread
+	class Alloc
+	{
+	public:
+		//Allocates size bytes aligned to at least alignment and counts them under the
+		//phase of the calling thread, returns nullptr if the system is out of memory
+		static void* Allocate(
+			size_t size,
+			size_t alignment,
+			bool isFreeType);
+		
+		//Frees memory from Allocate or Reallocate, nullptr is ignored
+		static void Free(void* block);
+		
+		//Moves a block to a new size the way realloc does
+		static void* Reallocate(
+			void* block,
+			size_t newSize,
+			bool isFreeType);
+		
+		//Phase that allocations of the calling thread are counted under
+		static AllocPhase GetPhase();
+		static void SetPhase(AllocPhase phase);
+		
+		//Clears the counts and starts the peaks from the bytes that are live right now
+		static void Reset();
+		
+		//Prints the counts of every phase since the last Reset
+		static void PrintReport(const char* command);
+	};
+	
+	//Counts allocations of the calling thread under one phase from construction until
+	//Stop or destruction, then goes back to the phase that was active before
+	class AllocZone
+	{
+	public:
+		explicit AllocZone(AllocPhase phase)
+			: previous(Alloc::GetPhase())
+		{
+			Alloc::SetPhase(phase);
+		}
+		~AllocZone() { Stop(); }
+		
+		AllocZone(const AllocZone&) = delete;
+		AllocZone& operator=(const AllocZone&) = delete;
+		
+		void Stop()
+		{
+			if (!isActive) return;
+			
+			isActive = false;
+			Alloc::SetPhase(previous);
+		}
+	private:
+		AllocPhase previous{};
+		bool isActive = true;
+	};
+	
+	//Resets the counts when a verbose command starts and prints them when it ends
+	class AllocSession
+	{
+	public:
+		AllocSession(
+			const char* command,
+			bool isActive)
+			: command(command),
+			isActive(isActive)
+		{
+			if (isActive) Alloc::Reset();
+		}
+		~AllocSession()
+		{
+			if (isActive) Alloc::PrintReport(command);
+		}
+		
+		AllocSession(const AllocSession&) = delete;
+		AllocSession& operator=(const AllocSession&) = delete;
+	private:
+		const char* command{};
+		bool isActive{};
+	};
+}
+
+//Allocation tracking only exists when KALAFONT_TRACK_ALLOCATIONS is defined, otherwise the zones
+//compile to nothing and operator new is not replaced
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+	#define ALLOC_ZONE(name, phase) KalaFont::AllocZone name(KalaFont::AllocPhase::phase)
+	#define ALLOC_STOP(name) name.Stop()
+	#define ALLOC_SESSION(command, isActive) KalaFont::AllocSession allocSession(command, isActive)
+#else
+	#define ALLOC_ZONE(name, phase)
+	#define ALLOC_STOP(name)
+	#define ALLOC_SESSION(command, isActive)
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	using std::filesystem::path;
+	
+	//One job of a manifest line, invalid lines have no params
+	struct ManifestJob
+	{
+		size_t line{};
+		vector<string> params{}; //parse command params, params[0] is the command name
+	};
+	
+	class Batch
+	{
+	public:
+		//Compiles every font listed in a manifest file in one process
+		//on a shared thread pool and prints one summary.
+		static void Command_Batch(const vector<string>& params);
+		
+		//Reads the manifest and expands every line into one job per type, height and quality.
+		//Paths in the params are relative to the manifest folder. Returns false if the
+		//manifest could not be read
+		static bool ReadManifest(
+			const path& manifestPath,
+			vector<ManifestJob>& outJobs);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+#include "parse.hpp"
+
+namespace KalaFont
+{
+	using std::string;
+	using std::filesystem::path;
+	
+	//Content addressed cache of compiled kfd files. Entries are keyed by a hash of the
+	//font bytes, the compile params, the tool version, the kfd version and the FreeType
+	//version, so any change to one of them is a miss. Set KALAFONT_CACHE_DIR to move the
+	//cache or to 'off' to disable it, KALAFONT_CACHE_MAX_MB to change its size limit
+	//and KALAFONT_CACHE_HARDLINK to 1 to restore entries as hardlinks instead of copies
+	class BuildCache
+	{
+	public:
+		//Returns the cache key of a job, or an empty string if the cache is
+		//disabled or the font could not be read
+		static string GetKey(
+			const CompileJob& job,
+			const string& freeTypeVersion);
+		
+		//Copies, or hardlinks when enabled, the cached kfd of this key to the target.
+		//Returns false on a miss or if the restored header does not pass GetHeaderData
+		static bool Restore(
+			const string& key,
+			const path& target,
+			CompileResult& outResult);
+		
+		//Adds a freshly compiled kfd to the cache and evicts the least
+		//recently used entries once the cache is over its size limit
+		static void Store(
+			const string& key,
+			const path& compiledFile);
+	};
+}
\ No newline at end of file
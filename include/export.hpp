@@ -24,20 +24,29 @@ namespace KalaFont
 	class Export
 	{
 	public:
-		//Export as ktf with bitmap type
-		static void ExportBitmap(
+		//Export as ktf with bitmap type, returns false if it failed
+		static bool ExportBitmap(
 			const path& targetPath,
 			u8 type,
 			u8 glyphHeight,
 			u8 superSampleMultiplier,
-			vector<GlyphBlock>& glyphBlocks);
+			const vector<GlyphBlock>& glyphBlocks);
 	
-		//Export as ktf with glyph type
-		static void ExportGlyph(
+		//Export as ktf with glyph type, returns false if it failed.
+		//The output only depends on the glyphs and params, the build cache relies on that
+		static bool ExportGlyph(
 			const path& targetPath,
 			u8 type,
 			u8 glyphHeight,
 			u8 superSampleMultiplier,
-			vector<GlyphBlock>& glyphBlocks);
+			const vector<GlyphBlock>& glyphBlocks);
+		
+		//Builds the kfd bytes ExportGlyph writes without touching the disk or logging success,
+		//returns false and prints the reason if the glyphs can not be exported
+		static bool SerializeGlyph(
+			u8 type,
+			u8 glyphHeight,
+			const vector<GlyphBlock>& glyphBlocks,
+			vector<u8>& outData);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <array>
+#include <filesystem>
+
+#include "KalaHeaders/import_kfd.hpp"
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	using std::array;
+	using std::filesystem::path;
+	
+	using KalaHeaders::KalaFontData::ImportResult;
+	
+	using u8 = uint8_t;
+	using u16 = uint16_t;
+	using u32 = uint32_t;
+	using u64 = uint64_t;
+	using f64 = double;
+	
+	//Where the bytes of one kfd file go and what it would weigh with each size option.
+	//Payload is the raw pixels of every glyph, block info is the 34 bytes in front of them
+	struct InspectStats
+	{
+		path file{};
+		ImportResult result{};
+		u8 type{};
+		u16 glyphHeight{};
+		u32 glyphCount{};
+		
+		u64 fileBytes{};
+		u64 headerBytes{};
+		u64 tableBytes{};
+		u64 infoBytes{};
+		u64 payloadBytes{};
+		u64 paddingBytes{};      //bytes outside of the header, table entries and glyph blocks
+		
+		u32 blankCount{};        //glyphs without a single covered pixel
+		u32 emptyCount{};        //blank glyphs that do not store any pixels
+		u64 blankBytes{};
+		u32 duplicateCount{};    //glyphs with the same size and pixels as an earlier glyph
+		u64 duplicateBytes{};    //payload bytes of the duplicates
+		u64 borderBytes{};       //fully transparent rows and columns around glyphs that are not blank
+		u64 rowPaddingBytes{};   //payload bytes past the glyph width at the end of each row
+		
+		vector<u32> payloadSizes{};
+		array<u64, 256> coverage{}; //how many pixels have each coverage value
+		
+		u64 quantized4Bytes{};   //payload with 4, 2 and 1 bits per pixel
+		u64 quantized2Bytes{};
+		u64 quantized1Bytes{};
+		u64 runLengthBytes{};    //payload as (count, value) byte pairs
+		f64 entropyBytes{};      //order 0 entropy of the payload, what an entropy coder could reach at best
+	};
+	
+	class Inspect
+	{
+	public:
+		//Reports where the bytes of one kfd file or of every kfd file in a folder go
+		//and how big they would be with each size option, files are read on a thread pool
+		static void Command_Inspect(const vector<string>& params);
+		
+		//Reads and measures one kfd file, result is RESULT_SUCCESS if it could be imported
+		static InspectStats InspectFile(const path& file);
+	};
+}
\ No newline at end of file
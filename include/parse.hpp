@@ -7,11 +7,35 @@
 
 #include <vector>
 #include <string>
+#include <filesystem>
 
 namespace KalaFont
 {
 	using std::vector;
 	using std::string;
+	using std::filesystem::path;
+	
+	using u8 = uint8_t;
+	using u32 = uint32_t;
+	using u64 = uint64_t;
+	
+	//One verified font to compile
+	struct CompileJob
+	{
+		path origin{};         //ttf or otf font
+		path target{};         //kfd output
+		u8 type{};             //1 = bitmap, 2 = glyph, 3 = instance
+		u32 phaseCount = 1;    //subpixel phases of every glyph
+		u8 glyphHeight{};
+		u8 supersampleMultiplier{};
+	};
+	
+	//What one compiled job produced
+	struct CompileResult
+	{
+		u32 glyphCount{};  //glyphs written, subpixel variants included
+		u64 outputBytes{}; //size of the written kfd
+	};
 	
 	class Parse
 	{
@@ -22,5 +46,43 @@ namespace KalaFont
 		//Compiles ttf and otf fonts to ktf for runtime use
 		//with the help of FreeType with additional verbose logging.
 		static void Command_VerboseParse(const vector<string>& params);
+		
+		//Checks the parse params, relative font and target paths are resolved from baseDir.
+		//Prints the reason and returns false if the params are invalid
+		static bool VerifyParams(
+			const vector<string>& params,
+			const path& baseDir,
+			CompileJob& outJob);
+		
+		//Loads, renders and exports one verified job, returns false if any step failed.
+		//renderThreads limits how many threads render its glyphs, 0 picks it from the glyph count.
+		//Safe to call from several threads at once, each thread keeps its own FreeType library
+		static bool Compile(
+			const CompileJob& job,
+			bool isVerbose,
+			u32 renderThreads,
+			CompileResult& outResult);
+		
+		//Verifies and compiles the parse params into a unique temporary kfd next to the target,
+		//which then replaces the target in one rename so readers never see a half written kfd.
+		//Unlike VerifyParams the target may exist, missing output folders are created
+		static bool CompileReplace(
+			const vector<string>& params,
+			const path& baseDir,
+			u32 renderThreads,
+			CompileResult& outResult);
+		
+		//Keeps opened faces and rendered glyphs in memory between compiles, so compiling
+		//a font again at a known glyph height skips loading and rendering. Used by serve.
+		//maxBytes limits the rendered glyphs, 0 disables it (the default)
+		static void SetResidentCache(u64 maxBytes);
+		
+		//Returns the resident cache size serve and watch use, KALAFONT_SERVE_CACHE_MB
+		//or 256 MB when it is not set
+		static u64 GetResidentCacheSize();
+		
+		//Returns the last error VerifyParams or Compile printed on the calling thread,
+		//empty if the last call failed without printing one
+		static const string& GetLastError();
 	};
 }
\ No newline at end of file
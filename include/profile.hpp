@@ -0,0 +1,143 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	using std::atomic;
+	using std::memory_order_relaxed;
+	using std::chrono::steady_clock;
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+	
+	using u8 = uint8_t;
+	using u64 = uint64_t;
+	
+	//Phases of one compile that --profile times
+	enum class ProfilePhase : u8
+	{
+		PHASE_VALIDATION,    //parse params and paths
+		PHASE_CACHE,         //build cache key, restore and store
+		PHASE_FACE_LOAD,     //opening the face and setting its size
+		PHASE_CHARMAP_WALK,  //collecting every glyph of the charmap
+		PHASE_GLYPH_LOAD,    //FT_Load_Glyph, summed over render threads
+		PHASE_RENDER,        //subpixel shift and FT_Render_Glyph, summed over render threads
+		PHASE_COPY,          //copying rendered bitmaps into glyph blocks, summed over render threads
+		PHASE_SERIALIZE,     //building the kfd in memory
+		PHASE_FILE_WRITE,    //writing the kfd to disk
+		PHASE_COUNT
+	};
+	
+	class Profile
+	{
+	public:
+		//Enables profiling for the commands that follow it in the same stack,
+		//each of them prints a phase table and adds a run to the json report.
+		static void Command_Profile(const vector<string>& params);
+		
+		//Records trace zones of the commands that follow it in the same stack
+		//and writes them as chrome trace event json when the program exits.
+		static void Command_Trace(const vector<string>& params);
+		
+		static bool IsEnabled() { return isEnabled.load(memory_order_relaxed); }
+		
+		//Safe to call from several threads at once
+		static void AddTime(
+			ProfilePhase phase,
+			u64 nanoseconds);
+		
+		//Safe to call from several threads at once
+		static void AddCount(
+			u64 glyphs,
+			u64 bytes);
+		
+		//Prints the phase table of everything recorded since the last report,
+		//rewrites the json report and starts the next run
+		static void Report(
+			const string& command,
+			u64 wallNanoseconds);
+	private:
+		static inline atomic<bool> isEnabled{};
+	};
+	
+	//Times one phase from construction until Stop or destruction
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(ProfilePhase phase)
+			: phase(phase),
+			isActive(Profile::IsEnabled())
+		{
+			if (isActive) start = steady_clock::now();
+		}
+		~ProfileZone() { Stop(); }
+		
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		
+		void Stop()
+		{
+			if (!isActive) return;
+			
+			isActive = false;
+			Profile::AddTime(
+				phase,
+				static_cast<u64>(duration_cast<nanoseconds>(steady_clock::now() - start).count()));
+		}
+	private:
+		ProfilePhase phase{};
+		bool isActive{};
+		steady_clock::time_point start{};
+	};
+	
+	//Times one whole command and prints its report when it goes out of scope
+	class ProfileSession
+	{
+	public:
+		explicit ProfileSession(const char* command)
+			: command(command),
+			isActive(Profile::IsEnabled())
+		{
+			if (isActive) start = steady_clock::now();
+		}
+		~ProfileSession()
+		{
+			if (!isActive) return;
+			
+			Profile::Report(
+				command,
+				static_cast<u64>(duration_cast<nanoseconds>(steady_clock::now() - start).count()));
+		}
+		
+		ProfileSession(const ProfileSession&) = delete;
+		ProfileSession& operator=(const ProfileSession&) = delete;
+	private:
+		const char* command{};
+		bool isActive{};
+		steady_clock::time_point start{};
+	};
+}
+
+//Profiling zones only exist when KALAFONT_PROFILE is defined, otherwise they compile to nothing.
+//With it defined a zone costs one relaxed load while --profile is not used
+#ifdef KALAFONT_PROFILE
+	#define PROFILE_ZONE(name, phase) KalaFont::ProfileZone name(KalaFont::ProfilePhase::phase)
+	#define PROFILE_STOP(name) name.Stop()
+	#define PROFILE_COUNT(glyphs, bytes) do { if (KalaFont::Profile::IsEnabled()) KalaFont::Profile::AddCount(glyphs, bytes); } while (0)
+	#define PROFILE_SESSION(command) KalaFont::ProfileSession profileSession(command)
+#else
+	#define PROFILE_ZONE(name, phase)
+	#define PROFILE_STOP(name)
+	#define PROFILE_COUNT(glyphs, bytes)
+	#define PROFILE_SESSION(command)
+#endif
\ No newline at end of file
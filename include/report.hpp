@@ -0,0 +1,93 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "KalaHeaders/import_kfd.hpp"
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	using std::filesystem::path;
+	using std::unique_ptr;
+	using std::atomic;
+	using std::thread;
+	using std::mutex;
+	using std::condition_variable;
+	
+	using KalaHeaders::KalaFontData::GlyphBlock;
+	
+	using u8 = uint8_t;
+	using u16 = uint16_t;
+	using u32 = uint32_t;
+	using u64 = uint64_t;
+	using i16 = int16_t;
+	
+	enum class ReportFormat : u8
+	{
+		FORMAT_TEXT,  //one compact line per glyph
+		FORMAT_CSV,   //header row, then one row per glyph
+		FORMAT_JSONL  //one json object per line
+	};
+	
+	//Metrics of one glyph as they are queued for the writer, the pixels are not copied
+	struct GlyphRecord
+	{
+		u32 charCode{};
+		u32 rawPixelSize{};
+		u16 width{};
+		u16 height{};
+		i16 bearingX{};
+		i16 bearingY{};
+		u16 advance{};
+	};
+	
+	//Glyph report of one verbose compile. Glyphs are queued into a ring buffer and a
+	//background thread formats and writes them while the compile carries on
+	class GlyphReport
+	{
+	public:
+		//Picks the format and target of the glyph report of the verbose commands that follow it
+		static void Command_Report(const vector<string>& params);
+		
+		//Starts the writer thread of one font
+		explicit GlyphReport(const path& fontPath);
+		//Waits until every queued glyph is written
+		~GlyphReport();
+		
+		GlyphReport(const GlyphReport&) = delete;
+		GlyphReport& operator=(const GlyphReport&) = delete;
+		
+		//Queues one glyph, only waits if the writer is a whole ring behind
+		void Add(const GlyphBlock& glyph);
+	private:
+		void Write();
+		
+		string font{};
+		ReportFormat format{};
+		path target{};           //empty writes to stdout
+		bool isFirstInFile{};    //the first report of a file replaces it and writes the csv header
+		
+		unique_ptr<GlyphRecord[]> records{};
+		alignas(64) atomic<u64> head{}; //next record to queue
+		alignas(64) atomic<u64> tail{}; //next record to write
+		atomic<bool> isDone{};
+		
+		mutex wakeMutex{};
+		condition_variable wakeCondition{};
+		
+		thread writer{};
+	};
+}
\ No newline at end of file
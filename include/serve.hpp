@@ -0,0 +1,30 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	
+	//Every frame is a u32 little endian payload size followed by the payload.
+	//  - request:  u32 id, then type, height, quality, origin and target as text separated by '\0',
+	//              an empty target returns the kfd bytes instead of writing it and type 'stop'
+	//              stops the server once the queued requests are done
+	//  - response: u32 id, u8 status (0 = compiled, 1 = failed), u32 glyph count, then the kfd bytes,
+	//              nothing for a written target or the error message of a failed request
+	//Responses are sent as requests finish, so they can arrive in a different order than the requests
+	class Serve
+	{
+	public:
+		//Keeps FreeType, faces and rendered glyphs warm and compiles requests from clients
+		//of a unix domain socket, or from stdin and stdout, on a pool of threads.
+		static void Command_Serve(const vector<string>& params);
+	};
+}
\ No newline at end of file
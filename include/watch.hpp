@@ -0,0 +1,23 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace KalaFont
+{
+	using std::vector;
+	using std::string;
+	
+	class Watch
+	{
+	public:
+		//Compiles every job of a manifest and then recompiles the jobs whose font
+		//or manifest line changed until the process is stopped.
+		static void Command_Watch(const vector<string>& params);
+	};
+}
\ No newline at end of file
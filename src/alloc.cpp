@@ -0,0 +1,289 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+//Nothing here is built without KALAFONT_TRACK_ALLOCATIONS so the default operator new stays in place
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "KalaHeaders/log_utils.hpp"
+
+#include "alloc.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaFont::Alloc;
+using KalaFont::AllocPhase;
+
+using std::atomic;
+using std::memory_order_relaxed;
+using std::malloc;
+using std::free;
+using std::memcpy;
+using std::max;
+using std::min;
+using std::string;
+using std::ostringstream;
+using std::fixed;
+using std::setw;
+using std::setprecision;
+using std::left;
+using std::right;
+using std::bad_alloc;
+using std::nothrow_t;
+using std::align_val_t;
+using std::max_align_t;
+
+using u8 = uint8_t;
+using u64 = uint64_t;
+using i64 = int64_t;
+using f64 = double;
+
+constexpr size_t PHASE_COUNT = static_cast<size_t>(AllocPhase::ALLOC_COUNT);
+
+//Names in the report, same order as AllocPhase
+constexpr const char* PHASE_NAMES[PHASE_COUNT] =
+{
+	"other",
+	"face load",
+	"render",
+	"glyph blocks",
+	"export",
+	"import"
+};
+
+//Space in front of every block for its header, keeps the default new alignment
+constexpr size_t HEADER_SPACE = 32;
+
+//Stored right in front of every block
+struct AllocHeader
+{
+	void* base{}; //what malloc returned
+	size_t size{};
+	u8 phase{};
+};
+
+static_assert(sizeof(AllocHeader) <= HEADER_SPACE);
+
+//Counts of one phase since the last reset, live and peak count every thread
+struct alignas(64) PhaseCounts
+{
+	atomic<u64> allocations{};
+	atomic<u64> bytes{};
+	atomic<u64> freeTypeBytes{};
+	atomic<i64> live{};
+	atomic<i64> peak{};
+};
+
+static PhaseCounts phaseCounts[PHASE_COUNT]{};
+static atomic<i64> totalLive{};
+static atomic<i64> totalPeak{};
+
+static thread_local AllocPhase currentPhase = AllocPhase::ALLOC_OTHER;
+
+static void RaisePeak(
+	atomic<i64>& peak,
+	i64 value)
+{
+	i64 current = peak.load(memory_order_relaxed);
+	while (value > current
+		&& !peak.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+}
+
+static f64 ToMegabytes(i64 bytes)
+{
+	return static_cast<f64>(max<i64>(bytes, 0)) / (1024.0 * 1024.0);
+}
+
+static void* AllocateOrThrow(
+	size_t size,
+	size_t alignment)
+{
+	void* block = Alloc::Allocate(size, alignment, false);
+	if (!block) throw bad_alloc();
+	
+	return block;
+}
+
+namespace KalaFont
+{
+	void* Alloc::Allocate(
+		size_t size,
+		size_t alignment,
+		bool isFreeType)
+	{
+		alignment = max(alignment, alignof(max_align_t));
+		
+		//over aligned blocks need room to move the block up to the alignment
+		size_t extra = alignment > HEADER_SPACE ? alignment : 0;
+		
+		void* base = malloc(size + HEADER_SPACE + extra);
+		if (!base) return nullptr;
+		
+		uintptr_t address = reinterpret_cast<uintptr_t>(base) + HEADER_SPACE;
+		address = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+		
+		AllocHeader* header = reinterpret_cast<AllocHeader*>(address) - 1;
+		*header = AllocHeader
+		{
+			.base = base,
+			.size = size,
+			.phase = static_cast<u8>(currentPhase)
+		};
+		
+		PhaseCounts& counts = phaseCounts[header->phase];
+		counts.allocations.fetch_add(1, memory_order_relaxed);
+		counts.bytes.fetch_add(size, memory_order_relaxed);
+		if (isFreeType) counts.freeTypeBytes.fetch_add(size, memory_order_relaxed);
+		
+		i64 signedSize = static_cast<i64>(size);
+		RaisePeak(counts.peak, counts.live.fetch_add(signedSize, memory_order_relaxed) + signedSize);
+		RaisePeak(totalPeak, totalLive.fetch_add(signedSize, memory_order_relaxed) + signedSize);
+		
+		return reinterpret_cast<void*>(address);
+	}
+	
+	void Alloc::Free(void* block)
+	{
+		if (!block) return;
+		
+		AllocHeader* header = static_cast<AllocHeader*>(block) - 1;
+		
+		i64 signedSize = static_cast<i64>(header->size);
+		phaseCounts[header->phase].live.fetch_sub(signedSize, memory_order_relaxed);
+		totalLive.fetch_sub(signedSize, memory_order_relaxed);
+		
+		free(header->base);
+	}
+	
+	void* Alloc::Reallocate(
+		void* block,
+		size_t newSize,
+		bool isFreeType)
+	{
+		if (!block) return Allocate(newSize, 0, isFreeType);
+		
+		void* newBlock = Allocate(newSize, 0, isFreeType);
+		if (!newBlock) return nullptr;
+		
+		const AllocHeader* header = static_cast<const AllocHeader*>(block) - 1;
+		memcpy(newBlock, block, min(header->size, newSize));
+		
+		Free(block);
+		
+		return newBlock;
+	}
+	
+	AllocPhase Alloc::GetPhase()
+	{
+		return currentPhase;
+	}
+	
+	void Alloc::SetPhase(AllocPhase phase)
+	{
+		currentPhase = phase;
+	}
+	
+	void Alloc::Reset()
+	{
+		for (auto& counts : phaseCounts)
+		{
+			counts.allocations.store(0, memory_order_relaxed);
+			counts.bytes.store(0, memory_order_relaxed);
+			counts.freeTypeBytes.store(0, memory_order_relaxed);
+			counts.peak.store(counts.live.load(memory_order_relaxed), memory_order_relaxed);
+		}
+		
+		totalPeak.store(totalLive.load(memory_order_relaxed), memory_order_relaxed);
+	}
+	
+	void Alloc::PrintReport(const char* command)
+	{
+		//read everything before building the report so its own allocations are not counted
+		
+		u64 allocations[PHASE_COUNT]{};
+		u64 bytes[PHASE_COUNT]{};
+		u64 freeTypeBytes[PHASE_COUNT]{};
+		i64 peaks[PHASE_COUNT]{};
+		
+		u64 allocationTotal{};
+		u64 byteTotal{};
+		
+		for (size_t i = 0; i < PHASE_COUNT; ++i)
+		{
+			allocations[i] = phaseCounts[i].allocations.load(memory_order_relaxed);
+			bytes[i] = phaseCounts[i].bytes.load(memory_order_relaxed);
+			freeTypeBytes[i] = phaseCounts[i].freeTypeBytes.load(memory_order_relaxed);
+			peaks[i] = phaseCounts[i].peak.load(memory_order_relaxed);
+			
+			allocationTotal += allocations[i];
+			byteTotal += bytes[i];
+		}
+		
+		i64 peakTotal = totalPeak.load(memory_order_relaxed);
+		
+		ostringstream table{};
+		table << fixed << setprecision(3)
+			<< "Allocations of " << command << ": " << allocationTotal << " allocations, "
+			<< ToMegabytes(static_cast<i64>(byteTotal)) << " MB allocated, peak "
+			<< ToMegabytes(peakTotal) << " MB live\n"
+			<< "  " << left << setw(14) << "phase" << right
+			<< setw(12) << "allocs" << setw(14) << "MB alloc" << setw(14) << "FreeType MB" << setw(12) << "peak MB";
+		
+		for (size_t i = 0; i < PHASE_COUNT; ++i)
+		{
+			table << "\n  " << left << setw(14) << PHASE_NAMES[i] << right
+				<< setw(12) << allocations[i]
+				<< setw(14) << ToMegabytes(static_cast<i64>(bytes[i]))
+				<< setw(14) << ToMegabytes(static_cast<i64>(freeTypeBytes[i]))
+				<< setw(12) << ToMegabytes(peaks[i]);
+		}
+		
+		table << "\n  peak MB is the most memory a phase held at once, summed over every thread";
+		
+		Log::Print(
+			table.str(),
+			"ALLOC",
+			LogType::LOG_INFO);
+	}
+}
+
+//
+// GLOBAL OPERATOR NEW AND DELETE
+//
+
+void* operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(size_t size, align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+
+void* operator new(size_t size, const nothrow_t&) noexcept { return Alloc::Allocate(size, 0, false); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return Alloc::Allocate(size, 0, false); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept { return Alloc::Allocate(size, static_cast<size_t>(alignment), false); }
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept { return Alloc::Allocate(size, static_cast<size_t>(alignment), false); }
+
+void operator delete(void* block) noexcept { Alloc::Free(block); }
+void operator delete[](void* block) noexcept { Alloc::Free(block); }
+void operator delete(void* block, size_t) noexcept { Alloc::Free(block); }
+void operator delete[](void* block, size_t) noexcept { Alloc::Free(block); }
+void operator delete(void* block, align_val_t) noexcept { Alloc::Free(block); }
+void operator delete[](void* block, align_val_t) noexcept { Alloc::Free(block); }
+void operator delete(void* block, size_t, align_val_t) noexcept { Alloc::Free(block); }
+void operator delete[](void* block, size_t, align_val_t) noexcept { Alloc::Free(block); }
+void operator delete(void* block, const nothrow_t&) noexcept { Alloc::Free(block); }
+void operator delete[](void* block, const nothrow_t&) noexcept { Alloc::Free(block); }
+void operator delete(void* block, align_val_t, const nothrow_t&) noexcept { Alloc::Free(block); }
+void operator delete[](void* block, align_val_t, const nothrow_t&) noexcept { Alloc::Free(block); }
+
+#endif
\ No newline at end of file
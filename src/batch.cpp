@@ -0,0 +1,365 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <unordered_set>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/trace_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "batch.hpp"
+#include "parse.hpp"
+#include "profile.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::WorkPool;
+
+using KalaCLI::Core;
+
+using KalaFont::ManifestJob;
+using KalaFont::Parse;
+using KalaFont::CompileResult;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ifstream;
+using std::ostringstream;
+using std::unordered_set;
+using std::move;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::is_regular_file;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Fields of one manifest line, the same order as the parse command params
+constexpr size_t MANIFEST_FIELD_COUNT = 5;
+
+//One compile job and the manifest line it came from
+struct BatchJob
+{
+	size_t line{};
+	vector<string> params{}; //parse command params, params[0] is the command name
+	CompileResult result{};
+	f64 seconds{};
+	bool isValid{};
+	bool isCompiled{};
+};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"BATCH",
+		LogType::LOG_ERROR,
+		2);
+}
+
+//Splits a manifest line at whitespace, text inside double quotes stays one field
+//so paths can have spaces. Everything after an unquoted '#' is a comment
+static vector<string> SplitFields(const string& line)
+{
+	vector<string> fields{};
+	string field{};
+	
+	bool isQuoted{};
+	bool hasField{};
+	
+	for (char c : line)
+	{
+		if (c == '"')
+		{
+			isQuoted = !isQuoted;
+			hasField = true;
+			continue;
+		}
+		
+		if (!isQuoted
+			&& c == '#')
+		{
+			break;
+		}
+		
+		if (!isQuoted
+			&& (c == ' ' || c == '\t' || c == '\r'))
+		{
+			if (hasField) fields.push_back(field);
+			
+			field.clear();
+			hasField = false;
+			continue;
+		}
+		
+		field += c;
+		hasField = true;
+	}
+	
+	if (hasField) fields.push_back(field);
+	
+	return fields;
+}
+
+static vector<string> SplitList(const string& value)
+{
+	vector<string> values{};
+	
+	size_t start{};
+	while (start <= value.size())
+	{
+		size_t end = value.find(',', start);
+		if (end == string::npos) end = value.size();
+		
+		if (end > start) values.push_back(value.substr(start, end - start));
+		
+		start = end + 1;
+	}
+	
+	return values;
+}
+
+static string ReplaceAll(
+	string text,
+	const string& from,
+	const string& to)
+{
+	for (size_t i = text.find(from); i != string::npos; i = text.find(from, i + to.size()))
+	{
+		text.replace(i, from.size(), to);
+	}
+	
+	return text;
+}
+
+static bool ReadManifestFile(
+	const path& manifestPath,
+	vector<ManifestJob>& outJobs)
+{
+	ifstream in(manifestPath);
+	if (!in)
+	{
+		PrintError("Failed to read manifest '" + manifestPath.string() + "'!");
+		
+		return false;
+	}
+	
+	string text{};
+	size_t lineNumber{};
+	
+	while (getline(in, text))
+	{
+		++lineNumber;
+		
+		vector<string> fields = SplitFields(text);
+		if (fields.empty()) continue;
+		
+		if (fields.size() != MANIFEST_FIELD_COUNT)
+		{
+			PrintError(
+				"Manifest line " + to_string(lineNumber) + " has " + to_string(fields.size())
+				+ " fields, expected " + to_string(MANIFEST_FIELD_COUNT) + " (type height quality origin target)!");
+			
+			outJobs.push_back(ManifestJob{ .line = lineNumber });
+			continue;
+		}
+		
+		for (const auto& type : SplitList(fields[0]))
+		{
+			for (const auto& height : SplitList(fields[1]))
+			{
+				for (const auto& quality : SplitList(fields[2]))
+				{
+					//':' of subpixel types is not allowed in windows file names
+					
+					string typeName = ReplaceAll(type, ":", "");
+					
+					string target = fields[4];
+					target = ReplaceAll(target, "{type}", typeName);
+					target = ReplaceAll(target, "{height}", height);
+					target = ReplaceAll(target, "{quality}", quality);
+					
+					outJobs.push_back(ManifestJob
+					{
+						.line = lineNumber,
+						.params = { "batch", type, height, quality, fields[3], target }
+					});
+				}
+			}
+		}
+	}
+	
+	return true;
+}
+
+namespace KalaFont
+{
+	void Batch::Command_Batch(const vector<string>& params)
+	{
+		KALA_TRACE_ZONE("Batch");
+		PROFILE_SESSION("batch");
+		
+		auto start = steady_clock::now();
+		
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		path manifestPath = weakly_canonical(path(currentDir) / params[1]);
+		
+		if (!is_regular_file(manifestPath))
+		{
+			PrintError("Failed to run batch because manifest '" + manifestPath.string() + "' does not exist!");
+			
+			return;
+		}
+		
+		vector<ManifestJob> manifestJobs{};
+		if (!ReadManifest(manifestPath, manifestJobs)) return;
+		
+		vector<BatchJob> jobs(manifestJobs.size());
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			jobs[i].line = manifestJobs[i].line;
+			jobs[i].params = move(manifestJobs[i].params);
+		}
+		
+		if (jobs.empty())
+		{
+			PrintError("Failed to run batch because manifest '" + manifestPath.string() + "' has no jobs!");
+			
+			return;
+		}
+		
+		//
+		// VERIFY JOBS
+		//
+		
+		//paths are relative to the manifest, the params themselves are verified by CompileReplace
+		//so targets of an earlier run are replaced instead of rejected
+		
+		const path baseDir = manifestPath.parent_path();
+		unordered_set<string> targets{};
+		
+		for (auto& j : jobs)
+		{
+			if (j.params.empty()) continue;
+			
+			path target = weakly_canonical(baseDir / j.params[5]);
+			
+			if (!targets.insert(target.string()).second)
+			{
+				PrintError(
+					"Manifest line " + to_string(j.line) + " writes to '" + target.string()
+					+ "' which an earlier job already writes to!");
+				
+				continue;
+			}
+			
+			j.isValid = true;
+		}
+		
+		//
+		// COMPILE JOBS
+		//
+		
+		//whole fonts are spread over the pool, fonts only render their glyphs on
+		//several threads when there are fewer fonts than threads
+		
+		WorkPool pool{};
+		
+		u32 validCount{};
+		for (const auto& j : jobs) validCount += j.isValid ? 1 : 0;
+		
+		u32 renderThreads = validCount >= pool.GetThreadCount()
+			? 1
+			: pool.GetThreadCount() / (validCount == 0 ? 1 : validCount);
+		
+		pool.ParallelFor(
+			jobs.size(),
+			1,
+			[&jobs, &baseDir, renderThreads](size_t begin, size_t end, u32)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					BatchJob& j = jobs[i];
+					if (!j.isValid) continue;
+					
+					auto jobStart = steady_clock::now();
+					
+					j.isCompiled = Parse::CompileReplace(j.params, baseDir, renderThreads, j.result);
+					j.seconds = duration<f64>(steady_clock::now() - jobStart).count();
+				}
+			});
+		
+		//
+		// SUMMARY
+		//
+		
+		u32 compiledCount{};
+		u64 glyphCount{};
+		u64 outputBytes{};
+		f64 jobSeconds{};
+		
+		ostringstream failed{};
+		
+		for (const auto& j : jobs)
+		{
+			if (j.isCompiled)
+			{
+				++compiledCount;
+				glyphCount += j.result.glyphCount;
+				outputBytes += j.result.outputBytes;
+				jobSeconds += j.seconds;
+				continue;
+			}
+			
+			failed << "\n    line " << j.line;
+			if (!j.params.empty()) failed << ": " << j.params[1] << " " << j.params[2] << " -> " << j.params[5];
+		}
+		
+		f64 totalSeconds = duration<f64>(steady_clock::now() - start).count();
+		u32 failedCount = static_cast<u32>(jobs.size()) - compiledCount;
+		
+		ostringstream summary{};
+		summary << "Batch finished: " << compiledCount << " of " << jobs.size() << " jobs compiled, "
+			<< glyphCount << " glyphs, " << (outputBytes / 1024) << " KB written in "
+			<< totalSeconds << " s on " << pool.GetThreadCount() << " threads ("
+			<< jobSeconds << " s of compile time)";
+		
+		if (failedCount > 0)
+		{
+			summary << "\n  " << failedCount << " jobs failed:" << failed.str();
+			
+			PrintError(summary.str());
+			
+			return;
+		}
+		
+		Log::Print(
+			summary.str(),
+			"BATCH",
+			LogType::LOG_SUCCESS);
+	}
+	
+	bool Batch::ReadManifest(
+		const path& manifestPath,
+		vector<ManifestJob>& outJobs)
+	{
+		return ReadManifestFile(manifestPath, outJobs);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,401 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/import_kfd.hpp"
+
+#include "cache.hpp"
+
+//Set by CMake from PROGRAM_VERSION_NUMBER
+#ifndef KALAFONT_VERSION
+	#define KALAFONT_VERSION "0.0.0.0"
+#endif
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::ImportResult;
+using KalaHeaders::KalaFontData::GetHeaderData;
+using KalaHeaders::KalaFontData::KFD_VERSION;
+
+using KalaFont::BuildCache;
+using KalaFont::CompileJob;
+using KalaFont::CompileResult;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ifstream;
+using std::ios;
+using std::istreambuf_iterator;
+using std::ostringstream;
+using std::hex;
+using std::setw;
+using std::setfill;
+using std::sort;
+using std::getenv;
+using std::strtoull;
+using std::memcpy;
+using std::random_device;
+using std::error_code;
+using std::filesystem::path;
+using std::filesystem::exists;
+using std::filesystem::create_directories;
+using std::filesystem::create_hard_link;
+using std::filesystem::copy_file;
+using std::filesystem::copy_options;
+using std::filesystem::rename;
+using std::filesystem::remove;
+using std::filesystem::file_size;
+using std::filesystem::last_write_time;
+using std::filesystem::file_time_type;
+using std::filesystem::directory_iterator;
+using std::filesystem::temp_directory_path;
+
+using u8 = uint8_t;
+using u64 = uint64_t;
+
+//Size limit of the cache when KALAFONT_CACHE_MAX_MB is not set
+constexpr u64 DEFAULT_CACHE_MAX_MB = 512;
+
+//xxHash64 primes
+constexpr u64 PRIME_1 = 0x9E3779B185EBCA87ull;
+constexpr u64 PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr u64 PRIME_3 = 0x165667B19E3779F9ull;
+constexpr u64 PRIME_4 = 0x85EBCA77C2B2AE63ull;
+constexpr u64 PRIME_5 = 0x27D4EB2F165667C5ull;
+
+static u64 RotateLeft(u64 value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static u64 ReadU64(const u8* data)
+{
+	u64 value{};
+	memcpy(&value, data, sizeof(u64));
+	return value;
+}
+
+static u64 Round(u64 acc, u64 input)
+{
+	acc += input * PRIME_2;
+	acc = RotateLeft(acc, 31);
+	return acc * PRIME_1;
+}
+
+static u64 MergeRound(u64 acc, u64 value)
+{
+	acc ^= Round(0, value);
+	return acc * PRIME_1 + PRIME_4;
+}
+
+//xxHash64, reads about as fast as memory so hashing fonts costs far less than compiling them
+static u64 Hash64(
+	const u8* data,
+	size_t size,
+	u64 seed)
+{
+	const u8* end = data + size;
+	u64 h{};
+	
+	if (size >= 32)
+	{
+		u64 v1 = seed + PRIME_1 + PRIME_2;
+		u64 v2 = seed + PRIME_2;
+		u64 v3 = seed;
+		u64 v4 = seed - PRIME_1;
+		
+		for (; data + 32 <= end; data += 32)
+		{
+			v1 = Round(v1, ReadU64(data + 0));
+			v2 = Round(v2, ReadU64(data + 8));
+			v3 = Round(v3, ReadU64(data + 16));
+			v4 = Round(v4, ReadU64(data + 24));
+		}
+		
+		h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		h = MergeRound(h, v1);
+		h = MergeRound(h, v2);
+		h = MergeRound(h, v3);
+		h = MergeRound(h, v4);
+	}
+	else h = seed + PRIME_5;
+	
+	h += static_cast<u64>(size);
+	
+	for (; data + 8 <= end; data += 8)
+	{
+		h ^= Round(0, ReadU64(data));
+		h = RotateLeft(h, 27) * PRIME_1 + PRIME_4;
+	}
+	if (data + 4 <= end)
+	{
+		uint32_t word{};
+		memcpy(&word, data, sizeof(word));
+		
+		h ^= static_cast<u64>(word) * PRIME_1;
+		h = RotateLeft(h, 23) * PRIME_2 + PRIME_3;
+		data += 4;
+	}
+	for (; data < end; ++data)
+	{
+		h ^= static_cast<u64>(*data) * PRIME_5;
+		h = RotateLeft(h, 11) * PRIME_1;
+	}
+	
+	h ^= h >> 33;
+	h *= PRIME_2;
+	h ^= h >> 29;
+	h *= PRIME_3;
+	h ^= h >> 32;
+	
+	return h;
+}
+
+static string ToHex(u64 value)
+{
+	ostringstream oss{};
+	oss << hex << setw(16) << setfill('0') << value;
+	return oss.str();
+}
+
+//Returns the cache folder, or an empty path if the cache is disabled or can not be created
+static path GetCacheDir()
+{
+	const char* env = getenv("KALAFONT_CACHE_DIR");
+	
+	path dir{};
+	if (env
+		&& *env != '\0')
+	{
+		if (string(env) == "off") return {};
+		dir = path(env);
+	}
+	else
+	{
+		error_code ec{};
+		dir = temp_directory_path(ec);
+		if (ec) return {};
+		
+		dir = dir / "KalaFont" / "cache";
+	}
+	
+	error_code ec{};
+	create_directories(dir, ec);
+	if (ec) return {};
+	
+	return dir;
+}
+
+static u64 GetMaxBytes()
+{
+	const char* env = getenv("KALAFONT_CACHE_MAX_MB");
+	
+	u64 megabytes = env
+		? strtoull(env, nullptr, 10)
+		: DEFAULT_CACHE_MAX_MB;
+	
+	if (megabytes == 0) megabytes = DEFAULT_CACHE_MAX_MB;
+	
+	return megabytes * 1024 * 1024;
+}
+
+//Hardlinks share one file with the cache entry, so editing a linked output in place
+//would also change the entry. They are only used when KALAFONT_CACHE_HARDLINK is 1
+static bool IsHardLinkEnabled()
+{
+	const char* env = getenv("KALAFONT_CACHE_HARDLINK");
+	
+	return env
+		&& string(env) == "1";
+}
+
+//Drops the least recently used entries until the cache fits its size limit,
+//restored entries are touched so they count as recently used
+static void Evict(
+	const path& dir,
+	u64 maxBytes)
+{
+	struct Entry
+	{
+		path file{};
+		file_time_type time{};
+		u64 size{};
+	};
+	
+	vector<Entry> entries{};
+	u64 totalBytes{};
+	
+	error_code ec{};
+	for (const auto& e : directory_iterator(dir, ec))
+	{
+		if (e.path().extension() != ".kfd") continue;
+		
+		error_code entryEc{};
+		Entry entry
+		{
+			.file = e.path(),
+			.time = e.last_write_time(entryEc),
+			.size = static_cast<u64>(e.file_size(entryEc))
+		};
+		if (entryEc) continue;
+		
+		totalBytes += entry.size;
+		entries.push_back(entry);
+	}
+	
+	if (totalBytes <= maxBytes) return;
+	
+	sort(
+		entries.begin(),
+		entries.end(),
+		[](const Entry& a, const Entry& b) { return a.time < b.time; });
+	
+	for (const auto& e : entries)
+	{
+		if (totalBytes <= maxBytes) break;
+		
+		error_code removeEc{};
+		if (remove(e.file, removeEc)) totalBytes -= e.size;
+	}
+}
+
+namespace KalaFont
+{
+	string BuildCache::GetKey(
+		const CompileJob& job,
+		const string& freeTypeVersion)
+	{
+		if (GetCacheDir().empty()) return {};
+		
+		ifstream in(job.origin, ios::binary);
+		if (!in) return {};
+		
+		vector<u8> bytes(
+			(istreambuf_iterator<char>(in)),
+			istreambuf_iterator<char>());
+		
+		//two differently seeded hashes of the font so a 64-bit collision alone is not a hit
+		
+		ostringstream params{};
+		params << "kalafont " << KALAFONT_VERSION
+			<< " kfd " << static_cast<int>(KFD_VERSION)
+			<< " freetype " << freeTypeVersion
+			<< " type " << static_cast<int>(job.type)
+			<< " phases " << job.phaseCount
+			<< " height " << static_cast<int>(job.glyphHeight)
+			<< " supersample " << static_cast<int>(job.supersampleMultiplier)
+			<< " font " << ToHex(Hash64(bytes.data(), bytes.size(), 0))
+			<< ToHex(Hash64(bytes.data(), bytes.size(), PRIME_5))
+			<< " size " << bytes.size();
+		
+		const string text = params.str();
+		const u8* textBytes = reinterpret_cast<const u8*>(text.data());
+		
+		return ToHex(Hash64(textBytes, text.size(), 0)) + ToHex(Hash64(textBytes, text.size(), PRIME_5));
+	}
+	
+	bool BuildCache::Restore(
+		const string& key,
+		const path& target,
+		CompileResult& outResult)
+	{
+		path dir = GetCacheDir();
+		if (dir.empty()) return false;
+		
+		path entry = dir / (key + ".kfd");
+		
+		error_code ec{};
+		if (!exists(entry, ec)) return false;
+		
+		//copied by default, opted in hardlinks fall back to a copy across drives
+		
+		bool isLinked{};
+		if (IsHardLinkEnabled())
+		{
+			create_hard_link(entry, target, ec);
+			isLinked = !ec;
+			ec.clear();
+		}
+		
+		if (!isLinked)
+		{
+			copy_file(entry, target, ec);
+			if (ec) return false;
+		}
+		
+		//a damaged entry is dropped so the font is compiled and stored again
+		
+		GlyphHeader header{};
+		if (GetHeaderData(target, header) != ImportResult::RESULT_SUCCESS)
+		{
+			remove(target, ec);
+			remove(entry, ec);
+			
+			Log::Print(
+				"Dropped a damaged build cache entry of '" + target.string() + "', compiling it instead.",
+				"CACHE",
+				LogType::LOG_WARNING);
+			
+			return false;
+		}
+		
+		last_write_time(entry, file_time_type::clock::now(), ec);
+		
+		outResult = CompileResult
+		{
+			.glyphCount = header.glyphCount,
+			.outputBytes = static_cast<u64>(file_size(target, ec))
+		};
+		
+		Log::Print(
+			"Restored '" + target.string() + "' from the build cache.",
+			"CACHE",
+			LogType::LOG_SUCCESS);
+		
+		return true;
+	}
+	
+	void BuildCache::Store(
+		const string& key,
+		const path& compiledFile)
+	{
+		path dir = GetCacheDir();
+		if (dir.empty()) return;
+		
+		error_code ec{};
+		if (!exists(compiledFile, ec)) return;
+		
+		//copied under a unique name first and renamed into place so other
+		//threads or processes never see a half written entry
+		
+		static thread_local random_device random{};
+		path temp = dir / (key + "." + ToHex((static_cast<u64>(random()) << 32) | random()) + ".tmp");
+		
+		copy_file(compiledFile, temp, copy_options::overwrite_existing, ec);
+		if (ec) return;
+		
+		rename(temp, dir / (key + ".kfd"), ec);
+		if (ec)
+		{
+			remove(temp, ec);
+			return;
+		}
+		
+		Evict(dir, GetMaxBytes());
+	}
+}
\ No newline at end of file
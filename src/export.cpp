@@ -5,12 +5,17 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include "KalaHeaders/log_utils.hpp"
 #include "KalaHeaders/file_utils.hpp"
 #include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/trace_utils.hpp"
 
 #include "export.hpp"
+#include "profile.hpp"
+#include "alloc.hpp"
 
 using KalaHeaders::KalaLog::Log;
 using KalaHeaders::KalaLog::LogType;
@@ -26,14 +31,20 @@ using KalaHeaders::KalaFontData::CORRECT_GLYPH_TABLE_SIZE;
 using KalaHeaders::KalaFontData::RAW_PIXEL_DATA_OFFSET;
 using KalaHeaders::KalaFontData::MAX_GLYPH_COUNT;
 using KalaHeaders::KalaFontData::MAX_GLYPH_TABLE_SIZE;
+using KalaHeaders::KalaFontData::GlyphInstance;
+using KalaHeaders::KalaFontData::KFD_ATLAS_PAGE_SIZE;
+using KalaHeaders::KalaFontData::KFD_ATLAS_PADDING;
 
 using std::ofstream;
 using std::ios;
 using std::string;
 using std::to_string;
+using std::vector;
+using std::stable_sort;
 
 using i8 = int8_t;
 using i16 = int16_t;
+using u16 = uint16_t;
 using u32 = uint32_t;
 
 static void PrintError(const string& message, bool isBitMap)
@@ -47,22 +58,98 @@ static void PrintError(const string& message, bool isBitMap)
 		2);
 }
 
+//Places every glyph into atlas pages with shelf packing, tallest glyphs first
+//so each shelf wastes as little height as possible. Returns false if a glyph
+//does not fit into an empty page
+static bool PlaceInAtlas(
+	const vector<GlyphBlock>& glyphBlocks,
+	vector<GlyphInstance>& outInstances)
+{
+	outInstances.resize(glyphBlocks.size());
+	
+	vector<u32> order(glyphBlocks.size());
+	for (u32 i = 0; i < order.size(); ++i) order[i] = i;
+	
+	stable_sort(
+		order.begin(),
+		order.end(),
+		[&glyphBlocks](u32 a, u32 b)
+		{
+			return glyphBlocks[a].height > glyphBlocks[b].height;
+		});
+	
+	u32 page{};
+	u32 shelfX = KFD_ATLAS_PADDING;
+	u32 shelfY = KFD_ATLAS_PADDING;
+	u32 shelfHeight{};
+	
+	for (u32 i : order)
+	{
+		const GlyphBlock& g = glyphBlocks[i];
+		
+		u32 width = g.width + KFD_ATLAS_PADDING;
+		u32 height = g.height + KFD_ATLAS_PADDING;
+		
+		if (width + KFD_ATLAS_PADDING > KFD_ATLAS_PAGE_SIZE
+			|| height + KFD_ATLAS_PADDING > KFD_ATLAS_PAGE_SIZE)
+		{
+			return false;
+		}
+		
+		//next shelf, then next page
+		
+		if (shelfX + width > KFD_ATLAS_PAGE_SIZE)
+		{
+			shelfX = KFD_ATLAS_PADDING;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (shelfY + height > KFD_ATLAS_PAGE_SIZE)
+		{
+			++page;
+			shelfX = KFD_ATLAS_PADDING;
+			shelfY = KFD_ATLAS_PADDING;
+			shelfHeight = 0;
+		}
+		
+		outInstances[i] = GlyphInstance
+		{
+			.offsetX = g.bearingX,
+			.offsetY = g.bearingY,
+			.width = g.width,
+			.height = g.height,
+			.atlasX = static_cast<u16>(shelfX),
+			.atlasY = static_cast<u16>(shelfY),
+			.atlasPage = static_cast<u16>(page),
+			.advance = g.advance
+		};
+		
+		shelfX += width;
+		if (height > shelfHeight) shelfHeight = height;
+	}
+	
+	return true;
+}
+
 namespace KalaFont
 {
-	void Export::ExportBitmap(
+	bool Export::ExportBitmap(
 		const path& targetPath,
 		u8 type,
 		u8 glyphHeight,
 		u8 superSampleMultiplier,
-		vector<GlyphBlock>& glyphBlocks)
+		const vector<GlyphBlock>& glyphBlocks)
 	{
+		KALA_TRACE_ZONE("ExportBitmap");
+		ALLOC_ZONE(exportAlloc, ALLOC_EXPORT);
+		
 		if (glyphBlocks.size() > MAX_GLYPH_COUNT)
 		{
 			PrintError(
 				"Failed to export because glyph count exceeded max allowed count '" + to_string(MAX_GLYPH_COUNT) + "'!",
 				true);
 		
-			return;
+			return false;
 		}
 		
 		if (CORRECT_GLYPH_TABLE_SIZE * glyphBlocks.size() > MAX_GLYPH_TABLE_SIZE)
@@ -71,7 +158,7 @@ namespace KalaFont
 				"Failed to export because glyph data size exceeded max allowed size '" + to_string(MAX_GLYPH_TABLE_SIZE) + "'!",
 				true);
 		
-			return;
+			return false;
 		}
 		
 		Log::Print(
@@ -83,15 +170,18 @@ namespace KalaFont
 			"Finished exporting bitmap!",
 			"EXPORT_BITMAP",
 			LogType::LOG_SUCCESS);
+		
+		return true;
 	}
 	
-	void Export::ExportGlyph(
-		const path& targetPath,
+	bool Export::SerializeGlyph(
 		u8 type,
 		u8 glyphHeight,
-		u8 superSampleMultiplier,
-		vector<GlyphBlock>& glyphBlocks)
+		const vector<GlyphBlock>& glyphBlocks,
+		vector<u8>& outData)
 	{
+		KALA_TRACE_ZONE("SerializeGlyph");
+		
 		if (glyphBlocks.size() > MAX_GLYPH_COUNT)
 		{
 			Log::Print(
@@ -100,7 +190,7 @@ namespace KalaFont
 				LogType::LOG_ERROR,
 				2);
 		
-			return;
+			return false;
 		}
 		
 		if (CORRECT_GLYPH_TABLE_SIZE * glyphBlocks.size() > MAX_GLYPH_TABLE_SIZE)
@@ -109,18 +199,30 @@ namespace KalaFont
 				"Failed to export because glyph data size exceeded max allowed size '" + to_string(MAX_GLYPH_TABLE_SIZE) + "'!",
 				false);
 		
-			return;
+			return false;
 		}
 		
-		Log::Print(
-			"Starting to export glyphs to path '" + targetPath.string() + "'.",
-			"EXPORT_GLYPH",
-			LogType::LOG_DEBUG);
+		PROFILE_ZONE(serializeZone, PHASE_SERIALIZE);
 			
-		vector<u8> output{};
+		vector<u8>& output = outData;
+		output.clear();
+		
 		vector<u8> glyphTableOutput{};
 		vector<u8> glyphBlockOutput{};
 		
+		//instance type stores atlas placements in place of the vertices
+		
+		vector<GlyphInstance> instances{};
+		if (type == 3
+			&& !PlaceInAtlas(glyphBlocks, instances))
+		{
+			PrintError(
+				"Failed to export because a glyph did not fit into an atlas page of '" + to_string(KFD_ATLAS_PAGE_SIZE) + "' texels!",
+				false);
+			
+			return false;
+		}
+		
 		//
 		// FIRST STORE THE TOP HEADER
 		//
@@ -193,8 +295,10 @@ namespace KalaFont
 		
 		u32 gOffset{};
 		
-		for (const auto& g : glyphBlocks)
+		for (size_t glyphIndex = 0; glyphIndex < glyphBlocks.size(); ++glyphIndex)
 		{
+			const GlyphBlock& g = glyphBlocks[glyphIndex];
+			
 			WriteU32(glyphBlockOutput, gOffset, g.charCode); gOffset += 4;
 			WriteU16(glyphBlockOutput, gOffset, g.width);    gOffset += 2;
 			WriteU16(glyphBlockOutput, gOffset, g.height);   gOffset += 2;
@@ -202,7 +306,7 @@ namespace KalaFont
 			WriteI16(glyphBlockOutput, gOffset, g.bearingY); gOffset += 2;
 			WriteU16(glyphBlockOutput, gOffset, g.advance);  gOffset += 2;
 			
-			//vertices
+			//vertices, or the instance record for instance type
 			
 			auto CreateVertices = [&]() -> vector<i16>
 				{
@@ -220,7 +324,24 @@ namespace KalaFont
 					};
 				};
 				
-			vector<i16> vertices = CreateVertices();
+			vector<i16> vertices{};
+			if (type == 3)
+			{
+				const GlyphInstance& inst = instances[glyphIndex];
+				
+				vertices =
+				{
+					inst.offsetX,
+					inst.offsetY,
+					static_cast<i16>(inst.width),
+					static_cast<i16>(inst.height),
+					static_cast<i16>(inst.atlasX),
+					static_cast<i16>(inst.atlasY),
+					static_cast<i16>(inst.atlasPage),
+					static_cast<i16>(inst.advance)
+				};
+			}
+			else vertices = CreateVertices();
 				
 			WriteI16(glyphBlockOutput, gOffset, vertices[0]); gOffset += 2;
 			WriteI16(glyphBlockOutput, gOffset, vertices[1]); gOffset += 2;
@@ -252,6 +373,38 @@ namespace KalaFont
 		
 		output.insert(output.end(), glyphTableOutput.begin(), glyphTableOutput.end());
 		output.insert(output.end(), glyphBlockOutput.begin(), glyphBlockOutput.end());
+		
+		PROFILE_STOP(serializeZone);
+		
+		return true;
+	}
+	
+	bool Export::ExportGlyph(
+		const path& targetPath,
+		u8 type,
+		u8 glyphHeight,
+		u8 superSampleMultiplier,
+		const vector<GlyphBlock>& glyphBlocks)
+	{
+		KALA_TRACE_ZONE("ExportGlyph");
+		ALLOC_ZONE(exportAlloc, ALLOC_EXPORT);
+		
+		Log::Print(
+			"Starting to export glyphs to path '" + targetPath.string() + "'.",
+			"EXPORT_GLYPH",
+			LogType::LOG_DEBUG);
+		
+		vector<u8> output{};
+		if (!SerializeGlyph(
+			type,
+			glyphHeight,
+			glyphBlocks,
+			output))
+		{
+			return false;
+		}
+		
+		PROFILE_ZONE(writeZone, PHASE_FILE_WRITE);
 			
 		ofstream file(
 			targetPath,
@@ -262,9 +415,20 @@ namespace KalaFont
 			
 		file.close();
 			
+		if (file.fail())
+		{
+			PrintError(
+				"Failed to export because target path '" + targetPath.string() + "' could not be written!",
+				false);
+			
+			return false;
+		}
+		
 		Log::Print(
 			"Finished exporting glyphs!",
 			"EXPORT_GLYPH",
 			LogType::LOG_SUCCESS);
+		
+		return true;
 	}
 }
\ No newline at end of file
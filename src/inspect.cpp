@@ -0,0 +1,647 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/trace_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "inspect.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::WorkPool;
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::GlyphTable;
+using KalaHeaders::KalaFontData::GlyphBlock;
+using KalaHeaders::KalaFontData::ImportResult;
+using KalaHeaders::KalaFontData::ImportKFD;
+using KalaHeaders::KalaFontData::ResultToString;
+using KalaHeaders::KalaFontData::GetRowStride;
+using KalaHeaders::KalaFontData::CORRECT_GLYPH_HEADER_SIZE;
+using KalaHeaders::KalaFontData::CORRECT_GLYPH_TABLE_SIZE;
+using KalaHeaders::KalaFontData::RAW_PIXEL_DATA_OFFSET;
+
+using KalaCLI::Core;
+
+using KalaFont::Inspect;
+using KalaFont::InspectStats;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ostringstream;
+using std::fixed;
+using std::setw;
+using std::setprecision;
+using std::left;
+using std::right;
+using std::sort;
+using std::min;
+using std::max;
+using std::unordered_map;
+using std::memcmp;
+using std::log2;
+using std::ceil;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::is_directory;
+using std::filesystem::is_regular_file;
+using std::filesystem::file_size;
+using std::filesystem::recursive_directory_iterator;
+using std::filesystem::directory_options;
+using std::error_code;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Upper payload size of each bucket of the payload size distribution, the last bucket has no limit
+constexpr u32 PAYLOAD_BUCKET_LIMITS[] = { 0, 64, 256, 1024, 4096 };
+constexpr size_t PAYLOAD_BUCKET_COUNT = sizeof(PAYLOAD_BUCKET_LIMITS) / sizeof(u32) + 1;
+
+//Upper coverage value of each bucket of the coverage histogram
+constexpr u32 COVERAGE_BUCKET_LIMITS[] = { 0, 63, 127, 191, 254, 255 };
+
+//Longest run one (count, value) pair of the run length estimate holds
+constexpr u32 MAX_RUN_LENGTH = 255;
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"INSPECT",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static string TypeName(u8 type)
+{
+	switch (type)
+	{
+	case 1: return "bitmap";
+	case 2: return "glyph";
+	case 3: return "instance";
+	default: return "unknown";
+	}
+}
+
+static f64 Percent(
+	f64 part,
+	f64 whole)
+{
+	return whole > 0.0 ? part * 100.0 / whole : 0.0;
+}
+
+static u64 Hash(
+	const GlyphBlock& glyph)
+{
+	//fnv-1a over the size and pixels
+	
+	u64 hash = 14695981039346656037ull;
+	auto Mix = [&hash](u64 value)
+		{
+			hash ^= value;
+			hash *= 1099511628211ull;
+		};
+	
+	Mix(glyph.width);
+	Mix(glyph.height);
+	for (u8 pixel : glyph.rawPixels) Mix(pixel);
+	
+	return hash;
+}
+
+//Bytes of a payload when each run of the same value is stored as a (count, value) pair
+static u64 RunLengthSize(const vector<u8>& pixels)
+{
+	u64 bytes{};
+	
+	for (size_t i = 0; i < pixels.size();)
+	{
+		size_t run = 1;
+		while (i + run < pixels.size()
+			&& run < MAX_RUN_LENGTH
+			&& pixels[i + run] == pixels[i])
+		{
+			++run;
+		}
+		
+		bytes += 2;
+		i += run;
+	}
+	
+	return bytes;
+}
+
+//Counts row padding and the fully transparent border around the covered pixels of one glyph
+static void MeasureRows(
+	const GlyphBlock& glyph,
+	InspectStats& stats)
+{
+	u32 stride = GetRowStride(glyph);
+	if (stride == 0) return;
+	
+	stats.rowPaddingBytes += static_cast<u64>(stride - glyph.width) * glyph.height;
+	
+	u32 minX = glyph.width;
+	u32 maxX{};
+	u32 minY = glyph.height;
+	u32 maxY{};
+	
+	for (u32 y = 0; y < glyph.height; ++y)
+	{
+		const u8* row = glyph.rawPixels.data() + static_cast<size_t>(y) * stride;
+		
+		for (u32 x = 0; x < glyph.width; ++x)
+		{
+			if (row[x] == 0) continue;
+			
+			minX = min(minX, x);
+			maxX = max(maxX, x + 1);
+			minY = min(minY, y);
+			maxY = max(maxY, y + 1);
+		}
+	}
+	
+	//blank glyphs are counted on their own
+	if (minX >= maxX) return;
+	
+	stats.borderBytes +=
+		static_cast<u64>(glyph.width) * glyph.height
+		- static_cast<u64>(maxX - minX) * (maxY - minY);
+}
+
+static void AddStats(
+	InspectStats& total,
+	const InspectStats& s)
+{
+	total.glyphCount += s.glyphCount;
+	
+	total.fileBytes += s.fileBytes;
+	total.headerBytes += s.headerBytes;
+	total.tableBytes += s.tableBytes;
+	total.infoBytes += s.infoBytes;
+	total.payloadBytes += s.payloadBytes;
+	total.paddingBytes += s.paddingBytes;
+	
+	total.blankCount += s.blankCount;
+	total.emptyCount += s.emptyCount;
+	total.blankBytes += s.blankBytes;
+	total.duplicateCount += s.duplicateCount;
+	total.duplicateBytes += s.duplicateBytes;
+	total.borderBytes += s.borderBytes;
+	total.rowPaddingBytes += s.rowPaddingBytes;
+	
+	total.payloadSizes.insert(total.payloadSizes.end(), s.payloadSizes.begin(), s.payloadSizes.end());
+	for (size_t i = 0; i < s.coverage.size(); ++i) total.coverage[i] += s.coverage[i];
+	
+	total.quantized4Bytes += s.quantized4Bytes;
+	total.quantized2Bytes += s.quantized2Bytes;
+	total.quantized1Bytes += s.quantized1Bytes;
+	total.runLengthBytes += s.runLengthBytes;
+	total.entropyBytes += s.entropyBytes;
+}
+
+//File size with the payload swapped for an estimated payload, everything else stays as is
+static u64 WithPayload(
+	const InspectStats& s,
+	f64 payloadBytes)
+{
+	return s.fileBytes - s.payloadBytes + static_cast<u64>(ceil(payloadBytes));
+}
+
+//File size without padding, blank glyph pixels and the empty borders and row padding of the other glyphs
+static u64 TrimmedSize(const InspectStats& s)
+{
+	return s.fileBytes - s.paddingBytes - s.blankBytes - s.borderBytes - s.rowPaddingBytes;
+}
+
+static string Breakdown(
+	const string& title,
+	const InspectStats& s)
+{
+	ostringstream out{};
+	out << fixed << setprecision(1);
+	
+	f64 file = static_cast<f64>(s.fileBytes);
+	
+	out << title << "\n"
+		<< "  " << left << setw(18) << "section" << right << setw(12) << "bytes" << setw(9) << "%";
+	
+	auto Row = [&](const char* name, u64 bytes)
+		{
+			out << "\n  " << left << setw(18) << name << right
+				<< setw(12) << bytes
+				<< setw(8) << Percent(static_cast<f64>(bytes), file) << "%";
+		};
+	
+	Row("file", s.fileBytes);
+	Row("header", s.headerBytes);
+	Row("glyph table", s.tableBytes);
+	Row("block info", s.infoBytes);
+	Row("payload", s.payloadBytes);
+	Row("padding", s.paddingBytes);
+	
+	//payload distribution
+	
+	vector<u32> sizes = s.payloadSizes;
+	sort(sizes.begin(), sizes.end());
+	
+	auto At = [&sizes](f64 fraction) -> u32
+		{
+			if (sizes.empty()) return 0;
+			return sizes[min(sizes.size() - 1, static_cast<size_t>(fraction * static_cast<f64>(sizes.size())))];
+		};
+	
+	u64 buckets[PAYLOAD_BUCKET_COUNT]{};
+	for (u32 size : sizes)
+	{
+		size_t b{};
+		while (b < PAYLOAD_BUCKET_COUNT - 1
+			&& size > PAYLOAD_BUCKET_LIMITS[b])
+		{
+			++b;
+		}
+		++buckets[b];
+	}
+	
+	out << "\n  payload per glyph: min " << At(0.0) << ", median " << At(0.5)
+		<< ", p90 " << At(0.9) << ", max " << (sizes.empty() ? 0 : sizes.back()) << " bytes\n   ";
+	
+	for (size_t b = 0; b < PAYLOAD_BUCKET_COUNT; ++b)
+	{
+		if (b == 0) out << " 0 B: ";
+		else if (b == PAYLOAD_BUCKET_COUNT - 1) out << ", >" << PAYLOAD_BUCKET_LIMITS[b - 1] << " B: ";
+		else out << ", " << (PAYLOAD_BUCKET_LIMITS[b - 1] + 1) << "-" << PAYLOAD_BUCKET_LIMITS[b] << " B: ";
+		
+		out << buckets[b];
+	}
+	
+	//wasted payload
+	
+	f64 payload = static_cast<f64>(s.payloadBytes);
+	
+	out << "\n  blank glyphs: " << s.blankCount << " (" << s.emptyCount << " without pixels), "
+		<< s.blankBytes << " bytes, " << Percent(static_cast<f64>(s.blankBytes), payload) << "% of payload"
+		<< "\n  duplicate payloads: " << s.duplicateCount << " glyphs, "
+		<< s.duplicateBytes << " bytes, " << Percent(static_cast<f64>(s.duplicateBytes), payload) << "% of payload"
+		<< "\n  empty borders: " << s.borderBytes << " bytes, "
+		<< Percent(static_cast<f64>(s.borderBytes), payload) << "% of payload"
+		<< "\n  row padding: " << s.rowPaddingBytes << " bytes, "
+		<< Percent(static_cast<f64>(s.rowPaddingBytes), payload) << "% of payload";
+	
+	//coverage histogram
+	
+	u64 pixels{};
+	u32 distinct{};
+	for (u64 count : s.coverage)
+	{
+		pixels += count;
+		distinct += count > 0 ? 1 : 0;
+	}
+	
+	out << "\n  coverage (" << distinct << " distinct values):";
+	
+	u32 low{};
+	for (u32 limit : COVERAGE_BUCKET_LIMITS)
+	{
+		u64 count{};
+		for (u32 v = low; v <= limit; ++v) count += s.coverage[v];
+		
+		out << " ";
+		if (low == limit) out << limit;
+		else out << low << "-" << limit;
+		out << ": " << Percent(static_cast<f64>(count), static_cast<f64>(pixels)) << "%";
+		
+		low = limit + 1;
+	}
+	
+	//estimates
+	
+	out << "\n  estimated file size:";
+	
+	auto Estimate = [&](const char* name, u64 bytes)
+		{
+			out << "\n    " << left << setw(24) << name << right
+				<< setw(12) << bytes
+				<< setw(8) << Percent(static_cast<f64>(bytes), file) << "%";
+		};
+	
+	Estimate("as is", s.fileBytes);
+	Estimate("4-bit coverage", WithPayload(s, static_cast<f64>(s.quantized4Bytes)));
+	Estimate("2-bit coverage", WithPayload(s, static_cast<f64>(s.quantized2Bytes)));
+	Estimate("1-bit coverage", WithPayload(s, static_cast<f64>(s.quantized1Bytes)));
+	Estimate("run length", WithPayload(s, static_cast<f64>(s.runLengthBytes)));
+	Estimate("entropy coded", WithPayload(s, s.entropyBytes));
+	Estimate("shared duplicates", s.fileBytes - s.duplicateBytes);
+	Estimate("trimmed borders", TrimmedSize(s));
+	
+	return out.str();
+}
+
+namespace KalaFont
+{
+	void Inspect::Command_Inspect(const vector<string>& params)
+	{
+		KALA_TRACE_ZONE("Inspect");
+		
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		path target = weakly_canonical(path(currentDir) / params[1]);
+		
+		vector<path> files{};
+		
+		if (is_directory(target))
+		{
+			error_code ec{};
+			for (recursive_directory_iterator it(target, directory_options::skip_permission_denied, ec), end{};
+				it != end;
+				it.increment(ec))
+			{
+				if (ec) break;
+				
+				if (it->is_regular_file(ec)
+					&& it->path().extension() == ".kfd")
+				{
+					files.push_back(it->path());
+				}
+			}
+			
+			sort(files.begin(), files.end());
+		}
+		else if (is_regular_file(target)) files.push_back(target);
+		
+		if (files.empty())
+		{
+			PrintError("Failed to inspect '" + target.string() + "' because it is not a .kfd file or a folder with .kfd files!");
+			
+			return;
+		}
+		
+		//every file is read and measured on its own, the summary is built afterwards in file order
+		
+		vector<InspectStats> stats(files.size());
+		
+		WorkPool pool{};
+		pool.ParallelFor(
+			files.size(),
+			1,
+			[&files, &stats](size_t begin, size_t end, u32)
+			{
+				for (size_t i = begin; i < end; ++i) stats[i] = InspectFile(files[i]);
+			});
+		
+		InspectStats total{};
+		u32 inspectedCount{};
+		
+		ostringstream failed{};
+		
+		for (const auto& s : stats)
+		{
+			if (s.result != ImportResult::RESULT_SUCCESS)
+			{
+				failed << "\n    " << s.file.string() << ": " << ResultToString(s.result);
+				continue;
+			}
+			
+			AddStats(total, s);
+			++inspectedCount;
+		}
+		
+		if (inspectedCount == 1
+			&& files.size() == 1)
+		{
+			const InspectStats& s = stats.front();
+			
+			Log::Print(
+				Breakdown(
+					"Inspected '" + s.file.string() + "' (" + TypeName(s.type) + ", height "
+					+ to_string(s.glyphHeight) + ", " + to_string(s.glyphCount) + " glyphs)",
+					s),
+				"INSPECT",
+				LogType::LOG_INFO);
+			
+			return;
+		}
+		
+		if (inspectedCount > 0)
+		{
+			//one row per file so each font can get its own size options
+			
+			ostringstream rows{};
+			rows << fixed << setprecision(1)
+				<< "Inspected " << inspectedCount << " of " << files.size() << " files in '" << target.string()
+				<< "' on " << pool.GetThreadCount() << " threads, estimates are % of the file size\n"
+				<< "  " << right << setw(9) << "type" << setw(8) << "glyphs" << setw(10) << "bytes"
+				<< setw(8) << "blank" << setw(8) << "dupes" << setw(8) << "4-bit" << setw(8) << "2-bit"
+				<< setw(8) << "1-bit" << setw(8) << "rle" << setw(8) << "coded" << setw(8) << "trim"
+				<< "  file";
+			
+			for (const auto& s : stats)
+			{
+				if (s.result != ImportResult::RESULT_SUCCESS) continue;
+				
+				f64 file = static_cast<f64>(s.fileBytes);
+				
+				rows << "\n  " << setw(9) << TypeName(s.type) << setw(8) << s.glyphCount << setw(10) << s.fileBytes
+					<< setw(8) << s.blankCount << setw(8) << s.duplicateCount
+					<< setw(8) << Percent(static_cast<f64>(WithPayload(s, static_cast<f64>(s.quantized4Bytes))), file)
+					<< setw(8) << Percent(static_cast<f64>(WithPayload(s, static_cast<f64>(s.quantized2Bytes))), file)
+					<< setw(8) << Percent(static_cast<f64>(WithPayload(s, static_cast<f64>(s.quantized1Bytes))), file)
+					<< setw(8) << Percent(static_cast<f64>(WithPayload(s, static_cast<f64>(s.runLengthBytes))), file)
+					<< setw(8) << Percent(static_cast<f64>(WithPayload(s, s.entropyBytes)), file)
+					<< setw(8) << Percent(static_cast<f64>(TrimmedSize(s)), file)
+					<< "  " << s.file.lexically_relative(is_directory(target) ? target : target.parent_path()).string();
+			}
+			
+			Log::Print(
+				rows.str(),
+				"INSPECT",
+				LogType::LOG_INFO);
+			
+			Log::Print(
+				Breakdown("All inspected files (" + to_string(total.glyphCount) + " glyphs)", total),
+				"INSPECT",
+				LogType::LOG_INFO);
+		}
+		
+		if (inspectedCount < files.size())
+		{
+			PrintError(
+				"Failed to inspect " + to_string(files.size() - inspectedCount) + " of "
+				+ to_string(files.size()) + " files:" + failed.str());
+		}
+	}
+	
+	InspectStats Inspect::InspectFile(const path& file)
+	{
+		KALA_TRACE_ZONE("InspectFile");
+		
+		InspectStats stats{ .file = file };
+		
+		GlyphHeader header{};
+		vector<GlyphTable> tables{};
+		vector<GlyphBlock> blocks{};
+		
+		stats.result = ImportKFD(
+			file,
+			header,
+			tables,
+			blocks);
+		
+		if (stats.result != ImportResult::RESULT_SUCCESS) return stats;
+		
+		error_code ec{};
+		stats.fileBytes = file_size(file, ec);
+		if (ec)
+		{
+			stats.result = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			return stats;
+		}
+		
+		stats.type = header.type;
+		stats.glyphHeight = header.glyphHeight;
+		stats.glyphCount = static_cast<u32>(blocks.size());
+		
+		stats.headerBytes = CORRECT_GLYPH_HEADER_SIZE;
+		stats.tableBytes = header.glyphTableSize;
+		stats.infoBytes = static_cast<u64>(blocks.size()) * RAW_PIXEL_DATA_OFFSET;
+		
+		//
+		// PADDING
+		//
+		
+		//block region bytes that no table entry covers, block sizes past their pixels,
+		//table bytes past the last whole entry and bytes after the block region
+		
+		u64 regionStart = CORRECT_GLYPH_HEADER_SIZE + header.glyphTableSize;
+		u64 regionEnd = regionStart + header.glyphBlockSize;
+		
+		vector<GlyphTable> byOffset = tables;
+		sort(
+			byOffset.begin(),
+			byOffset.end(),
+			[](const GlyphTable& a, const GlyphTable& b) { return a.blockOffset < b.blockOffset; });
+		
+		u64 covered{};
+		u64 coveredEnd = regionStart;
+		for (const auto& t : byOffset)
+		{
+			u64 blockEnd = static_cast<u64>(t.blockOffset) + t.blockSize;
+			if (blockEnd > coveredEnd)
+			{
+				covered += blockEnd - max<u64>(coveredEnd, t.blockOffset);
+				coveredEnd = blockEnd;
+			}
+		}
+		
+		stats.paddingBytes += header.glyphBlockSize - min<u64>(covered, header.glyphBlockSize);
+		stats.paddingBytes += header.glyphTableSize % CORRECT_GLYPH_TABLE_SIZE;
+		if (stats.fileBytes > regionEnd) stats.paddingBytes += stats.fileBytes - regionEnd;
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			u64 used = static_cast<u64>(RAW_PIXEL_DATA_OFFSET) + blocks[i].rawPixelSize;
+			if (tables[i].blockSize > used) stats.paddingBytes += tables[i].blockSize - used;
+		}
+		
+		//
+		// PAYLOAD
+		//
+		
+		stats.payloadSizes.reserve(blocks.size());
+		
+		//hash of size and pixels to the first glyph that has them
+		unordered_map<u64, vector<size_t>> firstByHash{};
+		
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const GlyphBlock& g = blocks[i];
+			
+			stats.payloadBytes += g.rawPixelSize;
+			stats.payloadSizes.push_back(g.rawPixelSize);
+			
+			bool isBlank = true;
+			for (u8 pixel : g.rawPixels)
+			{
+				++stats.coverage[pixel];
+				if (pixel != 0) isBlank = false;
+			}
+			
+			u64 pixelBits = static_cast<u64>(g.rawPixelSize);
+			stats.quantized4Bytes += (pixelBits * 4 + 7) / 8;
+			stats.quantized2Bytes += (pixelBits * 2 + 7) / 8;
+			stats.quantized1Bytes += (pixelBits + 7) / 8;
+			stats.runLengthBytes += RunLengthSize(g.rawPixels);
+			
+			if (isBlank)
+			{
+				++stats.blankCount;
+				stats.blankBytes += g.rawPixelSize;
+				if (g.rawPixelSize == 0) ++stats.emptyCount;
+				
+				continue;
+			}
+			
+			MeasureRows(g, stats);
+			
+			//hashes can collide, so the pixels are compared before counting a duplicate
+			
+			vector<size_t>& matches = firstByHash[Hash(g)];
+			
+			bool isDuplicate{};
+			for (size_t m : matches)
+			{
+				const GlyphBlock& other = blocks[m];
+				if (other.width == g.width
+					&& other.height == g.height
+					&& other.rawPixels.size() == g.rawPixels.size()
+					&& memcmp(other.rawPixels.data(), g.rawPixels.data(), g.rawPixels.size()) == 0)
+				{
+					isDuplicate = true;
+					break;
+				}
+			}
+			
+			if (isDuplicate)
+			{
+				++stats.duplicateCount;
+				stats.duplicateBytes += g.rawPixelSize;
+			}
+			else matches.push_back(i);
+		}
+		
+		//order 0 entropy over every pixel of the file
+		
+		f64 pixels = static_cast<f64>(stats.payloadBytes);
+		f64 bits{};
+		for (u64 count : stats.coverage)
+		{
+			if (count == 0) continue;
+			
+			f64 c = static_cast<f64>(count);
+			bits += c * log2(pixels / c);
+		}
+		stats.entropyBytes = bits / 8.0;
+		
+		return stats;
+	}
+}
\ No newline at end of file
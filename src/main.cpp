@@ -9,12 +9,24 @@
 #include "KalaCLI/include/command.hpp"
 
 #include "parse.hpp"
+#include "batch.hpp"
+#include "serve.hpp"
+#include "watch.hpp"
+#include "profile.hpp"
+#include "report.hpp"
+#include "inspect.hpp"
 
 using KalaCLI::Core;
 using KalaCLI::Command;
 using KalaCLI::CommandManager;
 
 using KalaFont::Parse;
+using KalaFont::Batch;
+using KalaFont::Serve;
+using KalaFont::Watch;
+using KalaFont::Profile;
+using KalaFont::GlyphReport;
+using KalaFont::Inspect;
 
 using std::ostringstream;
 
@@ -23,20 +35,90 @@ static void AddExternalCommands()
 	ostringstream msgParse{};
 	
 	msgParse << "Compiles ttf and otf fonts to ktf for runtime use with the help of FreeType.\n"
-		<< "    Second parameter must be compile type (bitmap or glyph)\n"
+		<< "    Second parameter must be compile type (bitmap, glyph or instance - glyph with atlas placed instance records),\n"
+		<< "        glyph and instance take an optional subpixel phase count suffix (glyph:2, glyph:3 or glyph:4)\n"
 		<< "    Third parameter must be glyph height - how tall each glyph will be, their width is adjusted according to height\n"
 		<< "    Fourth parameter must be compression quality (1 to 3, higher is better quality but bigger size)\n"
 		<< "    Fifth parameter must be origin font path (.ttf or .otf)\n"
-		<< "    Sixth parameter must be target path (.ktf)";
+		<< "    Sixth parameter must be target path (.ktf)\n"
+		<< "    Unchanged fonts are restored from the build cache, set KALAFONT_CACHE_DIR to move it or to 'off',\n"
+		<< "        KALAFONT_CACHE_MAX_MB to change its size limit (512 MB by default)\n"
+		<< "        and KALAFONT_CACHE_HARDLINK to 1 to restore outputs as hardlinks to the cache instead of copies";
 	
 	ostringstream msgVerboseParse{};
 	
 	msgVerboseParse << "Compiles ttf and otf fonts to ktf for runtime use with the help of FreeType with additional verbose logging.\n"
-		<< "    Second parameter must be compile type (bitmap or glyph)\n"
+		<< "    Second parameter must be compile type (bitmap, glyph or instance - glyph with atlas placed instance records),\n"
+		<< "        glyph and instance take an optional subpixel phase count suffix (glyph:2, glyph:3 or glyph:4)\n"
 		<< "    Third parameter must be glyph height - how tall each glyph will be, their width is adjusted according to height\n"
 		<< "    Fourth parameter must be compression quality (1 to 3, higher is better quality but bigger size)\n"
 		<< "    Fifth parameter must be origin font path (.ttf or .otf)\n"
-		<< "    Sixth parameter must be target path (.ktf)";
+		<< "    Sixth parameter must be target path (.ktf)\n"
+		<< "    Metrics of every glyph are written as a glyph report on a background thread, see --report for its format\n"
+		<< "    Builds with KALAFONT_TRACK_ALLOCATIONS also print allocations, bytes and peak memory of every compile phase";
+	
+	ostringstream msgBatch{};
+	
+	msgBatch << "Compiles every font listed in a manifest in one process on a shared thread pool and prints one summary.\n"
+		<< "    Second parameter must be the manifest path\n"
+		<< "        each manifest line is 'type height quality origin target' like the parse parameters,\n"
+		<< "        type, height and quality can be comma separated lists that are compiled in every combination,\n"
+		<< "        target can use {type}, {height} and {quality}, paths are relative to the manifest,\n"
+		<< "        paths with spaces go in double quotes and '#' starts a comment\n"
+		<< "    Unchanged fonts are restored from the build cache like with parse";
+	
+	ostringstream msgServe{};
+	
+	msgServe << "Keeps FreeType, faces and rendered glyphs warm and compiles requests until a client sends stop.\n"
+		<< "    Second parameter must be a unix domain socket path, or stdio to take requests from stdin\n"
+		<< "        and answer on stdout while logs move to stderr\n"
+		<< "    Every frame is a u32 little endian payload size followed by the payload\n"
+		<< "        request:  u32 id, then type, height, quality, origin and target separated by '\\0',\n"
+		<< "                  an empty target returns the kfd bytes, type 'stop' stops the server\n"
+		<< "        response: u32 id, u8 status (0 = compiled, 1 = failed), u32 glyph count,\n"
+		<< "                  then the kfd bytes, nothing for a written target or the error message\n"
+		<< "    Targets are replaced in one rename, KALAFONT_SERVE_CACHE_MB limits the rendered glyphs kept in memory";
+	
+	ostringstream msgWatch{};
+	
+	msgWatch << "Compiles every font of a manifest and recompiles the outputs of changed fonts and manifest lines until stopped.\n"
+		<< "    Second parameter must be the manifest path, the manifest is the same as with batch\n"
+		<< "    Changes are collected until the files are quiet for a moment and then compiled on a shared thread pool,\n"
+		<< "        outputs are replaced in one rename so running programs can hot reload them\n"
+		<< "    Uses inotify on Linux and polling elsewhere, fonts stay warm like with serve";
+	
+	ostringstream msgProfile{};
+	
+	msgProfile << "Times every compile phase of the parse, vp and batch commands stacked after it, for example\n"
+		<< "        '--profile report.json & --parse glyph 32 2 font.ttf font.kfd'\n"
+		<< "    Second parameter must be the json report path (.json)\n"
+		<< "    Each profiled command prints a phase table with glyphs/s and bytes/s and adds a run to the report,\n"
+		<< "        builds without KALAFONT_PROFILE compile the timings out";
+	
+	ostringstream msgReport{};
+	
+	msgReport << "Sets the format and target of the vp glyph report for the vp commands stacked after it, for example\n"
+		<< "        '--report glyphs.csv & --vp glyph 32 2 font.ttf font.kfd'\n"
+		<< "    Second parameter must be text, csv or jsonl to write to the console,\n"
+		<< "        or a .txt, .csv or .jsonl path to write to that file\n"
+		<< "    Without it vp writes compact text to the console";
+	
+	ostringstream msgInspect{};
+	
+	msgInspect << "Reports where the bytes of kfd files go and how big they would be with each size option.\n"
+		<< "    Second parameter must be a .kfd path, or a folder whose .kfd files are all inspected on a shared thread pool\n"
+		<< "    Prints header, table, block info, payload and padding bytes, the payload size distribution,\n"
+		<< "        blank glyphs, duplicate payloads, empty borders and a coverage histogram,\n"
+		<< "        then the estimated size with 4, 2 or 1 bit coverage, run length or entropy coded payloads,\n"
+		<< "        shared duplicate payloads and trimmed borders, folders get one row per file and a total";
+	
+	ostringstream msgTrace{};
+	
+	msgTrace << "Records every compile and import zone of the commands stacked after it on every thread, for example\n"
+		<< "        '--trace trace.json & --batch fonts.txt'\n"
+		<< "    Second parameter must be the trace path (.json)\n"
+		<< "    The trace is written as chrome trace event json when KalaFont exits, open it in Perfetto or chrome://tracing,\n"
+		<< "        builds without KALAFONT_TRACE compile the zones out";
 	
 	Command cmd_parse
 	{
@@ -53,8 +135,65 @@ static void AddExternalCommands()
 		.targetFunction = Parse::Command_VerboseParse
 	};
 
+	Command cmd_batch
+	{
+		.primary = { "batch", "b" },
+		.description = msgBatch.str(),
+		.paramCount = 2,
+		.targetFunction = Batch::Command_Batch
+	};
+	Command cmd_serve
+	{
+		.primary = { "serve" },
+		.description = msgServe.str(),
+		.paramCount = 2,
+		.targetFunction = Serve::Command_Serve
+	};
+	Command cmd_watch
+	{
+		.primary = { "watch", "w" },
+		.description = msgWatch.str(),
+		.paramCount = 2,
+		.targetFunction = Watch::Command_Watch
+	};
+	Command cmd_profile
+	{
+		.primary = { "profile" },
+		.description = msgProfile.str(),
+		.paramCount = 2,
+		.targetFunction = Profile::Command_Profile
+	};
+	Command cmd_report
+	{
+		.primary = { "report" },
+		.description = msgReport.str(),
+		.paramCount = 2,
+		.targetFunction = GlyphReport::Command_Report
+	};
+	Command cmd_inspect
+	{
+		.primary = { "inspect" },
+		.description = msgInspect.str(),
+		.paramCount = 2,
+		.targetFunction = Inspect::Command_Inspect
+	};
+	Command cmd_trace
+	{
+		.primary = { "trace" },
+		.description = msgTrace.str(),
+		.paramCount = 2,
+		.targetFunction = Profile::Command_Trace
+	};
+	
 	CommandManager::AddCommand(cmd_parse);
 	CommandManager::AddCommand(cmd_verboseparse);
+	CommandManager::AddCommand(cmd_batch);
+	CommandManager::AddCommand(cmd_serve);
+	CommandManager::AddCommand(cmd_watch);
+	CommandManager::AddCommand(cmd_profile);
+	CommandManager::AddCommand(cmd_report);
+	CommandManager::AddCommand(cmd_inspect);
+	CommandManager::AddCommand(cmd_trace);
 }
 
 int main(int argc, char* argv[])
@@ -6,31 +6,60 @@
 #include <vector>
 #include <string>
 #include <filesystem>
-#include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <cstdlib>
 
 #include "FreeType/include/ft2build.h"
 #include FT_FREETYPE_H
+#include FT_OUTLINE_H
+#include FT_MODULE_H
 
 #include "KalaHeaders/log_utils.hpp"
 #include "KalaHeaders/string_utils.hpp"
 #include "KalaHeaders/import_kfd.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/trace_utils.hpp"
 
 #include "KalaCLI/include/core.hpp"
 
 #include "parse.hpp"
 #include "export.hpp"
+#include "cache.hpp"
+#include "profile.hpp"
+#include "alloc.hpp"
+#include "report.hpp"
 
 using KalaHeaders::KalaLog::Log;
 using KalaHeaders::KalaLog::LogType;
 using KalaHeaders::KalaString::HasAnyNonNumber;
 using KalaHeaders::KalaString::HasAnyWhiteSpace;
+using KalaHeaders::KalaFontData::GlyphHeader;
+using KalaHeaders::KalaFontData::GlyphTable;
 using KalaHeaders::KalaFontData::GlyphBlock;
+using KalaHeaders::KalaFontData::ImportKFD;
+using KalaHeaders::KalaFontData::ImportResult;
 using KalaHeaders::KalaFontData::MIN_GLYPH_HEIGHT;
 using KalaHeaders::KalaFontData::MAX_GLYPH_HEIGHT;
+using KalaHeaders::KalaFontData::KFD_SUBPIXEL_PHASE_SHIFT;
+using KalaHeaders::KalaFontData::KFD_MAX_SUBPIXEL_PHASES;
+using KalaHeaders::KalaFontData::MAX_GLYPH_COUNT;
+using KalaHeaders::KalaThread::jthread;
 
 using KalaCLI::Core;
 
 using KalaFont::Export;
+using KalaFont::Parse;
+using KalaFont::CompileJob;
+using KalaFont::CompileResult;
+using KalaFont::BuildCache;
+using KalaFont::Alloc;
+using KalaFont::GlyphReport;
 
 using std::vector;
 using std::string;
@@ -41,25 +70,106 @@ using std::filesystem::weakly_canonical;
 using std::filesystem::is_regular_file;
 using std::filesystem::status;
 using std::filesystem::perms;
-using std::ostringstream;
-using std::hex;
-using std::dec;
+using std::filesystem::file_size;
+using std::filesystem::last_write_time;
+using std::filesystem::create_directories;
+using std::filesystem::rename;
+using std::filesystem::remove;
+using std::error_code;
 using std::move;
+using std::thread;
+using std::atomic;
+using std::memory_order_relaxed;
+using std::min;
+using std::max;
+using std::min_element;
+using std::list;
+using std::shared_ptr;
+using std::make_shared;
+using std::unique_ptr;
+using std::make_unique;
+using std::mutex;
+using std::lock_guard;
+using std::random_device;
+using std::getenv;
+using std::strtoull;
 
 using u8 = uint8_t;
 using u16 = uint16_t;
 using u32 = uint32_t;
+using u64 = uint64_t;
 using i16 = int16_t;
 
 constexpr u8 MIN_SUPERSAMPLE = 1;    //multiplier
 constexpr u8 MAX_SUPERSAMPLE = 3;    //multiplier
 
+//Glyphs rendered per worker thread before another worker is started
+constexpr size_t GLYPHS_PER_RENDER_THREAD = 32;
+
+//How many faces each thread keeps open while the resident cache is enabled
+constexpr size_t RESIDENT_FACES_PER_THREAD = 8;
+
+//Rendered glyphs kept in memory when KALAFONT_SERVE_CACHE_MB is not set
+constexpr u64 DEFAULT_RESIDENT_MB = 256;
+
+//One glyph of the face that still needs to be rendered
+struct GlyphSource
+{
+	u32 charCode{};
+	FT_UInt glyphIndex{};
+};
+
+//Face kept open between compiles while the resident cache is enabled
+struct ResidentFace
+{
+	string fontKey{};
+	FT_Face face{};
+	u64 lastUse{};
+};
+
+//FreeType library of one thread and the faces it keeps open
+struct ThreadLibrary
+{
+	FT_Library ft{};
+	vector<ResidentFace> faces{};
+	u64 useClock{};
+	
+	~ThreadLibrary()
+	{
+		//also closes every face of the library
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+		if (ft) FT_Done_Library(ft);
+#else
+		if (ft) FT_Done_FreeType(ft);
+#endif
+	}
+};
+
+//Rendered glyphs of one font at one glyph height and subpixel phase count
+struct ResidentGlyphs
+{
+	string renderKey{};
+	shared_ptr<const vector<GlyphBlock>> glyphs{};
+	u64 bytes{};
+};
+
+//Faces and rendered glyphs are kept between compiles while this is above 0
+static atomic<u64> residentLimit{};
+
+static mutex residentMutex{};
+static list<ResidentGlyphs> residentGlyphs{}; //most recently used first
+static u64 residentBytes{};
+
+static thread_local string lastError{};
+
 static void ParseAny(
 	const vector<string>& params,
 	bool isVerbose);
 	
 static void PrintError(const string& message)
 {
+	lastError = message;
+	
 	Log::Print(
 		message,
 		"FONT",
@@ -67,271 +177,859 @@ static void PrintError(const string& message)
 		2);
 }
 
-namespace KalaFont
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+//FreeType allocations go through the allocation counts like operator new does
+
+static void* AllocFreeType(
+	FT_Memory,
+	long size)
 {
-	void Parse::Command_Parse(const vector<string>& params)
-	{
-		ParseAny(params, false);
-	}
+	return Alloc::Allocate(static_cast<size_t>(size), 0, true);
+}
+
+static void FreeFreeType(
+	FT_Memory,
+	void* block)
+{
+	Alloc::Free(block);
+}
+
+static void* ReallocFreeType(
+	FT_Memory,
+	long,
+	long newSize,
+	void* block)
+{
+	return Alloc::Reallocate(block, static_cast<size_t>(newSize), true);
+}
+
+static FT_MemoryRec_ freeTypeMemory
+{
+	.user = nullptr,
+	.alloc = AllocFreeType,
+	.free = FreeFreeType,
+	.realloc = ReallocFreeType
+};
+#endif
+
+static ThreadLibrary& GetThreadLibrary()
+{
+	static thread_local ThreadLibrary library{};
 	
-	void Parse::Command_VerboseParse(const vector<string>& params)
-	{
-		ParseAny(params, true);
-	}
+	return library;
 }
 
-void ParseAny(
-	const vector<string>& params,
-	bool isVerbose)
+//Returns the FreeType library of the calling thread, it is initialized on first use
+//and kept until the thread exits so threads that compile many fonts only initialize it once
+static FT_Library GetFreeType()
 {
-	FT_Library ft{};
-	if (FT_Init_FreeType(&ft))
+	ThreadLibrary& library = GetThreadLibrary();
+	
+	if (!library.ft)
 	{
-		PrintError("Failed to initialize FreeType!");
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+		//same as FT_Init_FreeType but with the counting allocator
+		if (FT_New_Library(&freeTypeMemory, &library.ft))
+		{
+			library.ft = nullptr;
+			return nullptr;
+		}
 		
-		return;
+		FT_Add_Default_Modules(library.ft);
+		FT_Set_Default_Properties(library.ft);
+#else
+		if (FT_Init_FreeType(&library.ft))
+		{
+			library.ft = nullptr;
+			return nullptr;
+		}
+#endif
+		
+		Log::Print(
+			"Initialized FreeType.",
+			"FONT",
+			LogType::LOG_DEBUG);
 	}
 	
-	Log::Print(
-		"Initialized FreeType.",
-		"FONT",
-		LogType::LOG_DEBUG);
+	return library.ft;
+}
 
-	string& currentDir = Core::GetCurrentDir();
+//Identifies one version of a font file, empty if the file can not be read
+static string GetFontKey(const path& fontPath)
+{
+	error_code ec{};
 	
-	if (currentDir.empty()) currentDir = current_path().string();
-	path correctOrigin = weakly_canonical(path(currentDir) / params[4]);
-	path correctTarget = weakly_canonical(path(currentDir) / params[5]);
+	auto time = last_write_time(fontPath, ec);
+	if (ec) return {};
+	
+	u64 size = file_size(fontPath, ec);
+	if (ec) return {};
+	
+	return fontPath.string()
+		+ "|" + to_string(time.time_since_epoch().count())
+		+ "|" + to_string(size);
+}
+
+//Opens a face of the font on the library of the calling thread. With a font key and the
+//resident cache enabled the face stays open for the next compile of the same font
+static FT_Face OpenFace(
+	const path& fontPath,
+	const string& fontKey)
+{
+	FT_Library ft = GetFreeType();
+	if (!ft) return nullptr;
 	
-	//
-	// VERIFY PARAMS
-	//
+	ThreadLibrary& library = GetThreadLibrary();
 	
-	if (params[1] != "bitmap"
-		&& params[1] != "glyph")
+	bool isResident = !fontKey.empty()
+		&& residentLimit.load(memory_order_relaxed) > 0;
+	
+	if (isResident)
 	{
-		PrintError("Failed to load font '" + correctOrigin.string() + "' because the load action was invalid!");
-		
-		return;
+		for (auto& f : library.faces)
+		{
+			if (f.fontKey != fontKey) continue;
+			
+			f.lastUse = ++library.useClock;
+			return f.face;
+		}
 	}
 	
-	if (HasAnyNonNumber(params[2])
-		|| HasAnyWhiteSpace(params[2]))
+	FT_Face face{};
+	if (FT_New_Face(ft, fontPath.string().c_str(), 0, &face)) return nullptr;
+	
+	if (!isResident) return face;
+	
+	if (library.faces.size() == RESIDENT_FACES_PER_THREAD)
 	{
-		PrintError("Failed to load font '" + correctOrigin.string() + "' because the glyph height was an invalid value!");
+		auto oldest = min_element(
+			library.faces.begin(),
+			library.faces.end(),
+			[](const ResidentFace& a, const ResidentFace& b)
+			{
+				return a.lastUse < b.lastUse;
+			});
 		
-		return;
+		FT_Done_Face(oldest->face);
+		library.faces.erase(oldest);
 	}
-	size_t glyphHeight = stoul(params[2]);
-	if (glyphHeight < MIN_GLYPH_HEIGHT
-		|| glyphHeight > MAX_GLYPH_HEIGHT)
+	
+	library.faces.push_back(ResidentFace
 	{
-		PrintError("Failed to load font '" + correctOrigin.string() + "' because the glyph height was out of allowed range!");
-		
-		return;
-	}
+		.fontKey = fontKey,
+		.face = face,
+		.lastUse = ++library.useClock
+	});
 	
-	if (HasAnyNonNumber(params[3])
-		|| HasAnyWhiteSpace(params[3]))
+	return face;
+}
+
+//Closes a face from OpenFace unless the library of the calling thread keeps it open
+static void CloseFace(FT_Face face)
+{
+	for (const auto& f : GetThreadLibrary().faces)
 	{
-		PrintError("Failed to load font '" + correctOrigin.string() + "' because the supersample multiplier was an invalid value!");
-		
-		return;
+		if (f.face == face) return;
 	}
-	size_t supersampleMultiplier = stoul(params[3]);
-	if (supersampleMultiplier < MIN_SUPERSAMPLE
-		|| supersampleMultiplier > MAX_SUPERSAMPLE)
+	
+	FT_Done_Face(face);
+}
+
+//Returns the resident glyphs of a render key and marks them as most recently used
+static shared_ptr<const vector<GlyphBlock>> FindResidentGlyphs(const string& renderKey)
+{
+	if (renderKey.empty()) return nullptr;
+	
+	lock_guard<mutex> lock(residentMutex);
+	
+	for (auto it = residentGlyphs.begin(); it != residentGlyphs.end(); ++it)
 	{
-		PrintError("Failed to load font '" + correctOrigin.string() + "' because the supersample multiplier was out of allowed range!");
+		if (it->renderKey != renderKey) continue;
 		
-		return;
+		residentGlyphs.splice(residentGlyphs.begin(), residentGlyphs, it);
+		return residentGlyphs.front().glyphs;
 	}
 	
-	//
-	// VERIFY ORIGIN
-	//
+	return nullptr;
+}
+
+//Keeps freshly rendered glyphs resident and drops the least recently used
+//ones until the rest fit the limit. Returns the glyphs either way
+static shared_ptr<const vector<GlyphBlock>> StoreResidentGlyphs(
+	const string& renderKey,
+	vector<GlyphBlock>&& glyphs)
+{
+	u64 bytes{};
+	for (const auto& g : glyphs) bytes += sizeof(GlyphBlock) + g.rawPixels.size();
 	
-	if (!exists(correctOrigin))
+	auto shared = make_shared<const vector<GlyphBlock>>(move(glyphs));
+	
+	u64 limit = residentLimit.load(memory_order_relaxed);
+	if (renderKey.empty()
+		|| bytes > limit)
 	{
-		PrintError("Failed to load font because input path '" + correctOrigin.string() + "' does not exist!");
-		
-		return;
+		return shared;
 	}
 	
-	if (!is_regular_file(correctOrigin)
-		|| !correctOrigin.has_extension())
+	lock_guard<mutex> lock(residentMutex);
+	
+	residentGlyphs.push_front(ResidentGlyphs
 	{
-		PrintError("Failed to load font because input path '" + correctOrigin.string() + "' is not a regular file!");
-		
-		return;
-	}
+		.renderKey = renderKey,
+		.glyphs = shared,
+		.bytes = bytes
+	});
+	residentBytes += bytes;
 	
-	if (correctOrigin.extension() != ".ttf"
-		&& correctOrigin.extension() != ".otf")
+	while (residentBytes > limit)
 	{
-		PrintError("Failed to load font because input path '" + correctOrigin.string() + "' extension '" + correctOrigin.extension().string() + "' is not allowed!");
-		
-		return;
+		residentBytes -= residentGlyphs.back().bytes;
+		residentGlyphs.pop_back();
 	}
 	
-	auto fileStatusOrigin = status(correctOrigin);
-	auto filePermsOrigin = fileStatusOrigin.permissions();
-		
-	bool canReadOrigin = (filePermsOrigin & (
-		perms::owner_read
-		| perms::group_read
-		| perms::others_read))  
-		!= perms::none;
-		
-	if (!canReadOrigin)
+	return shared;
+}
+
+//Renders every glyph at every subpixel phase with one task per glyph and phase.
+//FreeType faces are not thread safe, so each worker opens its own face on its own library.
+//threadLimit 1 renders on the calling thread, 0 picks the thread count from the task count
+static vector<GlyphBlock> RenderGlyphs(
+	const path& fontPath,
+	const string& fontKey,
+	size_t glyphHeight,
+	u32 phaseCount,
+	const vector<GlyphSource>& sources,
+	u32 threadLimit)
+{
+	//0 = failed, 1 = rendered, 2 = skipped phase of a glyph without an outline
+	
+	const size_t taskCount = sources.size() * phaseCount;
+	
+	ALLOC_ZONE(blockAlloc, ALLOC_GLYPH_BLOCKS);
+	
+	vector<GlyphBlock> rendered(taskCount);
+	vector<u8> taskResults(taskCount);
+	
+	atomic<size_t> nextTask{};
+	
+	auto Work = [&]()
+		{
+			KALA_TRACE_ZONE("RenderWorker");
+			
+			PROFILE_ZONE(faceZone, PHASE_FACE_LOAD);
+			ALLOC_ZONE(faceAlloc, ALLOC_FACE_LOAD);
+			
+			FT_Face face = OpenFace(fontPath, fontKey);
+			if (!face) return;
+			
+			FT_Set_Pixel_Sizes(face, 0, static_cast<FT_UInt>(glyphHeight));
+			
+			PROFILE_STOP(faceZone);
+			ALLOC_STOP(faceAlloc);
+			
+			for (size_t task = nextTask++; task < taskCount; task = nextTask++)
+			{
+				const GlyphSource& source = sources[task / phaseCount];
+				u32 phase = static_cast<u32>(task % phaseCount);
+				
+				KALA_TRACE_ZONE("RenderGlyph");
+				
+				PROFILE_ZONE(loadZone, PHASE_GLYPH_LOAD);
+				ALLOC_ZONE(renderAlloc, ALLOC_RENDER);
+				
+				if (FT_Load_Glyph(face, source.glyphIndex, FT_LOAD_DEFAULT) != 0) continue;
+				
+				PROFILE_STOP(loadZone);
+				
+				FT_GlyphSlot slot = face->glyph;
+				
+				PROFILE_ZONE(renderZone, PHASE_RENDER);
+				
+				if (phase > 0)
+				{
+					//embedded bitmaps can not be moved by a fraction of a pixel
+					if (slot->format != FT_GLYPH_FORMAT_OUTLINE)
+					{
+						taskResults[task] = 2;
+						continue;
+					}
+					
+					//26.6 fixed point, 64 is one pixel
+					FT_Outline_Translate(
+						&slot->outline,
+						static_cast<FT_Pos>(phase * 64 / phaseCount),
+						0);
+				}
+				
+				if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL) != 0) continue;
+				
+				PROFILE_STOP(renderZone);
+				ALLOC_STOP(renderAlloc);
+				
+				PROFILE_ZONE(copyZone, PHASE_COPY);
+				ALLOC_ZONE(copyAlloc, ALLOC_GLYPH_BLOCKS);
+				
+				FT_Bitmap& bmp = slot->bitmap;
+				
+				GlyphBlock& glyphBlock = rendered[task];
+				glyphBlock = 
+				{
+					.charCode = source.charCode | (phase << KFD_SUBPIXEL_PHASE_SHIFT),
+					.width = static_cast<u16>(bmp.width),
+					.height = static_cast<u16>(bmp.rows),
+					.bearingX = static_cast<i16>(slot->bitmap_left),
+					.bearingY = static_cast<i16>(slot->bitmap_top),
+					.advance = static_cast<u16>((slot->advance.x >> 6))
+				};
+				
+				glyphBlock.rawPixels.assign(
+					bmp.buffer,
+					bmp.buffer + (bmp.rows * abs(bmp.pitch)));
+				
+				glyphBlock.rawPixelSize = static_cast<u32>(glyphBlock.rawPixels.size());
+				
+				taskResults[task] = 1;
+			}
+			
+			CloseFace(face);
+		};
+	
+	size_t threadCount = min(
+		static_cast<size_t>(threadLimit == 0 ? max(thread::hardware_concurrency(), 1u) : threadLimit),
+		taskCount / GLYPHS_PER_RENDER_THREAD + 1);
+	
+	if (threadCount == 1) Work();
+	else
 	{
-		PrintError("Failed to load font because you have insufficient read permissions for input path '" + correctOrigin.string() + "'!");
+		vector<thread> workers{};
+		workers.reserve(threadCount);
 		
-		return;
+		for (size_t i = 0; i < threadCount; ++i) workers.push_back(jthread(Work));
+		for (auto& w : workers) w.join();
 	}
 	
-	//
-	// VERIFY TARGET
-	//
+	//keep the face order, every glyph is followed by its phase variants
 	
-	if (exists(correctTarget))
+	vector<GlyphBlock> glyphs{};
+	glyphs.reserve(taskCount);
+	
+	for (size_t task = 0; task < taskCount; ++task)
 	{
-		PrintError("Failed to load font because output path '" + correctTarget.string() + "' already exists!");
-		
-		return;
+		if (taskResults[task] == 1) glyphs.push_back(move(rendered[task]));
+		else if (taskResults[task] == 0)
+		{
+			u32 charCode = sources[task / phaseCount].charCode;
+			PrintError("FreeType failed to load glyph '" + string(1, static_cast<char>(charCode)) + "'!");
+		}
 	}
-	if (!correctTarget.has_extension()
-		|| correctTarget.extension() != ".kfd")
+	
+	return glyphs;
+}
+
+namespace KalaFont
+{
+	void Parse::Command_Parse(const vector<string>& params)
 	{
-		PrintError("Failed to load font because output path '" + correctTarget.string() + "' extension '" + correctTarget.extension().string() + "' is not allowed!");
-		
-		return;
+		ParseAny(params, false);
 	}
 	
-	auto fileStatusTarget = status(correctTarget.parent_path());
-	auto filePermsTarget = fileStatusTarget.permissions();
-		
-	bool canWriteTarget = (filePermsTarget & (
-		perms::owner_write
-		| perms::group_write
-		| perms::others_write))  
-		!= perms::none;
-			
-	if (!canWriteTarget)
+	void Parse::Command_VerboseParse(const vector<string>& params)
 	{
-		PrintError("Failed to load font because you have insufficient write permissions for output parent path '" + correctTarget.string() + "'!");
-		
-		return;
+		ParseAny(params, true);
 	}
 	
-	//
-	// LOAD FONT
-	//
-	
-	Log::Print(
-		"Starting to load font '" + correctOrigin.string() + "' to target path '" + correctTarget.string() + "'",
-		"FONT",
-		LogType::LOG_DEBUG);
-		
-	FT_Face face{};
-	if (FT_New_Face(ft, correctOrigin.string().c_str(), 0, &face))
+	bool Parse::VerifyParams(
+		const vector<string>& params,
+		const path& baseDir,
+		CompileJob& outJob)
 	{
-		PrintError("FreeType failed to set new face for font '" + correctOrigin.string() + "'!");
+		lastError.clear();
+		
+		KALA_TRACE_ZONE("VerifyParams");
+		PROFILE_ZONE(validationZone, PHASE_VALIDATION);
 		
-		return;
+		path correctOrigin = weakly_canonical(baseDir / params[4]);
+		path correctTarget = weakly_canonical(baseDir / params[5]);
+		
+		//
+		// VERIFY PARAMS
+		//
+		
+		//glyph and instance types can end with ':2', ':3' or ':4' to bake that many subpixel phases
+		
+		string compileType = params[1];
+		u32 phaseCount = 1;
+		
+		size_t phaseSeparator = compileType.find(':');
+		if (phaseSeparator != string::npos)
+		{
+			string phaseText = compileType.substr(phaseSeparator + 1);
+			compileType = compileType.substr(0, phaseSeparator);
+			
+			if (phaseText.size() != 1
+				|| phaseText[0] < '2'
+				|| phaseText[0] > '0' + KFD_MAX_SUBPIXEL_PHASES)
+			{
+				PrintError("Failed to load font '" + correctOrigin.string() + "' because the subpixel phase count was not 2, 3 or 4!");
+				
+				return false;
+			}
+			
+			phaseCount = static_cast<u32>(phaseText[0] - '0');
+		}
+		
+		if (compileType != "bitmap"
+			&& compileType != "glyph"
+			&& compileType != "instance")
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because the load action was invalid!");
+			
+			return false;
+		}
+		
+		//ExportBitmap does not write a kfd yet, rejecting it here keeps parse, batch,
+		//serve and watch from reporting a compiled font without an output
+		if (compileType == "bitmap")
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because bitmap export does not write kfd files yet!");
+			
+			return false;
+		}
+		
+		if (HasAnyNonNumber(params[2])
+			|| HasAnyWhiteSpace(params[2]))
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because the glyph height was an invalid value!");
+			
+			return false;
+		}
+		size_t glyphHeight = stoul(params[2]);
+		if (glyphHeight < MIN_GLYPH_HEIGHT
+			|| glyphHeight > MAX_GLYPH_HEIGHT)
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because the glyph height was out of allowed range!");
+			
+			return false;
+		}
+		
+		if (HasAnyNonNumber(params[3])
+			|| HasAnyWhiteSpace(params[3]))
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because the supersample multiplier was an invalid value!");
+			
+			return false;
+		}
+		size_t supersampleMultiplier = stoul(params[3]);
+		if (supersampleMultiplier < MIN_SUPERSAMPLE
+			|| supersampleMultiplier > MAX_SUPERSAMPLE)
+		{
+			PrintError("Failed to load font '" + correctOrigin.string() + "' because the supersample multiplier was out of allowed range!");
+			
+			return false;
+		}
+		
+		//
+		// VERIFY ORIGIN
+		//
+		
+		if (!exists(correctOrigin))
+		{
+			PrintError("Failed to load font because input path '" + correctOrigin.string() + "' does not exist!");
+			
+			return false;
+		}
+		
+		if (!is_regular_file(correctOrigin)
+			|| !correctOrigin.has_extension())
+		{
+			PrintError("Failed to load font because input path '" + correctOrigin.string() + "' is not a regular file!");
+			
+			return false;
+		}
+		
+		if (correctOrigin.extension() != ".ttf"
+			&& correctOrigin.extension() != ".otf")
+		{
+			PrintError("Failed to load font because input path '" + correctOrigin.string() + "' extension '" + correctOrigin.extension().string() + "' is not allowed!");
+			
+			return false;
+		}
+		
+		auto fileStatusOrigin = status(correctOrigin);
+		auto filePermsOrigin = fileStatusOrigin.permissions();
+		
+		bool canReadOrigin = (filePermsOrigin & (
+			perms::owner_read
+			| perms::group_read
+			| perms::others_read))  
+			!= perms::none;
+		
+		if (!canReadOrigin)
+		{
+			PrintError("Failed to load font because you have insufficient read permissions for input path '" + correctOrigin.string() + "'!");
+			
+			return false;
+		}
+		
+		//
+		// VERIFY TARGET
+		//
+		
+		if (exists(correctTarget))
+		{
+			PrintError("Failed to load font because output path '" + correctTarget.string() + "' already exists!");
+			
+			return false;
+		}
+		if (!correctTarget.has_extension()
+			|| correctTarget.extension() != ".kfd")
+		{
+			PrintError("Failed to load font because output path '" + correctTarget.string() + "' extension '" + correctTarget.extension().string() + "' is not allowed!");
+			
+			return false;
+		}
+		
+		auto fileStatusTarget = status(correctTarget.parent_path());
+		auto filePermsTarget = fileStatusTarget.permissions();
+		
+		bool canWriteTarget = (filePermsTarget & (
+			perms::owner_write
+			| perms::group_write
+			| perms::others_write))  
+			!= perms::none;
+		
+		if (!canWriteTarget)
+		{
+			PrintError("Failed to load font because you have insufficient write permissions for output parent path '" + correctTarget.string() + "'!");
+			
+			return false;
+		}
+		
+		u8 type = 2;
+		if (compileType == "bitmap") type = 1;
+		else if (compileType == "instance") type = 3;
+		
+		outJob = CompileJob
+		{
+			.origin = correctOrigin,
+			.target = correctTarget,
+			.type = type,
+			.phaseCount = phaseCount,
+			.glyphHeight = static_cast<u8>(glyphHeight),
+			.supersampleMultiplier = static_cast<u8>(supersampleMultiplier)
+		};
+		
+		return true;
 	}
 	
-	FT_Set_Pixel_Sizes(face, 0, glyphHeight);
-	
-	FT_ULong charCode{};
-	FT_UInt glyphIndex{};
-	
-	vector<GlyphBlock> glyphs{};
-	
-	charCode = FT_Get_First_Char(face, &glyphIndex);
-	while (glyphIndex != 0)
+	bool Parse::Compile(
+		const CompileJob& job,
+		bool isVerbose,
+		u32 renderThreads,
+		CompileResult& outResult)
 	{
-		if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT) == 0
-			&& FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) == 0)
+		lastError.clear();
+		
+		KALA_TRACE_ZONE("Compile");
+		
+		FT_Library ft = GetFreeType();
+		if (!ft)
+		{
+			PrintError("Failed to initialize FreeType!");
+			
+			return false;
+		}
+		
+		//verbose compiles always run so every glyph can be printed
+		
+		string cacheKey{};
+		if (!isVerbose)
 		{
-			FT_GlyphSlot slot = face->glyph;
-			FT_Bitmap& bmp = slot->bitmap;
+			PROFILE_ZONE(cacheZone, PHASE_CACHE);
+			
+			FT_Int major{};
+			FT_Int minor{};
+			FT_Int patch{};
+			FT_Library_Version(ft, &major, &minor, &patch);
+			
+			cacheKey = BuildCache::GetKey(
+				job,
+				to_string(major) + "." + to_string(minor) + "." + to_string(patch));
 			
-			GlyphBlock glyphBlock = 
+			if (!cacheKey.empty()
+				&& BuildCache::Restore(cacheKey, job.target, outResult))
 			{
-				.charCode = static_cast<u32>(charCode),
-				.width = static_cast<u16>(bmp.width),
-				.height = static_cast<u16>(bmp.rows),
-				.bearingX = static_cast<i16>(slot->bitmap_left),
-				.bearingY = static_cast<i16>(slot->bitmap_top),
-				.advance = static_cast<u16>((slot->advance.x >> 6))
-			};
-			
-			glyphBlock.rawPixels.assign(
-				bmp.buffer,
-				bmp.buffer + (bmp.rows * abs(bmp.pitch)));
+				PROFILE_COUNT(outResult.glyphCount, outResult.outputBytes);
 				
-			glyphBlock.rawPixelSize = static_cast<u32>(glyphBlock.rawPixels.size());
-			
-			glyphs.push_back(move(glyphBlock));
+				return true;
+			}
+		}
+		
+		//
+		// LOAD FONT
+		//
+		
+		Log::Print(
+			"Starting to load font '" + job.origin.string() + "' to target path '" + job.target.string() + "'",
+			"FONT",
+			LogType::LOG_DEBUG);
+		
+		//rendered glyphs only depend on the font, the glyph height and the phase count,
+		//so resident glyphs are shared by every compile type and quality
+		
+		string fontKey{};
+		string renderKey{};
+		if (residentLimit.load(memory_order_relaxed) > 0)
+		{
+			fontKey = GetFontKey(job.origin);
+			if (!fontKey.empty())
+			{
+				renderKey = fontKey
+					+ "|" + to_string(job.glyphHeight)
+					+ "|" + to_string(job.phaseCount);
+			}
+		}
+		
+		shared_ptr<const vector<GlyphBlock>> resident = FindResidentGlyphs(renderKey);
+		if (resident)
+		{
+			Log::Print(
+				"Reused resident glyphs of font '" + job.origin.string() + "'",
+				"FONT",
+				LogType::LOG_DEBUG);
 		}
 		else
 		{
-			PrintError("FreeType failed to load glyph '" + string(1, static_cast<char>(charCode)) + "'!");
+			KALA_TRACE_ZONE("LoadFont");
+			PROFILE_ZONE(faceZone, PHASE_FACE_LOAD);
+			ALLOC_ZONE(faceAlloc, ALLOC_FACE_LOAD);
+			
+			FT_Face face = OpenFace(job.origin, fontKey);
+			if (!face)
+			{
+				PrintError("FreeType failed to set new face for font '" + job.origin.string() + "'!");
+				
+				return false;
+			}
+			
+			FT_Set_Pixel_Sizes(face, 0, job.glyphHeight);
+			
+			PROFILE_STOP(faceZone);
+			
+			//collect every glyph first so they can be rendered in parallel
+			
+			PROFILE_ZONE(charmapZone, PHASE_CHARMAP_WALK);
+			
+			vector<GlyphSource> sources{};
+			
+			FT_UInt glyphIndex{};
+			FT_ULong charCode = FT_Get_First_Char(face, &glyphIndex);
+			while (glyphIndex != 0)
+			{
+				sources.push_back(GlyphSource
+				{
+					.charCode = static_cast<u32>(charCode),
+					.glyphIndex = glyphIndex
+				});
+				
+				charCode = FT_Get_Next_Char(face, charCode, &glyphIndex);
+			}
+			
+			CloseFace(face);
+			
+			PROFILE_STOP(charmapZone);
+			ALLOC_STOP(faceAlloc);
+			
+			//every phase is its own glyph in the kfd, so check before rendering all of them
+			
+			if (sources.size() * job.phaseCount > MAX_GLYPH_COUNT)
+			{
+				PrintError(
+					"Failed to compile font '" + job.origin.string() + "' because its " + to_string(sources.size())
+					+ " glyphs with " + to_string(job.phaseCount) + " subpixel phases make "
+					+ to_string(sources.size() * job.phaseCount) + " glyphs, more than the max allowed count '"
+					+ to_string(MAX_GLYPH_COUNT) + "'!");
+				
+				return false;
+			}
+			
+			resident = StoreResidentGlyphs(
+				renderKey,
+				RenderGlyphs(
+					job.origin,
+					fontKey,
+					job.glyphHeight,
+					job.phaseCount,
+					sources,
+					renderThreads));
+			
+			Log::Print(
+				"Finished loading font!",
+				"FONT",
+				LogType::LOG_SUCCESS);
 		}
 		
-		charCode = FT_Get_Next_Char(face, charCode, &glyphIndex);
+		const vector<GlyphBlock>& glyphs = *resident;
+		
+		//the glyph report is written on its own thread while the font is exported
+		
+		unique_ptr<GlyphReport> report{};
+		if (isVerbose)
+		{
+			report = make_unique<GlyphReport>(job.origin);
+			for (const auto& g : glyphs) report->Add(g);
+		}
+		
+		bool isExported = job.type == 1
+			? Export::ExportBitmap(
+				job.target,
+				job.type,
+				job.glyphHeight,
+				job.supersampleMultiplier,
+				glyphs)
+			: Export::ExportGlyph(
+				job.target,
+				job.type,
+				job.glyphHeight,
+				job.supersampleMultiplier,
+				glyphs);
+		
+		if (!isExported) return false;
+		
+#ifdef KALAFONT_TRACK_ALLOCATIONS
+		//vp reads the exported font back in so the allocation report covers import too
+		if (isVerbose
+			&& job.type != 1)
+		{
+			ALLOC_ZONE(importAlloc, ALLOC_IMPORT);
+			
+			GlyphHeader header{};
+			vector<GlyphTable> tables{};
+			vector<GlyphBlock> blocks{};
+			
+			if (ImportKFD(job.target, header, tables, blocks) != ImportResult::RESULT_SUCCESS)
+			{
+				Log::Print(
+					"Failed to read exported font '" + job.target.string() + "' back in!",
+					"FONT",
+					LogType::LOG_WARNING);
+			}
+		}
+#endif
+		
+		if (!cacheKey.empty())
+		{
+			PROFILE_ZONE(storeZone, PHASE_CACHE);
+			
+			BuildCache::Store(cacheKey, job.target);
+		}
+		
+		error_code ec{};
+		
+		outResult = CompileResult
+		{
+			.glyphCount = static_cast<u32>(glyphs.size()),
+			.outputBytes = exists(job.target, ec) ? static_cast<u64>(file_size(job.target, ec)) : 0
+		};
+		
+		PROFILE_COUNT(outResult.glyphCount, outResult.outputBytes);
+		
+		return true;
 	}
 	
-	u8 type = params[1] == "bitmap" ? 1 : 2;
-	
-	Log::Print(
-		"Finished loading font!",
-		"FONT",
-		LogType::LOG_SUCCESS);
-	
-	if (isVerbose)
+	bool Parse::CompileReplace(
+		const vector<string>& params,
+		const path& baseDir,
+		u32 renderThreads,
+		CompileResult& outResult)
 	{
-		ostringstream oss{};
+		lastError.clear();
+		
+		KALA_TRACE_ZONE("CompileReplace");
 		
-		for (const auto& g : glyphs)
+		path target = weakly_canonical(baseDir / params[5]);
+		if (target.extension() != ".kfd")
 		{
-			oss.str(""); 
-			oss.clear();
+			PrintError("Failed to load font because output path '" + target.string() + "' extension '" + target.extension().string() + "' is not allowed!");
+			
+			return false;
+		}
+		
+		error_code ec{};
+		create_directories(target.parent_path(), ec);
+		
+		static thread_local random_device random{};
+		path temp = target.parent_path() / (target.filename().string() + "." + to_string(random()) + to_string(random()) + ".kfd");
+		
+		vector<string> tempParams = params;
+		tempParams[5] = temp.string();
 		
-			oss << "Glyph info for 'U+" << hex << g.charCode << dec << "'\n"
-				<< "  width:    " << g.width << "\n"
-				<< "  height:   " << g.height << "\n"
-				<< "  bearingX: " << g.bearingX << "\n"
-				<< "  bearingY: " << g.bearingY << "\n"
-				<< "  advance:  " << g.advance << "\n"
-				<< "  size:     " << g.rawPixelSize << "\n\n";
+		CompileJob job{};
+		if (!VerifyParams(tempParams, baseDir, job)
+			|| !Compile(job, false, renderThreads, outResult))
+		{
+			remove(temp, ec);
 			
-			oss << "--------------------\n";
-				
-			Log::Print(oss.str());
+			return false;
+		}
+		
+		rename(temp, target, ec);
+		if (ec)
+		{
+			remove(temp, ec);
+			PrintError("Failed to replace output path '" + target.string() + "'!");
+			
+			return false;
 		}
+		
+		return true;
 	}
 	
-	if (type == 1)
+	void Parse::SetResidentCache(u64 maxBytes)
 	{
-		Export::ExportBitmap(
-			correctTarget,
-			type,
-			static_cast<u8>(glyphHeight),
-			static_cast<u8>(supersampleMultiplier),
-			glyphs);	
+		residentLimit.store(maxBytes, memory_order_relaxed);
+		
+		lock_guard<mutex> lock(residentMutex);
+		
+		while (residentBytes > maxBytes)
+		{
+			residentBytes -= residentGlyphs.back().bytes;
+			residentGlyphs.pop_back();
+		}
 	}
-	else
+	
+	u64 Parse::GetResidentCacheSize()
 	{
-		Export::ExportGlyph(
-			correctTarget,
-			type,
-			static_cast<u8>(glyphHeight),
-			static_cast<u8>(supersampleMultiplier),
-			glyphs);	
+		const char* env = getenv("KALAFONT_SERVE_CACHE_MB");
+		
+		u64 megabytes = env
+			? strtoull(env, nullptr, 10)
+			: DEFAULT_RESIDENT_MB;
+		
+		return megabytes * 1024 * 1024;
 	}
 	
-	FT_Done_Face(face);
-	FT_Done_FreeType(ft);
+	const string& Parse::GetLastError()
+	{
+		return lastError;
+	}
+}
+
+void ParseAny(
+	const vector<string>& params,
+	bool isVerbose)
+{
+	KALA_TRACE_ZONE("ParseAny");
+	PROFILE_SESSION(isVerbose ? "vp" : "parse");
+	ALLOC_SESSION("vp", isVerbose);
+	
+	string& currentDir = Core::GetCurrentDir();
+	
+	if (currentDir.empty()) currentDir = current_path().string();
+	
+	CompileJob job{};
+	if (!Parse::VerifyParams(params, path(currentDir), job)) return;
+	
+	CompileResult result{};
+	Parse::Compile(job, isVerbose, 0, result);
 }
\ No newline at end of file
@@ -0,0 +1,291 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/trace_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "profile.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaTrace::Trace;
+
+using KalaCLI::Core;
+
+using KalaFont::Profile;
+using KalaFont::ProfilePhase;
+
+using std::vector;
+using std::string;
+using std::ofstream;
+using std::ios;
+using std::ostringstream;
+using std::fixed;
+using std::setw;
+using std::setprecision;
+using std::left;
+using std::right;
+using std::atomic;
+using std::memory_order_relaxed;
+using std::mutex;
+using std::lock_guard;
+using std::atexit;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::weakly_canonical;
+
+using u64 = uint64_t;
+using f64 = double;
+
+constexpr size_t PHASE_COUNT = static_cast<size_t>(ProfilePhase::PHASE_COUNT);
+
+//Names in the table and the json report, same order as ProfilePhase
+constexpr const char* PHASE_NAMES[PHASE_COUNT] =
+{
+	"validation",
+	"cache",
+	"face load",
+	"charmap walk",
+	"glyph load",
+	"render",
+	"copy",
+	"serialize",
+	"file write"
+};
+
+//Totals of every phase since the last report
+struct alignas(64) PhaseTotal
+{
+	atomic<u64> nanoseconds{};
+	atomic<u64> calls{};
+};
+
+static PhaseTotal phaseTotals[PHASE_COUNT]{};
+static atomic<u64> glyphCount{};
+static atomic<u64> byteCount{};
+
+static mutex reportMutex{};
+static path reportPath{};
+static vector<string> reportRuns{}; //json object of every reported run
+
+static path tracePath{};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"PROFILE",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static f64 ToMilliseconds(u64 nanoseconds)
+{
+	return static_cast<f64>(nanoseconds) / 1e6;
+}
+
+static void WriteTrace()
+{
+	Trace::Stop();
+	
+	if (!Trace::WriteJson(tracePath))
+	{
+		PrintError("Failed to write trace '" + tracePath.string() + "'!");
+		
+		return;
+	}
+	
+	Log::Print(
+		"Wrote trace '" + tracePath.string() + "', open it in Perfetto or chrome://tracing",
+		"PROFILE",
+		LogType::LOG_INFO);
+}
+
+namespace KalaFont
+{
+	void Profile::Command_Profile(const vector<string>& params)
+	{
+#ifndef KALAFONT_PROFILE
+		PrintError("Failed to enable profiling because this build was compiled without KALAFONT_PROFILE!");
+#else
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		
+		path target = weakly_canonical(path(currentDir) / params[1]);
+		if (target.extension() != ".json")
+		{
+			PrintError("Failed to enable profiling because report path '" + target.string() + "' extension '" + target.extension().string() + "' is not allowed!");
+			
+			return;
+		}
+		
+		{
+			lock_guard<mutex> lock(reportMutex);
+			
+			reportPath = target;
+			reportRuns.clear();
+		}
+		
+		isEnabled.store(true, memory_order_relaxed);
+		
+		Log::Print(
+			"Profiling the next commands, the report is written to '" + target.string() + "'",
+			"PROFILE",
+			LogType::LOG_INFO);
+#endif
+	}
+	
+	void Profile::Command_Trace(const vector<string>& params)
+	{
+#ifndef KALA_ENABLE_TRACE
+		PrintError("Failed to enable tracing because this build was compiled without KALA_ENABLE_TRACE!");
+#else
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		
+		path target = weakly_canonical(path(currentDir) / params[1]);
+		if (target.extension() != ".json")
+		{
+			PrintError("Failed to enable tracing because trace path '" + target.string() + "' extension '" + target.extension().string() + "' is not allowed!");
+			
+			return;
+		}
+		
+		//the trace is written once, a later --trace in the same stack only moves it
+		
+		if (tracePath.empty()) atexit(WriteTrace);
+		tracePath = target;
+		
+		Trace::Start();
+		
+		Log::Print(
+			"Tracing the next commands, the trace is written to '" + target.string() + "' on exit",
+			"PROFILE",
+			LogType::LOG_INFO);
+#endif
+	}
+	
+	void Profile::AddTime(
+		ProfilePhase phase,
+		u64 nanoseconds)
+	{
+		PhaseTotal& total = phaseTotals[static_cast<size_t>(phase)];
+		
+		total.nanoseconds.fetch_add(nanoseconds, memory_order_relaxed);
+		total.calls.fetch_add(1, memory_order_relaxed);
+	}
+	
+	void Profile::AddCount(
+		u64 glyphs,
+		u64 bytes)
+	{
+		glyphCount.fetch_add(glyphs, memory_order_relaxed);
+		byteCount.fetch_add(bytes, memory_order_relaxed);
+	}
+	
+	void Profile::Report(
+		const string& command,
+		u64 wallNanoseconds)
+	{
+		lock_guard<mutex> lock(reportMutex);
+		
+		f64 wallSeconds = static_cast<f64>(wallNanoseconds) / 1e9;
+		if (wallSeconds <= 0.0) wallSeconds = 1e-9;
+		
+		u64 glyphs = glyphCount.exchange(0, memory_order_relaxed);
+		u64 bytes = byteCount.exchange(0, memory_order_relaxed);
+		
+		//
+		// TABLE
+		//
+		
+		ostringstream table{};
+		table << fixed << setprecision(3)
+			<< "Profile of " << command << ": " << glyphs << " glyphs and " << bytes << " bytes in "
+			<< ToMilliseconds(wallNanoseconds) << " ms ("
+			<< setprecision(0) << (glyphs / wallSeconds) << " glyphs/s, "
+			<< setprecision(2) << (bytes / wallSeconds / (1024.0 * 1024.0)) << " MB/s)\n"
+			<< "  " << left << setw(14) << "phase" << right << setw(12) << "ms" << setw(10) << "calls" << setw(9) << "share";
+		
+		ostringstream json{};
+		json << fixed << setprecision(9)
+			<< "    {\n"
+			<< "      \"command\": \"" << command << "\",\n"
+			<< "      \"wallSeconds\": " << wallSeconds << ",\n"
+			<< "      \"glyphs\": " << glyphs << ",\n"
+			<< "      \"bytes\": " << bytes << ",\n"
+			<< setprecision(3)
+			<< "      \"glyphsPerSecond\": " << (glyphs / wallSeconds) << ",\n"
+			<< "      \"bytesPerSecond\": " << (bytes / wallSeconds) << ",\n"
+			<< "      \"phases\": [";
+		
+		for (size_t i = 0; i < PHASE_COUNT; ++i)
+		{
+			u64 nanoseconds = phaseTotals[i].nanoseconds.exchange(0, memory_order_relaxed);
+			u64 calls = phaseTotals[i].calls.exchange(0, memory_order_relaxed);
+			
+			//summed thread time can be more than the wall time
+			f64 share = static_cast<f64>(nanoseconds) / static_cast<f64>(wallNanoseconds == 0 ? 1 : wallNanoseconds);
+			
+			table << "\n  " << left << setw(14) << PHASE_NAMES[i] << right
+				<< setw(12) << setprecision(3) << ToMilliseconds(nanoseconds)
+				<< setw(10) << calls
+				<< setw(8) << setprecision(1) << (share * 100.0) << "%";
+			
+			json << (i == 0 ? "\n" : ",\n")
+				<< "        { \"name\": \"" << PHASE_NAMES[i] << "\", "
+				<< "\"seconds\": " << setprecision(9) << (static_cast<f64>(nanoseconds) / 1e9) << ", "
+				<< "\"calls\": " << calls << ", "
+				<< "\"share\": " << setprecision(4) << share << " }";
+		}
+		
+		table << "\n  glyph load, render and copy are summed over the render threads";
+		
+		json << "\n      ]\n"
+			<< "    }";
+		
+		Log::Print(
+			table.str(),
+			"PROFILE",
+			LogType::LOG_INFO);
+		
+		//
+		// JSON REPORT
+		//
+		
+		reportRuns.push_back(json.str());
+		
+		ostringstream report{};
+		report << "{\n  \"runs\": [\n";
+		for (size_t i = 0; i < reportRuns.size(); ++i)
+		{
+			report << reportRuns[i] << (i + 1 < reportRuns.size() ? ",\n" : "\n");
+		}
+		report << "  ]\n}\n";
+		
+		ofstream file(reportPath, ios::binary);
+		file << report.str();
+		file.close();
+		
+		if (file.fail())
+		{
+			PrintError("Failed to write profile report '" + reportPath.string() + "'!");
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,363 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+#include <charconv>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/import_kfd.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "report.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaFontData::GetSubpixelPhase;
+using KalaHeaders::KalaFontData::GetBaseCharCode;
+
+using KalaCLI::Core;
+
+using KalaFont::GlyphReport;
+using KalaFont::GlyphRecord;
+using KalaFont::ReportFormat;
+
+using std::vector;
+using std::string;
+using std::ofstream;
+using std::ios;
+using std::streamsize;
+using std::fwrite;
+using std::fflush;
+using std::to_chars;
+using std::make_unique;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::this_thread::yield;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::weakly_canonical;
+
+using u32 = uint32_t;
+using u64 = uint64_t;
+
+//Glyphs the ring holds, the compile only waits for the writer once it is this far behind
+constexpr u64 REPORT_RING_SIZE = 4096;
+
+//The writer is woken once this many glyphs are queued
+constexpr u64 REPORT_WAKE_INTERVAL = 256;
+
+//Formatted bytes collected before they are written out
+constexpr size_t REPORT_CHUNK_SIZE = 64 * 1024;
+
+static mutex settingsMutex{};
+static ReportFormat reportFormat = ReportFormat::FORMAT_TEXT;
+static path reportPath{};          //empty writes to stdout
+static bool hasWrittenFile{};      //the first report of a file replaces it
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"REPORT",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static void AppendNumber(
+	string& out,
+	long long value,
+	int base = 10)
+{
+	char digits[24]{};
+	auto result = to_chars(digits, digits + sizeof(digits), value, base);
+	out.append(digits, result.ptr);
+}
+
+//Quotes a field for csv or json, font paths can hold quotes and backslashes
+static string Quote(
+	const string& text,
+	ReportFormat format)
+{
+	string quoted = "\"";
+	for (char c : text)
+	{
+		if (c == '"') quoted += format == ReportFormat::FORMAT_CSV ? "\"\"" : "\\\"";
+		else if (c == '\\' && format == ReportFormat::FORMAT_JSONL) quoted += "\\\\";
+		else quoted += c;
+	}
+	quoted += '"';
+	
+	return quoted;
+}
+
+static void AppendRecord(
+	string& out,
+	const GlyphRecord& r,
+	ReportFormat format,
+	const string& quotedFont)
+{
+	u32 codepoint = GetBaseCharCode(r.charCode);
+	u32 phase = GetSubpixelPhase(r.charCode);
+	
+	switch (format)
+	{
+	case ReportFormat::FORMAT_TEXT:
+		out += "  U+";
+		AppendNumber(out, codepoint, 16);
+		if (phase > 0)
+		{
+			out += " phase ";
+			AppendNumber(out, phase);
+		}
+		out += " width ";
+		AppendNumber(out, r.width);
+		out += " height ";
+		AppendNumber(out, r.height);
+		out += " bearingX ";
+		AppendNumber(out, r.bearingX);
+		out += " bearingY ";
+		AppendNumber(out, r.bearingY);
+		out += " advance ";
+		AppendNumber(out, r.advance);
+		out += " size ";
+		AppendNumber(out, r.rawPixelSize);
+		break;
+	case ReportFormat::FORMAT_CSV:
+		out += quotedFont;
+		out += ',';
+		AppendNumber(out, codepoint);
+		out += ',';
+		AppendNumber(out, phase);
+		out += ',';
+		AppendNumber(out, r.width);
+		out += ',';
+		AppendNumber(out, r.height);
+		out += ',';
+		AppendNumber(out, r.bearingX);
+		out += ',';
+		AppendNumber(out, r.bearingY);
+		out += ',';
+		AppendNumber(out, r.advance);
+		out += ',';
+		AppendNumber(out, r.rawPixelSize);
+		break;
+	case ReportFormat::FORMAT_JSONL:
+		out += "{\"font\":";
+		out += quotedFont;
+		out += ",\"codepoint\":";
+		AppendNumber(out, codepoint);
+		out += ",\"phase\":";
+		AppendNumber(out, phase);
+		out += ",\"width\":";
+		AppendNumber(out, r.width);
+		out += ",\"height\":";
+		AppendNumber(out, r.height);
+		out += ",\"bearingX\":";
+		AppendNumber(out, r.bearingX);
+		out += ",\"bearingY\":";
+		AppendNumber(out, r.bearingY);
+		out += ",\"advance\":";
+		AppendNumber(out, r.advance);
+		out += ",\"size\":";
+		AppendNumber(out, r.rawPixelSize);
+		out += '}';
+		break;
+	}
+	
+	out += '\n';
+}
+
+namespace KalaFont
+{
+	void GlyphReport::Command_Report(const vector<string>& params)
+	{
+		const string& value = params[1];
+		
+		ReportFormat format{};
+		path target{};
+		
+		if (value == "text") format = ReportFormat::FORMAT_TEXT;
+		else if (value == "csv") format = ReportFormat::FORMAT_CSV;
+		else if (value == "jsonl") format = ReportFormat::FORMAT_JSONL;
+		else
+		{
+			string& currentDir = Core::GetCurrentDir();
+			
+			if (currentDir.empty()) currentDir = current_path().string();
+			
+			target = weakly_canonical(path(currentDir) / value);
+			
+			if (target.extension() == ".txt") format = ReportFormat::FORMAT_TEXT;
+			else if (target.extension() == ".csv") format = ReportFormat::FORMAT_CSV;
+			else if (target.extension() == ".jsonl") format = ReportFormat::FORMAT_JSONL;
+			else
+			{
+				PrintError("Failed to set glyph report because '" + value + "' is not text, csv, jsonl or a .txt, .csv or .jsonl path!");
+				
+				return;
+			}
+		}
+		
+		lock_guard<mutex> lock(settingsMutex);
+		
+		reportFormat = format;
+		reportPath = target;
+		hasWrittenFile = false;
+	}
+	
+	GlyphReport::GlyphReport(const path& fontPath)
+		: font(fontPath.string()),
+		records(make_unique<GlyphRecord[]>(REPORT_RING_SIZE))
+	{
+		{
+			lock_guard<mutex> lock(settingsMutex);
+			
+			format = reportFormat;
+			target = reportPath;
+			
+			if (!target.empty())
+			{
+				isFirstInFile = !hasWrittenFile;
+				hasWrittenFile = true;
+			}
+		}
+		
+		writer = thread([this]() { Write(); });
+	}
+	
+	GlyphReport::~GlyphReport()
+	{
+		{
+			lock_guard<mutex> lock(wakeMutex);
+			isDone.store(true, memory_order_release);
+		}
+		wakeCondition.notify_one();
+		
+		if (writer.joinable()) writer.join();
+	}
+	
+	void GlyphReport::Add(const GlyphBlock& glyph)
+	{
+		u64 position = head.load(memory_order_relaxed);
+		
+		while (position - tail.load(memory_order_acquire) == REPORT_RING_SIZE)
+		{
+			wakeCondition.notify_one();
+			yield();
+		}
+		
+		records[position % REPORT_RING_SIZE] = GlyphRecord
+		{
+			.charCode = glyph.charCode,
+			.rawPixelSize = glyph.rawPixelSize,
+			.width = glyph.width,
+			.height = glyph.height,
+			.bearingX = glyph.bearingX,
+			.bearingY = glyph.bearingY,
+			.advance = glyph.advance
+		};
+		head.store(position + 1, memory_order_release);
+		
+		if ((position + 1) % REPORT_WAKE_INTERVAL == 0)
+		{
+			//taking the lock keeps the wake from landing between the writers check and its wait
+			lock_guard<mutex> lock(wakeMutex);
+			wakeCondition.notify_one();
+		}
+	}
+	
+	void GlyphReport::Write()
+	{
+		ofstream file{};
+		if (!target.empty())
+		{
+			file.open(target, isFirstInFile ? ios::binary | ios::trunc : ios::binary | ios::app);
+			if (!file)
+			{
+				PrintError("Failed to open glyph report '" + target.string() + "'!");
+			}
+		}
+		
+		auto Flush = [&](string& out)
+			{
+				if (out.empty()) return;
+				
+				if (target.empty())
+				{
+					fwrite(out.data(), 1, out.size(), stdout);
+					fflush(stdout);
+				}
+				else if (file) file.write(out.data(), static_cast<streamsize>(out.size()));
+				
+				out.clear();
+			};
+		
+		string out{};
+		out.reserve(REPORT_CHUNK_SIZE + 256);
+		
+		string quotedFont = Quote(font, format);
+		
+		if (format == ReportFormat::FORMAT_TEXT) out += "Glyph report of '" + font + "'\n";
+		else if (format == ReportFormat::FORMAT_CSV
+			&& (target.empty() || isFirstInFile))
+		{
+			out += "font,codepoint,phase,width,height,bearingX,bearingY,advance,size\n";
+		}
+		
+		u64 position{};
+		
+		while (true)
+		{
+			u64 end = head.load(memory_order_acquire);
+			
+			if (position == end)
+			{
+				unique_lock<mutex> lock(wakeMutex);
+				if (isDone.load(memory_order_acquire)
+					&& position == head.load(memory_order_acquire))
+				{
+					break;
+				}
+				
+				//write what is formatted while waiting for more
+				lock.unlock();
+				Flush(out);
+				lock.lock();
+				
+				wakeCondition.wait(lock, [&]()
+					{
+						return isDone.load(memory_order_acquire)
+							|| head.load(memory_order_acquire) - position >= REPORT_WAKE_INTERVAL;
+					});
+				
+				continue;
+			}
+			
+			for (; position != end; ++position)
+			{
+				AppendRecord(out, records[position % REPORT_RING_SIZE], format, quotedFont);
+				
+				if (out.size() >= REPORT_CHUNK_SIZE) Flush(out);
+			}
+			
+			tail.store(position, memory_order_release);
+		}
+		
+		Flush(out);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,676 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <afunix.h>
+	#ifndef IO_REPARSE_TAG_AF_UNIX
+		#define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+	#endif
+	#include <io.h>
+	#include <fcntl.h>
+#else
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+	#include <csignal>
+#endif
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/trace_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "serve.hpp"
+#include "parse.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::jthread;
+using KalaHeaders::KalaThread::dthread;
+
+using KalaCLI::Core;
+
+using KalaFont::Serve;
+using KalaFont::Parse;
+using KalaFont::CompileJob;
+using KalaFont::CompileResult;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ifstream;
+using std::ios;
+using std::istreambuf_iterator;
+using std::ostringstream;
+using std::hex;
+using std::deque;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::condition_variable;
+using std::atomic;
+using std::shared_ptr;
+using std::make_shared;
+using std::thread;
+using std::move;
+using std::min;
+using std::max;
+using std::random_device;
+using std::memcpy;
+using std::fread;
+using std::fflush;
+using std::error_code;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::milli;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::create_directories;
+using std::filesystem::temp_directory_path;
+using std::filesystem::remove;
+using std::filesystem::exists;
+using std::filesystem::is_socket;
+using std::filesystem::symlink_status;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+constexpr SocketHandle NO_SOCKET = INVALID_SOCKET;
+#else
+using SocketHandle = int;
+constexpr SocketHandle NO_SOCKET = -1;
+#endif
+
+//Largest accepted request payload, requests only carry params and paths
+constexpr u32 MAX_REQUEST_SIZE = 64 * 1024;
+
+//Text fields of a request after its id, the same order as the parse command params
+constexpr size_t REQUEST_FIELD_COUNT = 5;
+
+constexpr u8 STATUS_COMPILED = 0;
+constexpr u8 STATUS_FAILED = 1;
+
+//One client, either a socket connection or the stdin and stdout pipes
+struct Connection
+{
+	SocketHandle socket = NO_SOCKET;
+	int outFile = -1; //duplicate of the original stdout for stdio clients
+	mutex writeMutex{};
+	
+	~Connection();
+};
+
+//One compile request waiting for a worker
+struct ServeRequest
+{
+	shared_ptr<Connection> client{};
+	u32 id{};
+	vector<string> fields{};
+};
+
+static mutex queueMutex{};
+static condition_variable queueCondition{};
+static deque<ServeRequest> requests{};
+static bool isStopping{};
+
+static atomic<u32> activeRequests{};
+static atomic<SocketHandle> listenSocket{ NO_SOCKET };
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"SERVE",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static void CloseSocket(SocketHandle socket)
+{
+#ifdef _WIN32
+	closesocket(socket);
+#else
+	close(socket);
+#endif
+}
+
+Connection::~Connection()
+{
+	if (socket != NO_SOCKET) CloseSocket(socket);
+}
+
+//Reads exactly size bytes, returns false once the client is gone
+static bool ReadExact(
+	Connection& client,
+	u8* data,
+	size_t size)
+{
+	while (size > 0)
+	{
+		size_t read{};
+		
+		if (client.socket != NO_SOCKET)
+		{
+#ifdef _WIN32
+			int result = recv(client.socket, reinterpret_cast<char*>(data), static_cast<int>(min(size, size_t{ 1 } << 30)), 0);
+#else
+			ssize_t result = recv(client.socket, data, size, 0);
+#endif
+			if (result <= 0) return false;
+			read = static_cast<size_t>(result);
+		}
+		else
+		{
+			read = fread(data, 1, size, stdin);
+			if (read == 0) return false;
+		}
+		
+		data += read;
+		size -= read;
+	}
+	
+	return true;
+}
+
+//Writes every byte, returns false once the client is gone
+static bool WriteExact(
+	Connection& client,
+	const u8* data,
+	size_t size)
+{
+	while (size > 0)
+	{
+		size_t written{};
+
+#ifdef _WIN32
+		int chunk = static_cast<int>(min(size, size_t{ 1 } << 30));
+		int result = client.socket != NO_SOCKET
+			? send(client.socket, reinterpret_cast<const char*>(data), chunk, 0)
+			: _write(client.outFile, data, static_cast<unsigned int>(chunk));
+#else
+		ssize_t result = client.socket != NO_SOCKET
+			? send(client.socket, data, size, 0)
+			: write(client.outFile, data, size);
+#endif
+		if (result <= 0) return false;
+		written = static_cast<size_t>(result);
+		
+		data += written;
+		size -= written;
+	}
+	
+	return true;
+}
+
+static void WriteU32(
+	vector<u8>& out,
+	u32 value)
+{
+	for (u32 i = 0; i < 4; ++i) out.push_back(static_cast<u8>(value >> (i * 8)));
+}
+
+static u32 ReadU32(const u8* data)
+{
+	return static_cast<u32>(data[0])
+		| (static_cast<u32>(data[1]) << 8)
+		| (static_cast<u32>(data[2]) << 16)
+		| (static_cast<u32>(data[3]) << 24);
+}
+
+static string GetRandomName()
+{
+	static thread_local random_device random{};
+	
+	ostringstream oss{};
+	oss << hex << random() << random();
+	return oss.str();
+}
+
+//Compiles one request, written targets are replaced in one rename so clients
+//never see a half written file. Returns the error message if it failed
+static string CompileRequest(
+	const ServeRequest& request,
+	vector<u8>& outBytes,
+	CompileResult& outResult)
+{
+	const bool isReturned = request.fields[4].empty();
+	
+	const path baseDir = path(Core::GetCurrentDir());
+	
+	error_code ec{};
+	
+	path temp{};
+	if (isReturned)
+	{
+		path tempDir = temp_directory_path(ec) / "KalaFont" / "serve";
+		create_directories(tempDir, ec);
+		
+		temp = tempDir / (GetRandomName() + ".kfd");
+	}
+	
+	vector<string> params
+	{
+		"serve",
+		request.fields[0],
+		request.fields[1],
+		request.fields[2],
+		request.fields[3],
+		isReturned ? temp.string() : request.fields[4]
+	};
+	
+	//fonts only render their glyphs on several threads while no other request runs
+	
+	u32 renderThreads = activeRequests.load() > 1 ? 1 : 0;
+	
+	CompileJob job{};
+	bool isCompiled = isReturned
+		? Parse::VerifyParams(params, baseDir, job)
+			&& Parse::Compile(job, false, renderThreads, outResult)
+		: Parse::CompileReplace(params, baseDir, renderThreads, outResult);
+	
+	if (!isCompiled)
+	{
+		remove(temp, ec);
+		
+		return Parse::GetLastError().empty()
+			? "Failed to compile font '" + request.fields[3] + "', see the server log for the reason!"
+			: Parse::GetLastError();
+	}
+	
+	if (isReturned)
+	{
+		ifstream in(temp, ios::binary);
+		outBytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+		in.close();
+		
+		remove(temp, ec);
+		
+		if (outBytes.size() != outResult.outputBytes)
+		{
+			return "Failed to read compiled font '" + temp.string() + "'!";
+		}
+	}
+	
+	return {};
+}
+
+static void SendResponse(
+	const ServeRequest& request,
+	u8 status,
+	u32 glyphCount,
+	const vector<u8>& body)
+{
+	vector<u8> frame{};
+	frame.reserve(4 + 9);
+	
+	WriteU32(frame, static_cast<u32>(9 + body.size()));
+	WriteU32(frame, request.id);
+	frame.push_back(status);
+	WriteU32(frame, glyphCount);
+	
+	lock_guard<mutex> lock(request.client->writeMutex);
+	
+	if (!WriteExact(*request.client, frame.data(), frame.size())
+		|| !WriteExact(*request.client, body.data(), body.size()))
+	{
+		PrintError("Failed to send the response of request " + to_string(request.id) + ", the client is gone!");
+	}
+}
+
+static void HandleRequest(const ServeRequest& request)
+{
+	KALA_TRACE_ZONE("ServeRequest");
+	
+	++activeRequests;
+	
+	auto start = steady_clock::now();
+	
+	vector<u8> bytes{};
+	CompileResult result{};
+	string error = CompileRequest(request, bytes, result);
+	
+	--activeRequests;
+	
+	if (!error.empty())
+	{
+		PrintError("Request " + to_string(request.id) + " failed: " + error);
+		
+		SendResponse(request, STATUS_FAILED, 0, vector<u8>(error.begin(), error.end()));
+		return;
+	}
+	
+	f64 milliseconds = duration<f64, milli>(steady_clock::now() - start).count();
+	
+	Log::Print(
+		"Request " + to_string(request.id) + " compiled '" + request.fields[3] + "' at height "
+		+ request.fields[1] + " in " + to_string(milliseconds) + " ms",
+		"SERVE",
+		LogType::LOG_SUCCESS);
+	
+	SendResponse(request, STATUS_COMPILED, result.glyphCount, bytes);
+}
+
+//Takes queued requests until the server stops and the queue is empty
+static void RunWorker()
+{
+	while (true)
+	{
+		ServeRequest request{};
+		
+		{
+			unique_lock<mutex> lock(queueMutex);
+			queueCondition.wait(lock, []() { return isStopping || !requests.empty(); });
+			
+			if (requests.empty()) return;
+			
+			request = move(requests.front());
+			requests.pop_front();
+		}
+		
+		HandleRequest(request);
+	}
+}
+
+//Stops taking new requests and clients, queued requests still finish
+static void StopServer()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		isStopping = true;
+	}
+	queueCondition.notify_all();
+	
+	SocketHandle socket = listenSocket.exchange(NO_SOCKET);
+	if (socket != NO_SOCKET)
+	{
+#ifdef _WIN32
+		shutdown(socket, SD_BOTH);
+#else
+		shutdown(socket, SHUT_RDWR);
+#endif
+		CloseSocket(socket);
+	}
+}
+
+//Reads request frames of one client and queues them until the client is gone or sends stop
+static void ReadRequests(const shared_ptr<Connection>& client)
+{
+	vector<u8> payload{};
+	
+	while (true)
+	{
+		u8 header[4]{};
+		if (!ReadExact(*client, header, 4)) return;
+		
+		u32 size = ReadU32(header);
+		if (size < 4
+			|| size > MAX_REQUEST_SIZE)
+		{
+			PrintError("Closed a client because its request size " + to_string(size) + " was not between 4 and " + to_string(MAX_REQUEST_SIZE) + " bytes!");
+			
+			return;
+		}
+		
+		payload.resize(size);
+		if (!ReadExact(*client, payload.data(), size)) return;
+		
+		ServeRequest request
+		{
+			.client = client,
+			.id = ReadU32(payload.data())
+		};
+		
+		//fields are separated by '\0', a trailing separator is allowed
+		
+		string field{};
+		for (size_t i = 4; i < size; ++i)
+		{
+			if (payload[i] != '\0')
+			{
+				field += static_cast<char>(payload[i]);
+				continue;
+			}
+			
+			request.fields.push_back(move(field));
+			field.clear();
+		}
+		if (!field.empty()
+			|| request.fields.size() < REQUEST_FIELD_COUNT)
+		{
+			request.fields.push_back(move(field));
+		}
+		
+		if (request.fields[0] == "stop")
+		{
+			SendResponse(request, STATUS_COMPILED, 0, {});
+			StopServer();
+			
+			return;
+		}
+		
+		if (request.fields.size() != REQUEST_FIELD_COUNT)
+		{
+			string error = "Request " + to_string(request.id) + " has " + to_string(request.fields.size())
+				+ " fields, expected " + to_string(REQUEST_FIELD_COUNT) + " (type height quality origin target)!";
+			
+			PrintError(error);
+			SendResponse(request, STATUS_FAILED, 0, vector<u8>(error.begin(), error.end()));
+			continue;
+		}
+		
+		{
+			lock_guard<mutex> lock(queueMutex);
+			if (isStopping) return;
+			
+			requests.push_back(move(request));
+		}
+		queueCondition.notify_one();
+	}
+}
+
+//Returns true if the path is a unix socket file
+static bool IsSocketFile(const path& socketPath)
+{
+#ifdef _WIN32
+	//afunix sockets are reparse points that std::filesystem does not report as sockets
+	WIN32_FIND_DATAW data{};
+	HANDLE find = FindFirstFileW(socketPath.c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE) return false;
+	
+	FindClose(find);
+	
+	return (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0
+		&& data.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+#else
+	error_code ec{};
+	return is_socket(symlink_status(socketPath, ec));
+#endif
+}
+
+//Opens the listening socket, a stale socket file of an earlier server is replaced.
+//Any other file at the socket path is left alone and fails the start
+static SocketHandle OpenSocket(const path& socketPath)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	
+	string pathText = socketPath.string();
+	if (pathText.size() >= sizeof(address.sun_path))
+	{
+		PrintError("Failed to start serve because socket path '" + pathText + "' is longer than " + to_string(sizeof(address.sun_path) - 1) + " characters!");
+		
+		return NO_SOCKET;
+	}
+	memcpy(address.sun_path, pathText.c_str(), pathText.size() + 1);
+	
+	error_code ec{};
+	if (exists(symlink_status(socketPath, ec)))
+	{
+		if (!IsSocketFile(socketPath))
+		{
+			PrintError("Failed to start serve because socket path '" + pathText + "' already exists and is not a socket!");
+			
+			return NO_SOCKET;
+		}
+		
+		remove(socketPath, ec);
+	}
+	
+	SocketHandle socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (socket == NO_SOCKET)
+	{
+		PrintError("Failed to create the serve socket!");
+		
+		return NO_SOCKET;
+	}
+	
+	if (bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+		|| listen(socket, SOMAXCONN) != 0)
+	{
+		PrintError("Failed to listen on socket path '" + pathText + "'!");
+		
+		CloseSocket(socket);
+		return NO_SOCKET;
+	}
+	
+	return socket;
+}
+
+namespace KalaFont
+{
+	void Serve::Command_Serve(const vector<string>& params)
+	{
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		
+		const bool isStdio = params[1] == "stdio";
+		
+		shared_ptr<Connection> stdioClient{};
+		path socketPath{};
+		
+		if (isStdio)
+		{
+			//the protocol owns the original stdout, logs move to stderr
+			
+			fflush(stdout);
+			
+			stdioClient = make_shared<Connection>();
+#ifdef _WIN32
+			_setmode(_fileno(stdin), _O_BINARY);
+			stdioClient->outFile = _dup(_fileno(stdout));
+			_setmode(stdioClient->outFile, _O_BINARY);
+			_dup2(_fileno(stderr), _fileno(stdout));
+#else
+			stdioClient->outFile = dup(fileno(stdout));
+			dup2(fileno(stderr), fileno(stdout));
+#endif
+			if (stdioClient->outFile < 0)
+			{
+				PrintError("Failed to start serve because stdout could not be duplicated!");
+				
+				return;
+			}
+		}
+		else
+		{
+#ifdef _WIN32
+			WSADATA wsaData{};
+			if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+			{
+				PrintError("Failed to start serve because winsock could not be initialized!");
+				
+				return;
+			}
+#else
+			//clients that disconnect early must not end the server
+			signal(SIGPIPE, SIG_IGN);
+#endif
+			socketPath = weakly_canonical(path(currentDir) / params[1]);
+			
+			SocketHandle socket = OpenSocket(socketPath);
+			if (socket == NO_SOCKET) return;
+			
+			listenSocket.store(socket);
+		}
+		
+		Parse::SetResidentCache(Parse::GetResidentCacheSize());
+		
+		u32 threadCount = max(thread::hardware_concurrency(), 1u);
+		
+		vector<thread> workers{};
+		workers.reserve(threadCount);
+		for (u32 i = 0; i < threadCount; ++i) workers.push_back(jthread(RunWorker));
+		
+		Log::Print(
+			"Serving compile requests on '" + (isStdio ? string("stdio") : socketPath.string()) + "' with " + to_string(threadCount) + " threads",
+			"SERVE",
+			LogType::LOG_SUCCESS);
+		
+		if (isStdio)
+		{
+			ReadRequests(stdioClient);
+			StopServer();
+		}
+		else
+		{
+			//every client gets its own reader, requests of all clients share the workers
+			
+			while (true)
+			{
+				SocketHandle socket = listenSocket.load();
+				if (socket == NO_SOCKET) break;
+				
+				SocketHandle clientSocket = accept(socket, nullptr, nullptr);
+				if (clientSocket == NO_SOCKET) break;
+				
+				auto client = make_shared<Connection>();
+				client->socket = clientSocket;
+				
+				dthread([client]() { ReadRequests(client); });
+			}
+			
+			StopServer();
+		}
+		
+		for (auto& w : workers) w.join();
+		
+		Parse::SetResidentCache(0);
+		
+		if (!isStdio)
+		{
+			error_code ec{};
+			remove(socketPath, ec);
+		}
+		
+		Log::Print(
+			"Stopped serving compile requests",
+			"SERVE",
+			LogType::LOG_SUCCESS);
+	}
+}
\ No newline at end of file
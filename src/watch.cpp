@@ -0,0 +1,533 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "watch.hpp"
+#include "batch.hpp"
+#include "parse.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::WorkPool;
+
+using KalaCLI::Core;
+
+using KalaFont::Watch;
+using KalaFont::Batch;
+using KalaFont::ManifestJob;
+using KalaFont::Parse;
+using KalaFont::CompileResult;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ostringstream;
+using std::unordered_map;
+using std::unordered_set;
+using std::move;
+using std::min;
+using std::error_code;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::chrono::milliseconds;
+using std::milli;
+using std::this_thread::sleep_for;
+using std::filesystem::path;
+using std::filesystem::current_path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::is_regular_file;
+using std::filesystem::last_write_time;
+using std::filesystem::file_size;
+using std::filesystem::file_time_type;
+
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Changes are collected until the watched files were quiet for this long,
+//so editors that write a file in several steps cause one recompile
+constexpr u32 DEBOUNCE_MS = 150;
+
+//How often the polling fallback compares the watched files
+constexpr u32 POLL_INTERVAL_MS = 100;
+
+//Last seen version of a watched file
+struct FileStamp
+{
+	file_time_type time{};
+	u64 size{};
+	bool isFound{};
+	
+	bool operator==(const FileStamp&) const = default;
+};
+
+//One manifest job and the absolute paths it reads and writes
+struct WatchJob
+{
+	size_t line{};
+	vector<string> params{};
+	string origin{};
+	string target{};
+};
+
+//Everything the watcher knows about the manifest
+struct WatchState
+{
+	path manifestPath{};
+	path baseDir{};
+	vector<WatchJob> jobs{};
+	unordered_map<string, FileStamp> files{}; //the manifest and every font
+};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"WATCH",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static FileStamp GetStamp(const path& file)
+{
+	error_code ec{};
+	
+	FileStamp stamp{};
+	stamp.time = last_write_time(file, ec);
+	if (ec) return {};
+	
+	stamp.size = file_size(file, ec);
+	if (ec) return {};
+	
+	stamp.isFound = true;
+	return stamp;
+}
+
+//Reads the manifest into jobs, later jobs that write to an earlier target are dropped.
+//Returns false if the manifest could not be read
+static bool LoadJobs(
+	const WatchState& state,
+	vector<WatchJob>& outJobs)
+{
+	vector<ManifestJob> manifestJobs{};
+	if (!Batch::ReadManifest(state.manifestPath, manifestJobs)) return false;
+	
+	unordered_set<string> targets{};
+	
+	for (auto& m : manifestJobs)
+	{
+		if (m.params.empty()) continue;
+		
+		string target = weakly_canonical(state.baseDir / m.params[5]).string();
+		
+		if (!targets.insert(target).second)
+		{
+			PrintError(
+				"Manifest line " + to_string(m.line) + " writes to '" + target
+				+ "' which an earlier job already writes to!");
+			
+			continue;
+		}
+		
+		string origin = weakly_canonical(state.baseDir / m.params[4]).string();
+		
+		outJobs.push_back(WatchJob
+		{
+			.line = m.line,
+			.params = move(m.params),
+			.origin = move(origin),
+			.target = move(target)
+		});
+	}
+	
+	return true;
+}
+
+//Starts tracking the manifest and every font of the current jobs
+static void StampFiles(WatchState& state)
+{
+	unordered_map<string, FileStamp> files{};
+	
+	files[state.manifestPath.string()] = GetStamp(state.manifestPath);
+	for (const auto& j : state.jobs)
+	{
+		if (files.contains(j.origin)) continue;
+		
+		auto known = state.files.find(j.origin);
+		files[j.origin] = known != state.files.end()
+			? known->second
+			: GetStamp(j.origin);
+	}
+	
+	state.files = move(files);
+}
+
+//Compares a watched file with its last seen version, returns true if it changed
+static bool UpdateStamp(
+	WatchState& state,
+	const string& file)
+{
+	auto it = state.files.find(file);
+	if (it == state.files.end()) return false;
+	
+	FileStamp stamp = GetStamp(file);
+	if (stamp == it->second) return false;
+	
+	it->second = stamp;
+	return true;
+}
+
+//Recompiles the jobs on the pool and prints one summary
+static void CompileJobs(
+	const WatchState& state,
+	const vector<size_t>& jobIndices,
+	WorkPool& pool)
+{
+	if (jobIndices.empty()) return;
+	
+	auto start = steady_clock::now();
+	
+	vector<char> isCompiled(jobIndices.size());
+	
+	u32 renderThreads = jobIndices.size() >= pool.GetThreadCount()
+		? 1
+		: pool.GetThreadCount() / static_cast<u32>(jobIndices.size());
+	
+	pool.ParallelFor(
+		jobIndices.size(),
+		1,
+		[&](size_t begin, size_t end, u32)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const WatchJob& j = state.jobs[jobIndices[i]];
+				
+				CompileResult result{};
+				isCompiled[i] = Parse::CompileReplace(j.params, state.baseDir, renderThreads, result);
+			}
+		});
+	
+	f64 elapsedMs = duration<f64, milli>(steady_clock::now() - start).count();
+	
+	u32 compiledCount{};
+	ostringstream failed{};
+	
+	for (size_t i = 0; i < jobIndices.size(); ++i)
+	{
+		if (isCompiled[i])
+		{
+			++compiledCount;
+			continue;
+		}
+		
+		const WatchJob& j = state.jobs[jobIndices[i]];
+		failed << "\n    line " << j.line << ": " << j.params[1] << " " << j.params[2] << " -> " << j.target;
+	}
+	
+	ostringstream summary{};
+	summary << "Recompiled " << compiledCount << " of " << jobIndices.size() << " outputs in "
+		<< elapsedMs << " ms";
+	
+	if (compiledCount < jobIndices.size())
+	{
+		summary << "\n  " << (jobIndices.size() - compiledCount) << " jobs failed:" << failed.str();
+		
+		PrintError(summary.str());
+		
+		return;
+	}
+	
+	Log::Print(
+		summary.str(),
+		"WATCH",
+		LogType::LOG_SUCCESS);
+}
+
+//Picks the jobs the changed files affect, a changed manifest is read again
+//and only its new or edited jobs are recompiled
+static vector<size_t> GetAffectedJobs(
+	WatchState& state,
+	const unordered_set<string>& changed)
+{
+	vector<size_t> affected{};
+	unordered_set<string> changedTargets{};
+	
+	if (changed.contains(state.manifestPath.string()))
+	{
+		vector<WatchJob> jobs{};
+		
+		//a manifest that is being saved can be unreadable for a moment,
+		//the old jobs stay until the next change
+		
+		if (LoadJobs(state, jobs))
+		{
+			unordered_map<string, const WatchJob*> oldJobs{};
+			for (const auto& j : state.jobs) oldJobs[j.target] = &j;
+			
+			for (const auto& j : jobs)
+			{
+				auto old = oldJobs.find(j.target);
+				if (old == oldJobs.end()
+					|| old->second->params != j.params)
+				{
+					changedTargets.insert(j.target);
+				}
+			}
+			
+			state.jobs = move(jobs);
+			StampFiles(state);
+		}
+	}
+	
+	for (size_t i = 0; i < state.jobs.size(); ++i)
+	{
+		if (changed.contains(state.jobs[i].origin)
+			|| changedTargets.contains(state.jobs[i].target))
+		{
+			affected.push_back(i);
+		}
+	}
+	
+	return affected;
+}
+
+#ifdef __linux__
+//Watches the folders of the watched files, editors often save by replacing
+//the file so the folder is watched instead of the file itself
+static void WatchFolders(
+	int inotifyFile,
+	const WatchState& state,
+	unordered_map<int, path>& watchedFolders)
+{
+	unordered_set<string> folders{};
+	for (const auto& [file, stamp] : state.files) folders.insert(path(file).parent_path().string());
+	
+	for (const auto& folder : folders)
+	{
+		int watch = inotify_add_watch(
+			inotifyFile,
+			folder.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB);
+		
+		if (watch < 0)
+		{
+			PrintError("Failed to watch folder '" + folder + "', its fonts are not recompiled on change!");
+			
+			continue;
+		}
+		
+		watchedFolders[watch] = path(folder);
+	}
+}
+
+//Waits for folder events up to timeoutMs, -1 waits until one arrives.
+//Returns true if a watched file changed
+static bool WaitForEvents(
+	int inotifyFile,
+	int timeoutMs,
+	WatchState& state,
+	const unordered_map<int, path>& watchedFolders,
+	unordered_set<string>& outChanged)
+{
+	pollfd request
+	{
+		.fd = inotifyFile,
+		.events = POLLIN,
+		.revents = 0
+	};
+	
+	if (poll(&request, 1, timeoutMs) <= 0) return false;
+	
+	alignas(inotify_event) char buffer[16 * 1024]{};
+	
+	ssize_t length = read(inotifyFile, buffer, sizeof(buffer));
+	if (length <= 0) return false;
+	
+	bool hasChanged{};
+	
+	for (char* p = buffer; p < buffer + length; )
+	{
+		const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+		p += sizeof(inotify_event) + event->len;
+		
+		//the kernel dropped events, so any watched file may have changed unseen
+		if ((event->mask & IN_Q_OVERFLOW) != 0)
+		{
+			PrintError("Watch events were dropped, recompiling every font!");
+			
+			for (auto& [file, stamp] : state.files)
+			{
+				stamp = GetStamp(file);
+				outChanged.insert(file);
+			}
+			
+			hasChanged = true;
+			continue;
+		}
+		
+		if (event->len == 0) continue;
+		
+		auto folder = watchedFolders.find(event->wd);
+		if (folder == watchedFolders.end()) continue;
+		
+		string file = (folder->second / event->name).string();
+		if (!UpdateStamp(state, file)) continue;
+		
+		outChanged.insert(file);
+		hasChanged = true;
+	}
+	
+	return hasChanged;
+}
+#endif
+
+//Compares every watched file with its last seen version, used where inotify is not available.
+//Returns true if a watched file changed
+static bool PollFiles(
+	WatchState& state,
+	unordered_set<string>& outChanged)
+{
+	bool hasChanged{};
+	
+	for (auto& [file, stamp] : state.files)
+	{
+		FileStamp current = GetStamp(file);
+		if (current == stamp) continue;
+		
+		stamp = current;
+		outChanged.insert(file);
+		hasChanged = true;
+	}
+	
+	return hasChanged;
+}
+
+namespace KalaFont
+{
+	void Watch::Command_Watch(const vector<string>& params)
+	{
+		string& currentDir = Core::GetCurrentDir();
+		
+		if (currentDir.empty()) currentDir = current_path().string();
+		
+		WatchState state{};
+		state.manifestPath = weakly_canonical(path(currentDir) / params[1]);
+		state.baseDir = state.manifestPath.parent_path();
+		
+		if (!is_regular_file(state.manifestPath))
+		{
+			PrintError("Failed to watch because manifest '" + state.manifestPath.string() + "' does not exist!");
+			
+			return;
+		}
+		
+		if (!LoadJobs(state, state.jobs)) return;
+		
+		StampFiles(state);
+		
+		//faces and rendered glyphs stay warm between recompiles like with serve
+		
+		Parse::SetResidentCache(Parse::GetResidentCacheSize());
+		
+		WorkPool pool{};
+		
+		vector<size_t> all(state.jobs.size());
+		for (size_t i = 0; i < all.size(); ++i) all[i] = i;
+		
+		CompileJobs(state, all, pool);
+		
+		bool isInotify{};
+
+#ifdef __linux__
+		unordered_map<int, path> watchedFolders{};
+		
+		int inotifyFile = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFile >= 0)
+		{
+			isInotify = true;
+			WatchFolders(inotifyFile, state, watchedFolders);
+		}
+#endif
+		
+		Log::Print(
+			"Watching " + to_string(state.files.size() - 1) + " fonts of manifest '" + state.manifestPath.string()
+			+ "' for changes with " + (isInotify ? "inotify" : "polling"),
+			"WATCH",
+			LogType::LOG_SUCCESS);
+		
+		unordered_set<string> changed{};
+		auto lastChange = steady_clock::now();
+		
+		while (true)
+		{
+			int timeoutMs = static_cast<int>(POLL_INTERVAL_MS);
+			if (!changed.empty())
+			{
+				f64 quiet = duration<f64, milli>(steady_clock::now() - lastChange).count();
+				timeoutMs = static_cast<int>(quiet >= DEBOUNCE_MS ? 0 : DEBOUNCE_MS - quiet);
+			}
+			
+			bool hasChanged{};
+
+#ifdef __linux__
+			if (isInotify)
+			{
+				hasChanged = WaitForEvents(
+					inotifyFile,
+					changed.empty() ? -1 : timeoutMs,
+					state,
+					watchedFolders,
+					changed);
+			}
+#endif
+			if (!isInotify)
+			{
+				sleep_for(milliseconds(min(timeoutMs, static_cast<int>(POLL_INTERVAL_MS))));
+				hasChanged = PollFiles(state, changed);
+			}
+			
+			if (hasChanged)
+			{
+				lastChange = steady_clock::now();
+				continue;
+			}
+			
+			if (changed.empty()
+				|| duration<f64, milli>(steady_clock::now() - lastChange).count() < DEBOUNCE_MS)
+			{
+				continue;
+			}
+			
+			CompileJobs(state, GetAffectedJobs(state, changed), pool);
+			changed.clear();
+
+#ifdef __linux__
+			//a reloaded manifest can list fonts in new folders
+			
+			if (isInotify) WatchFolders(inotifyFile, state, watchedFolders);
+#endif
+		}
+	}
+}
\ No newline at end of file